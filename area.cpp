@@ -10,6 +10,8 @@
     different languages and a series of Measure objects.
 */
 
+#include <algorithm>
+#include <cctype>
 #include <stdexcept>
 #include <regex>
 #include <utility>
@@ -18,6 +20,37 @@
 #include "area.h"
 #include "bethyw.h"
 
+namespace
+{
+    /*
+        Find a key in a map whose keys are all lowercase, without copying the
+        key unless it has uppercase letters.
+
+        @param map
+            The map to search
+
+        @param key
+            The key to find, in any case
+
+        @return
+            An iterator to the entry, or map.end() if there is none
+    */
+    template <typename Map>
+    auto findLowercase(Map &map, const std::string &key) -> decltype(map.find(key))
+    {
+        auto it = map.find(key);
+
+        if (it == map.end() && std::any_of(key.begin(), key.end(), [](unsigned char c) { return std::isupper(c); }))
+        {
+            std::string lowercase = key;
+            BethYw::stringToLower(lowercase);
+            it = map.find(lowercase);
+        }
+
+        return it;
+    }
+}
+
 /*
     Construct an Area with a given local authority code.
 
@@ -27,6 +60,7 @@
 Area::Area(const std::string &localAuthorityCode)
     : localAuthorityCode(localAuthorityCode)
 {
+    updateSearchKeys();
 }
 
 /*
@@ -55,15 +89,32 @@ const std::string Area::getLocalAuthorityCode() const noexcept
 */
 const std::string Area::getName(std::string lang) const
 {
-    BethYw::stringToLower(lang);
-    auto it = names.find(lang);
+    const std::string *name = findName(lang);
 
-    if (it == names.end())
+    if (name == nullptr)
     {
+        BethYw::stringToLower(lang);
         throw std::out_of_range("Area name with the language " + lang + "could not be found!");
     }
     
-    return it->second;
+    return *name;
+}
+
+/*
+    Find a name for the Area in a specific language, without throwing if there
+    isn't one.
+
+    @param lang
+        A three-letter language code in ISO 639-3 format, e.g. cym or eng, in
+        any case
+
+    @return
+        A pointer to the name, or null if there is no name in the language
+*/
+const std::string *Area::findName(const std::string &lang) const noexcept
+{
+    auto it = findLowercase(names, lang);
+    return it == names.end() ? nullptr : &it->second;
 }
 
 /*
@@ -72,7 +123,7 @@ const std::string Area::getName(std::string lang) const
     @return
         A map of all names
 */
-const std::map<std::string, std::string> Area::getNames() const noexcept
+const AreaNames Area::getNames() const noexcept
 {
     return names;
 }
@@ -102,6 +153,38 @@ void Area::setName(std::string lang, const std::string &name)
 
     BethYw::stringToLower(lang);
     names[lang] = name;
+    updateSearchKeys();
+}
+
+/*
+    Retrieve the case folded, accent stripped search keys for this Area, which
+    are its local authority code followed by each of its names. These are
+    computed when the Area is constructed or named, so filters can be compared
+    against them without any further case conversion.
+
+    @return
+        The search keys for the Area
+*/
+const std::vector<std::string>& Area::getSearchKeys() const noexcept
+{
+    return searchKeys;
+}
+
+/*
+    Recompute the search keys from the local authority code and names.
+
+    @return
+        void
+*/
+void Area::updateSearchKeys()
+{
+    searchKeys.clear();
+    searchKeys.push_back(BethYw::foldCase(localAuthorityCode, true));
+
+    for (auto &it : names)
+    {
+        searchKeys.push_back(BethYw::foldCase(it.second, true));
+    }
 }
 
 /*
@@ -119,15 +202,51 @@ void Area::setName(std::string lang, const std::string &name)
 */
 Measure& Area::getMeasure(std::string codename)
 {
-    BethYw::stringToLower(codename);
-    auto it = measures.find(codename);
+    Measure *measure = findMeasure(codename);
 
-    if (it == measures.end())
+    if (measure == nullptr)
     {
+        BethYw::stringToLower(codename);
         throw std::out_of_range("No measure found matching " + codename);
     }
 
-    return it->second;
+    return *measure;
+}
+
+/*
+    Find a Measure object, given its codename, without throwing if there
+    isn't one. As with getMeasure(), the search is case insensitive, but the
+    codename is only copied to convert it to lowercase if it has uppercase
+    letters.
+
+    @param codename
+        The codename for the measure you want to find
+
+    @return
+        A pointer to the Measure, or null if there is no measure with the
+        given code
+*/
+Measure *Area::findMeasure(const std::string &codename) noexcept
+{
+    auto it = findLowercase(measures, codename);
+    return it == measures.end() ? nullptr : &it->second;
+}
+
+/*
+    Find a Measure object, given its codename, without throwing if there
+    isn't one (see above).
+
+    @param codename
+        The codename for the measure you want to find
+
+    @return
+        A pointer to the Measure, or null if there is no measure with the
+        given code
+*/
+const Measure *Area::findMeasure(const std::string &codename) const noexcept
+{
+    auto it = findLowercase(measures, codename);
+    return it == measures.end() ? nullptr : &it->second;
 }
 
 /*
@@ -136,7 +255,7 @@ Measure& Area::getMeasure(std::string codename)
     @return
         A map of all measures
 */
-const std::map<std::string, Measure> Area::getMeasures() const noexcept
+const AreaMeasures Area::getMeasures() const noexcept
 {
     return measures;
 }
@@ -157,14 +276,67 @@ const std::map<std::string, Measure> Area::getMeasures() const noexcept
 void Area::setMeasure(std::string codename, const Measure &measure) noexcept
 {
     BethYw::stringToLower(codename);
-    
-    if (measures.count(codename))
+    auto it = measures.lower_bound(codename);
+
+    if (it != measures.end() && it->first == codename)
     {
-        getMeasure(codename) += measure;
+        it->second += measure;
     }
     else
     {
-        measures.insert(std::make_pair(codename, measure));
+        measures.emplace_hint(it, std::move(codename), measure);
+    }
+}
+
+/*
+    Retrieve a Measure to add values to, creating it if there isn't one with
+    the codename. This has the same effect as setMeasure() with a new Measure,
+    but without constructing and merging a temporary Measure.
+
+    @param codename
+        The codename for the Measure, which must already be lowercase
+
+    @param label
+        The label for the Measure, which replaces any existing label
+
+    @return
+        The Measure
+*/
+Measure& Area::emplaceMeasure(const std::string &codename, const std::string &label)
+{
+    auto it = measures.find(codename);
+
+    if (it == measures.end())
+    {
+        return measures.emplace(codename, Measure(codename, label)).first->second;
+    }
+
+    it->second.setLabel(label);
+    return it->second;
+}
+
+/*
+    Remove all Measure objects from this Area, keeping its names.
+
+    @return
+        void
+*/
+void Area::clearMeasures() noexcept
+{
+    measures.clear();
+}
+
+/*
+    Summarise each Measure of this Area (see Measure::summarise()).
+
+    @return
+        void
+*/
+void Area::summariseMeasures()
+{
+    for (auto &it : measures)
+    {
+        it.second.summarise();
     }
 }
 
@@ -206,14 +378,14 @@ std::ostream& operator<<(std::ostream &os, const Area &area)
     std::string welsh;
 
     // Check for present english and welsh names to format correctly
-    if (area.names.count("eng"))
+    if (const std::string *name = area.findName("eng"))
     {
-        english = area.getName("eng");
+        english = *name;
     }
 
-    if (area.names.count("cym"))
+    if (const std::string *name = area.findName("cym"))
     {
-        welsh = area.getName("cym");
+        welsh = *name;
     }
 
     if (english.length() > 0 && welsh.length() > 0)
@@ -13,11 +13,22 @@
     unique authority code.
  */
 
+#include <functional>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "measure.h"
 
+/*
+    The containers of an Area's names (by language) and Measures (by
+    codename). They use transparent comparators, so they can be searched with
+    anything that compares with a std::string, such as a string literal,
+    without constructing a std::string key.
+*/
+using AreaNames = std::map<std::string, std::string, std::less<>>;
+using AreaMeasures = std::map<std::string, Measure, std::less<>>;
+
 /*
     An Area object consists of a unique authority code, a container for names
     for the area in any number of different languages, and a container for the
@@ -27,18 +38,27 @@ class Area
 {
 private:
     std::string localAuthorityCode;
-    std::map<std::string, std::string> names;
-    std::map<std::string, Measure> measures;
+    AreaNames names;
+    AreaMeasures measures;
+    std::vector<std::string> searchKeys;
+    void updateSearchKeys();
 
 public:
     Area(const std::string &localAuthorityCode);
     const std::string getLocalAuthorityCode() const noexcept;
     const std::string getName(std::string lang) const;
-    const std::map<std::string, std::string> getNames() const noexcept;
+    const std::string *findName(const std::string &lang) const noexcept;
+    const AreaNames getNames() const noexcept;
     void setName(std::string lang, const std::string &name);
+    const std::vector<std::string>& getSearchKeys() const noexcept;
     Measure& getMeasure(std::string codename);
-    const std::map<std::string, Measure> getMeasures() const noexcept;
+    Measure *findMeasure(const std::string &codename) noexcept;
+    const Measure *findMeasure(const std::string &codename) const noexcept;
+    const AreaMeasures getMeasures() const noexcept;
     void setMeasure(std::string codename, const Measure &measure) noexcept;
+    Measure& emplaceMeasure(const std::string &codename, const std::string &label);
+    void clearMeasures() noexcept;
+    void summariseMeasures();
     const size_t size() const noexcept;
     friend std::ostream& operator<<(std::ostream &os, const Area &area);
     friend bool operator==(const Area& lhs, const Area& rhs);
@@ -12,10 +12,19 @@
     various populate() functions) and creating the Area and Measure objects.
 */
 
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
 #include <stdexcept>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
 
@@ -23,517 +32,2199 @@
 
 #include "datasets.h"
 #include "areas.h"
+#include "authorities.h"
 #include "measure.h"
 #include "bethyw.h"
+#include "where.h"
 
 using json = nlohmann::json;
 
+namespace
+{
+    /*
+        The column plan for a row of a StatsWales dataset: pick out the
+        columns of the row from a JSON object. The year and value are left
+        for the converter.
+
+        @param data
+            The JSON object for the row
+
+        @param cols
+            The column mapping for the dataset
+
+        @param row
+            The row to fill
+
+        @return
+            void
+
+        @throws
+            std::out_of_range if there are not enough columns in cols
+    */
+    void planWelshStatsRow(json &data, const BethYw::SourceColumnMapping &cols, ImportRow &row)
+    {
+        try
+        {
+            row.localAuthorityCode = data[cols.at(BethYw::AUTH_CODE)];
+            row.areaName = data[cols.at(BethYw::AUTH_NAME_ENG)];
+            row.named = true;
+
+            // Check measure type and parse
+            if (cols.find(BethYw::MEASURE_CODE) != cols.end())
+            {
+                row.measureCode = data[cols.at(BethYw::MEASURE_CODE)];
+                row.measureName = data[cols.at(BethYw::MEASURE_NAME)];
+            }
+            else 
+            {
+                row.measureCode = cols.at(BethYw::SINGLE_MEASURE_CODE);
+                row.measureName = cols.at(BethYw::SINGLE_MEASURE_NAME);
+            }
+
+            row.hasMeasure = true;
+            row.yearText = data[cols.at(BethYw::YEAR)];
+
+            json &value = data[cols.at(BethYw::VALUE)];
+            row.numeric = value.is_number();
+
+            if (row.numeric)
+            {
+                row.value = value;
+            }
+            else
+            {
+                row.valueText = value;
+            }
+
+            row.hasValue = true;
+        }
+        catch(const std::out_of_range& e)
+        {
+            throw std::out_of_range("Not enough cols!");
+        }
+    }
+
+    /*
+        The callback for the JSON parser that enforces the ParserLimits on
+        nesting, the members of each object and the size of strings, in
+        constant time for each event. Arrays may be as long as the file allows,
+        since the values of a WelshStatsJSON file are one array of rows.
+    */
+    class JSONLimits
+    {
+    private:
+        const BethYw::ParserLimits *limits;
+
+        // The number of members of each object or array being parsed
+        std::vector<size_t> members;
+
+        void checkString(const json &parsed) const
+        {
+            if (parsed.is_string() && parsed.get_ref<const std::string &>().size() > limits->maxFieldSize)
+            {
+                throw BethYw::ParserLimitError("String larger than the limit of "
+                                               + std::to_string(limits->maxFieldSize) + " bytes!");
+            }
+        }
+
+    public:
+        JSONLimits(const BethYw::ParserLimits &limits)
+            : limits(&limits)
+        {
+        }
+
+        bool operator()(int depth, json::parse_event_t event, json &parsed)
+        {
+            switch (event)
+            {
+            case json::parse_event_t::object_start:
+            case json::parse_event_t::array_start:
+                if (members.size() == limits->maxDepth)
+                {
+                    throw BethYw::ParserLimitError("Nesting deeper than the limit of "
+                                                   + std::to_string(limits->maxDepth) + "!");
+                }
+
+                members.push_back(0);
+                break;
+
+            case json::parse_event_t::object_end:
+            case json::parse_event_t::array_end:
+                members.pop_back();
+                break;
+
+            case json::parse_event_t::key:
+                if (++members.back() > limits->maxColumns)
+                {
+                    throw BethYw::ParserLimitError("More members than the limit of "
+                                                   + std::to_string(limits->maxColumns) + "!");
+                }
+
+                checkString(parsed);
+                break;
+
+            case json::parse_event_t::value:
+                checkString(parsed);
+                break;
+            }
+
+            return true;
+        }
+    };
+
+    /*
+        Parse a JSON value within the ParserLimits.
+
+        @param begin
+            The start of the JSON text
+
+        @param end
+            The end of the JSON text
+
+        @param limits
+            The limits on the value
+
+        @return
+            The value
+
+        @throws
+            BethYw::ParserLimitError if the value breaks a limit
+            std::runtime_error if the text is malformed
+    */
+    json parseJSON(const char *begin, const char *end, const BethYw::ParserLimits &limits)
+    {
+        try
+        {
+            return json::parse(begin, end, JSONLimits(limits));
+        }
+        catch(const BethYw::ParserLimitError& e)
+        {
+            throw;
+        }
+        catch(const std::exception& e)
+        {
+            throw std::runtime_error("Malformed file!");
+        }
+    }
+
+    /*
+        Parse the JSON Lines in [begin, end), which must start at the start of a
+        line, appending a row for each. The lines are parsed where they are in
+        memory, without being copied.
+
+        @param begin
+            The start of the lines
+
+        @param end
+            The end of the lines
+
+        @param cols
+            The column mapping for the dataset
+
+        @param rows
+            The rows to append to
+
+        @param limits
+            The limits on each line (see BethYw::ParserLimits)
+
+        @return
+            void
+
+        @throws
+            std::runtime_error if a line is malformed
+            std::out_of_range if there are not enough columns in cols
+            BethYw::ParserLimitError if a line breaks a limit
+    */
+    void parseWelshStatsLines(const char *begin, const char *end,
+                              const BethYw::SourceColumnMapping &cols,
+                              std::vector<ImportRow> &rows,
+                              const BethYw::ParserLimits &limits)
+    {
+        while (begin < end)
+        {
+            const void *newline = std::memchr(begin, '\n', end - begin);
+            const char *lineEnd = newline ? static_cast<const char *>(newline) : end;
+
+            if ((size_t)(lineEnd - begin) > limits.maxLineLength)
+            {
+                throw BethYw::ParserLimitError("Line longer than the limit of "
+                                               + std::to_string(limits.maxLineLength) + " bytes!");
+            }
+
+            if (std::any_of(begin, lineEnd, [](char c) { return !std::isspace((unsigned char)c); }))
+            {
+                json data = parseJSON(begin, lineEnd, limits);
+
+                rows.emplace_back();
+                planWelshStatsRow(data, cols, rows.back());
+            }
+
+            begin = lineEnd + 1;
+        }
+    }
+
+    /*
+        The tokenizer for a StatsWales JSON document: read all the bytes,
+        parse the document and produce each element of its value array.
+    */
+    class WelshStatsValues : public BethYw::RowStream<json>
+    {
+    private:
+        BethYw::RowStreamPtr<std::string> upstream;
+        const BethYw::ParserLimits &limits;
+        json document;
+        json *values = nullptr;
+        size_t index = 0;
+
+    public:
+        WelshStatsValues(BethYw::RowStreamPtr<std::string> upstream, const BethYw::ParserLimits &limits)
+            : upstream(std::move(upstream)), limits(limits)
+        {
+        }
+
+        bool next(json &item) override
+        {
+            if (values == nullptr)
+            {
+                std::string bytes;
+                std::string block;
+
+                while (upstream->next(block))
+                {
+                    bytes += block;
+                }
+
+                document = parseJSON(bytes.data(), bytes.data() + bytes.size(), limits);
+                values = &document["value"];
+            }
+
+            if (!values->is_array() || index >= values->size())
+            {
+                return false;
+            }
+
+            item = std::move((*values)[index++]);
+            return true;
+        }
+    };
+
+    /*
+        The tokenizer and column plan for StatsWales JSON Lines: read all the
+        bytes, split them into one chunk per hardware thread at line breaks,
+        and parse the chunks in parallel (see parseWelshStatsLines). The rows
+        are then produced in file order.
+    */
+    class WelshStatsLines : public BethYw::RowStream<ImportRow>
+    {
+    private:
+        BethYw::RowStreamPtr<std::string> upstream;
+        const BethYw::SourceColumnMapping &cols;
+        const BethYw::ParserLimits &limits;
+        std::vector<std::vector<ImportRow>> chunks;
+        bool parsed = false;
+        size_t chunk = 0;
+        size_t index = 0;
+
+        void parse()
+        {
+            std::string buffer;
+            std::string block;
+
+            while (upstream->next(block))
+            {
+                buffer += block;
+            }
+
+            const char *data = buffer.data();
+            const size_t size = buffer.size();
+
+            // Split into chunks of at least 1MB, moving each split to after a newline
+            const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+            const size_t threads = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(),
+                                                                        size / MIN_CHUNK_SIZE));
+            std::vector<size_t> splits = {0};
+
+            for (size_t t = 1; t < threads; t++)
+            {
+                size_t split = std::max(splits.back(), size * t / threads);
+                const void *newline = std::memchr(data + split, '\n', size - split);
+                splits.push_back(newline ? static_cast<const char *>(newline) - data + 1 : size);
+            }
+            splits.push_back(size);
+
+            chunks.resize(threads);
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> workers;
+
+            for (size_t t = 0; t < threads; t++)
+            {
+                auto parseChunk = [&, t]() {
+                    try
+                    {
+                        parseWelshStatsLines(data + splits[t], data + splits[t + 1], cols, chunks[t], limits);
+                    }
+                    catch(...)
+                    {
+                        errors[t] = std::current_exception();
+                    }
+                };
+
+                if (t + 1 < threads)
+                {
+                    workers.emplace_back(parseChunk);
+                }
+                else
+                {
+                    parseChunk();
+                }
+            }
+
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+
+            // Report the first error in the file
+            for (auto &error : errors)
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+    public:
+        WelshStatsLines(BethYw::RowStreamPtr<std::string> upstream, const BethYw::SourceColumnMapping &cols,
+                        const BethYw::ParserLimits &limits)
+            : upstream(std::move(upstream)), cols(cols), limits(limits)
+        {
+        }
+
+        bool next(ImportRow &row) override
+        {
+            if (!parsed)
+            {
+                parsed = true;
+                parse();
+            }
+
+            while (chunk < chunks.size() && index >= chunks[chunk].size())
+            {
+                std::vector<ImportRow>().swap(chunks[chunk]);
+                chunk++;
+                index = 0;
+            }
+
+            if (chunk >= chunks.size())
+            {
+                return false;
+            }
+
+            row = std::move(chunks[chunk][index++]);
+            return true;
+        }
+    };
+
+    /*
+        Read the header line of a CSV file.
+
+        @param lines
+            The lines of the file, of which the first is read
+
+        @param limits
+            The limits on the columns (see BethYw::ParserLimits)
+
+        @return
+            The column headers
+
+        @throws
+            std::runtime_error if the file is empty
+            BethYw::ParserLimitError if the header breaks a limit
+    */
+    std::vector<std::string> readHeader(BethYw::RowStream<std::string> &lines, const BethYw::ParserLimits &limits)
+    {
+        std::string line;
+
+        if (!lines.next(line))
+        {
+            throw std::runtime_error("Malformed file!");
+        }
+
+        return BethYw::splitFields(line, limits);
+    }
+
+    /*
+        Merge run files, and optionally the Areas still in memory, calling
+        `callback` with each Area in order of local authority code (a k-way
+        merge). Later runs take precedence in the same way as
+        Areas::setArea(), and the Areas in memory over every run, so only one
+        Area from each run is held in memory at a time.
+
+        @param paths
+            The run files, in the order they were written
+
+        @param areas
+            The Areas in memory
+
+        @param inMemory
+            Whether to merge the Areas in memory as well as the runs
+
+        @param callback
+            The function to call with each Area
+
+        @return
+            void
+
+        @throws
+            std::runtime_error if a run file cannot be read
+    */
+    void mergeRuns(const std::vector<std::string> &paths, const AreasContainer &areas, const bool inMemory,
+                   const std::function<void(const Area &)> &callback)
+    {
+        std::vector<std::unique_ptr<std::ifstream>> files;
+        std::vector<std::unique_ptr<Area>> heads;
+
+        for (auto &path : paths)
+        {
+            files.emplace_back(new std::ifstream(path, std::ios::binary));
+
+            if (!files.back()->is_open())
+            {
+                throw std::runtime_error("Areas::forEachArea: Failed to open run file " + path);
+            }
+
+            heads.push_back(BethYw::readArea(*files.back()));
+        }
+
+        // The keys of the Areas at the head of each run
+        std::vector<BethYw::GssCode> headCodes(heads.size());
+        for (size_t i = 0; i < heads.size(); i++)
+        {
+            if (heads[i])
+            {
+                headCodes[i] = BethYw::GssCode(heads[i]->getLocalAuthorityCode());
+            }
+        }
+
+        auto memory = areas.begin();
+        const auto end = inMemory ? areas.end() : areas.begin();
+
+        while (true)
+        {
+            // Find the smallest local authority code at the head of any source
+            bool found = false;
+            BethYw::GssCode smallest;
+
+            for (size_t i = 0; i < heads.size(); i++)
+            {
+                if (heads[i] && (!found || headCodes[i] < smallest))
+                {
+                    smallest = headCodes[i];
+                    found = true;
+                }
+            }
+
+            if (memory != end && (!found || memory->first < smallest))
+            {
+                smallest = memory->first;
+                found = true;
+            }
+
+            if (!found)
+            {
+                break;
+            }
+
+            // Merge that Area from every source in order, and advance them
+            std::unique_ptr<Area> merged;
+
+            for (size_t i = 0; i < heads.size(); i++)
+            {
+                if (heads[i] && headCodes[i] == smallest)
+                {
+                    if (merged)
+                    {
+                        *merged += *heads[i];
+                    }
+                    else
+                    {
+                        merged = std::move(heads[i]);
+                    }
+
+                    heads[i] = BethYw::readArea(*files[i]);
+
+                    if (heads[i])
+                    {
+                        headCodes[i] = BethYw::GssCode(heads[i]->getLocalAuthorityCode());
+                    }
+                }
+            }
+
+            if (memory != end && memory->first == smallest)
+            {
+                if (merged)
+                {
+                    *merged += memory->second;
+                }
+                else
+                {
+                    merged.reset(new Area(memory->second));
+                }
+
+                memory++;
+            }
+
+            callback(*merged);
+        }
+    }
+}
+
+/*
+    Construct an empty RowBatch, with room for CAPACITY rows.
+*/
+RowBatch::RowBatch()
+{
+    codeIds.reserve(CAPACITY);
+    measureIds.reserve(CAPACITY);
+    years.reserve(CAPACITY);
+    values.reserve(CAPACITY);
+}
+
+/*
+    Get the id of a local authority code without a name, adding it to the
+    dictionary if needed.
+
+    @param code
+        The local authority code
+
+    @return
+        The id of the code
+*/
+uint32_t RowBatch::internCode(const std::string &code)
+{
+    auto it = codeIndex.find(code);
+
+    if (it != codeIndex.end())
+    {
+        return it->second;
+    }
+
+    const uint32_t id = codes.size();
+    codes.push_back(code);
+    names.push_back("");
+    named.push_back(false);
+    codeIndex.emplace(code, id);
+
+    return id;
+}
+
+/*
+    Get the id of a local authority code with an English name, adding it to
+    the dictionary if needed.
+
+    @param code
+        The local authority code
+
+    @param name
+        The English name of the area in this row
+
+    @return
+        The id of the code and name
+*/
+uint32_t RowBatch::internCode(const std::string &code, const std::string &name)
+{
+    const std::string key = code + '\0' + name;
+    auto it = codeIndex.find(key);
+
+    if (it == codeIndex.end())
+    {
+        const uint32_t id = codes.size();
+        codes.push_back(code);
+        names.push_back(name);
+        named.push_back(true);
+        it = codeIndex.emplace(key, id).first;
+    }
+
+    return it->second;
+}
+
+/*
+    Get the id of a measure codename and label, adding it to the dictionary
+    if needed.
+
+    @param codename
+        The codename of the measure, which is converted to lowercase
+
+    @param label
+        The label of the measure in this row
+
+    @return
+        The id of the codename and label
+*/
+uint32_t RowBatch::internMeasure(std::string codename, const std::string &label)
+{
+    BethYw::stringToLower(codename);
+    const std::string key = codename + '\0' + label;
+    auto it = measureIndex.find(key);
+
+    if (it != measureIndex.end())
+    {
+        return it->second;
+    }
+
+    const uint32_t id = measureCodes.size();
+    measureCodes.push_back(codename);
+    measureLabels.push_back(label);
+    measureIndex.emplace(key, id);
+
+    return id;
+}
+
+/*
+    Add a row to the batch.
+
+    @param codeId
+        The id from internCode()
+
+    @param measureId
+        The id from internMeasure(), or NO_MEASURE
+
+    @param year
+        The year, or NO_YEAR
+
+    @param value
+        The value, which is ignored if there is no measure or year
+
+    @return
+        void
+*/
+void RowBatch::add(const uint32_t codeId, const uint32_t measureId, const unsigned int year, const double value)
+{
+    codeIds.push_back(codeId);
+    measureIds.push_back(measureId);
+    years.push_back(year);
+    values.push_back(value);
+}
+
+/*
+    Retrieve the number of rows in the batch.
+
+    @return
+        The number of rows
+*/
+const size_t RowBatch::size() const noexcept
+{
+    return codeIds.size();
+}
+
+/*
+    Check whether the batch has reached CAPACITY rows.
+
+    @return
+        true if the batch should be applied
+*/
+const bool RowBatch::full() const noexcept
+{
+    return codeIds.size() >= CAPACITY;
+}
+
+/*
+    Remove every row and dictionary entry.
+
+    @return
+        void
+*/
+void RowBatch::clear() noexcept
+{
+    codeIds.clear();
+    measureIds.clear();
+    years.clear();
+    values.clear();
+    codes.clear();
+    names.clear();
+    named.clear();
+    measureCodes.clear();
+    measureLabels.clear();
+    codeIndex.clear();
+    measureIndex.clear();
+}
+
+/*
+    Construct the filters for a single import, folding the string filters
+    once up front.
+
+    @param areasFilter
+        A pointer to the areas filter, which may be null
+
+    @param measuresFilter
+        A pointer to the measures filter, which may be null
+
+    @param yearsFilter
+        The compiled years filter
+*/
+ImportFilter::ImportFilter(const StringFilterSet *const areasFilter,
+                           const StringFilterSet *const measuresFilter,
+                           const BethYw::YearFilter &yearsFilter)
+    : areas(BethYw::foldStringSet(areasFilter)),
+      measures(BethYw::foldStringSet(measuresFilter)),
+      years(yearsFilter)
+{
+}
+
+/*
+    Constructor for an Areas object.
+*/
+Areas::Areas()
+{
+}
+
+/*
+    Add a particular Area to the Areas object.
+
+    If an Area already exists with the same local authority code, overwrite all
+    data contained within the existing Area with those in the new
+    Area (i.e. they should be combined, but the new Area's data should take
+    precedence, e.g. replace a name with the same language identifier).
+
+    @param localAuthorityCode
+        The local authority code of the Area
+
+    @param area
+        The Area object that will contain the Measure objects
+
+    @return
+        void
+*/
+void Areas::setArea(const std::string &localAuthorityCode, const Area &area) noexcept
+{
+    Area *existing = findArea(localAuthorityCode);
+
+    if (existing != nullptr)
+    {
+        *existing += area;
+    }
+    else
+    {
+        existing = &areas.emplace(BethYw::GssCode(localAuthorityCode), area).first->second;
+    }
+
+    if (statsOnly)
+    {
+        existing->summariseMeasures();
+    }
+}
+
+/*
+    Retrieve an Area instance with a given local authority code.
+
+    @param localAuthorityCode
+        The local authority code to find the Area instance of
+
+    @return
+        An Area object
+
+    @throws
+        std::out_of_range if an Area with the set local authority code does not
+        exist in this Areas instance
+*/
+Area& Areas::getArea(const std::string &localAuthorityCode)
+{
+    Area *area = findArea(localAuthorityCode);
+
+    if (area == nullptr)
+    {
+        throw std::out_of_range("No area found matching " + localAuthorityCode);
+    }
+
+    return *area;
+}
+
+/*
+    Find an Area with a given local authority code, without throwing if there
+    isn't one.
+
+    @param localAuthorityCode
+        The local authority code to find the Area instance of
+
+    @return
+        A pointer to the Area, or null if there is no Area with the code
+*/
+Area *Areas::findArea(const std::string &localAuthorityCode) noexcept
+{
+    BethYw::GssCode key;
+
+    if (!BethYw::GssCode::find(localAuthorityCode, key))
+    {
+        return nullptr;
+    }
+
+    auto it = areas.find(key);
+    return it == areas.end() ? nullptr : &it->second;
+}
+
+/*
+    Find an Area with a given local authority code, without throwing if there
+    isn't one (see above).
+
+    @param localAuthorityCode
+        The local authority code to find the Area instance of
+
+    @return
+        A pointer to the Area, or null if there is no Area with the code
+*/
+const Area *Areas::findArea(const std::string &localAuthorityCode) const noexcept
+{
+    BethYw::GssCode key;
+
+    if (!BethYw::GssCode::find(localAuthorityCode, key))
+    {
+        return nullptr;
+    }
+
+    auto it = areas.find(key);
+    return it == areas.end() ? nullptr : &it->second;
+}
+
+/*
+    Retrieve the number of Areas within the container.
+
+    @return
+        The number of Area instances
+*/
+const size_t Areas::size() const noexcept
+{
+    return areas.size();
+}
+
+/*
+    This function specifically parses the compiled areas.csv file of local 
+    authority codes, and their names in English and Welsh.
+
+    This is a simple dataset that is a comma-separated values file (CSV), where
+    the first row gives the name of the columns, and then each row is a set of
+    data.
+
+    @param is
+        The input stream from InputSource
+
+    @param cols
+        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+        that give the column header in the CSV file
+
+    @param areasFilter
+        An umodifiable pointer to set of umodifiable strings for areas to import,
+        or an empty set if all areas should be imported
+
+    @return
+        void
+
+    @throws 
+        std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+        std::out_of_range if there are not enough columns in cols
+*/
+void Areas::populateFromAuthorityCodeCSV(std::istream &is, const BethYw::SourceColumnMapping &cols, const StringFilterSet *const areasFilter)
+{
+    using namespace BethYw;
+
+    auto lines = RowStreamPtr<std::string>(new LineSplitter(RowStreamPtr<std::string>(new ByteSource(is)),
+                                                            limits.maxLineLength));
+    const std::vector<std::string> fileCols = readHeader(*lines, limits);
+
+    // If the cols passed in dont match the parsed cols invalid file
+    if (fileCols.size() != cols.size()) 
+    {
+        throw std::out_of_range("Cols length mismatch!");
+    }
+
+    const FoldedFilter foldedAreasFilter = foldStringSet(areasFilter);
+    using AreaPtr = std::unique_ptr<Area>;
+
+    // Column plan: build an Area from each line
+    auto areaRows = addStage<std::string, AreaPtr>(std::move(lines), [this](std::string &line, std::vector<AreaPtr> &out) {
+        const std::vector<std::string> areaData = splitFields(line, limits);
+
+        if (areaData.size() < 3)
+        {
+            throw std::runtime_error("Malformed file!");
+        }
+
+        AreaPtr area(new Area(areaData[0]));
+        area->setName("eng", areaData[1]);
+        area->setName("cym", areaData[2]);
+        out.push_back(std::move(area));
+    });
+
+    // Filter
+    areaRows = addStage<AreaPtr, AreaPtr>(std::move(areaRows), [&](AreaPtr &area, std::vector<AreaPtr> &out) {
+        if (inShard(area->getLocalAuthorityCode()) && checkFilter(foldedAreasFilter, area->getSearchKeys()))
+        {
+            out.push_back(std::move(area));
+        }
+    });
+
+    ThreadedStage<AreaPtr> areasToSet(std::move(areaRows));
+    AreaPtr area;
+
+    while (areasToSet.next(area))
+    {
+        setArea(area->getLocalAuthorityCode(), *area);
+        maybeSpill();
+    }
+}
+
+/*
+    Import local authorities from a table rather than parsing areas.csv, e.g.
+    the table embedded when the program was built (see authorities.h). The
+    result is the same as populateFromAuthorityCodeCSV() with the file the
+    table was generated from.
+
+    @param authorities
+        The table of local authorities
+
+    @param count
+        The number of local authorities in the table
+
+    @param areasFilter
+        An umodifiable pointer to set of umodifiable strings for areas to import,
+        or an empty set if all areas should be imported
+
+    @return
+        void
+*/
+void Areas::populateFromAuthorities(const BethYw::Authority *const authorities,
+                                    const size_t count,
+                                    const StringFilterSet *const areasFilter)
+{
+    const FoldedFilter foldedAreasFilter = BethYw::foldStringSet(areasFilter);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        Area area(authorities[i].code);
+        area.setName("eng", authorities[i].eng);
+        area.setName("cym", authorities[i].cym);
+
+        if (inShard(area.getLocalAuthorityCode()) && checkFilter(foldedAreasFilter, area.getSearchKeys()))
+        {
+            setArea(area.getLocalAuthorityCode(), area);
+            maybeSpill();
+        }
+    }
+}
+
+/*
+    Data from StatsWales is in the JSON format, and contains three
+    top-level keys: odata.metadata, value, odata.nextLink. value contains the
+    data we need.
+
+    If areasFilter is a non-empty set only include areas matching the filter. If
+    measuresFilter is a non-empty set only include measures matching the filter.
+    If yearsFilter is not equal to <0,0>, only import years within the range
+    specified by the tuple (inclusive).
+
+    @param is
+        The input stream from InputSource
+
+    @param cols
+        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+        that give the column header in the CSV file
+
+    @param areasFilter
+        An umodifiable pointer to set of umodifiable strings of areas to import,
+        or an empty set if all areas should be imported
+
+    @param measuresFilter
+        An umodifiable pointer to set of umodifiable strings of measures to import,
+        or an empty set if all measures should be imported
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @return
+        void
+
+    @throws 
+        std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+        std::out_of_range if there are not enough columns in cols
+*/
+void Areas::populateFromWelshStatsJSON(std::istream &is, 
+                                       const BethYw::SourceColumnMapping &cols, 
+                                       const StringFilterSet *const areasFilter, 
+                                       const StringFilterSet *const measuresFilter,
+                                       const BethYw::YearFilter &yearsFilter)
+{
+    using namespace BethYw;
+
+    ImportFilter filter(areasFilter, measuresFilter, yearsFilter);
+    snapshotAreaNames(filter);
+
+    auto bytes = RowStreamPtr<std::string>(new ThreadedStage<std::string>(
+        RowStreamPtr<std::string>(new ByteSource(is))));
+    auto values = RowStreamPtr<json>(new WelshStatsValues(std::move(bytes), limits));
+    auto rows = addStage<json, ImportRow>(std::move(values), [&cols](json &data, std::vector<ImportRow> &out) {
+        out.emplace_back();
+        planWelshStatsRow(data, cols, out.back());
+    });
+
+    importRows(std::move(rows), filter);
+}
+
+/*
+    Import StatsWales data in the JSON format, with the years filter given as a
+    single inclusive range (see the overload above).
+*/
+void Areas::populateFromWelshStatsJSON(std::istream &is,
+                                       const BethYw::SourceColumnMapping &cols,
+                                       const StringFilterSet *const areasFilter,
+                                       const StringFilterSet *const measuresFilter,
+                                       const YearFilterTuple *const yearsFilter)
+{
+    populateFromWelshStatsJSON(is, cols, areasFilter, measuresFilter, BethYw::YearFilter(yearsFilter));
+}
+
+/*
+    StatsWales data in the JSON Lines format has one object per line, each
+    the same as an element of the value array in the JSON format (see
+    populateFromWelshStatsJSON). Blank lines are ignored.
+
+    Unlike a single JSON document, this can be split at line breaks and parsed
+    in parallel. The stream is read into memory, split into one chunk per
+    hardware thread at line breaks, and each thread parses the lines of its
+    chunk in place. The rows are then imported in file order, so the result
+    is the same as parsing the lines one after another.
+
+    @param is
+        The input stream from InputSource
+
+    @param cols
+        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+        that give the column header in the CSV file
+
+    @param areasFilter
+        An umodifiable pointer to set of umodifiable strings of areas to import,
+        or an empty set if all areas should be imported
+
+    @param measuresFilter
+        An umodifiable pointer to set of umodifiable strings of measures to import,
+        or an empty set if all measures should be imported
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @return
+        void
+
+    @throws 
+        std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+        std::out_of_range if there are not enough columns in cols
+*/
+void Areas::populateFromWelshStatsJSONL(std::istream &is, 
+                                        const BethYw::SourceColumnMapping &cols, 
+                                        const StringFilterSet *const areasFilter, 
+                                        const StringFilterSet *const measuresFilter,
+                                        const BethYw::YearFilter &yearsFilter)
+{
+    using namespace BethYw;
+
+    ImportFilter filter(areasFilter, measuresFilter, yearsFilter);
+    snapshotAreaNames(filter);
+
+    auto bytes = RowStreamPtr<std::string>(new ThreadedStage<std::string>(
+        RowStreamPtr<std::string>(new ByteSource(is))));
+    auto rows = RowStreamPtr<ImportRow>(new WelshStatsLines(std::move(bytes), cols, limits));
+
+    importRows(std::move(rows), filter);
+}
+
+/*
+    Import StatsWales data in the JSON Lines format, with the years filter given as a
+    single inclusive range (see the overload above).
+*/
+void Areas::populateFromWelshStatsJSONL(std::istream &is,
+                                        const BethYw::SourceColumnMapping &cols,
+                                        const StringFilterSet *const areasFilter,
+                                        const StringFilterSet *const measuresFilter,
+                                        const YearFilterTuple *const yearsFilter)
+{
+    populateFromWelshStatsJSONL(is, cols, areasFilter, measuresFilter, BethYw::YearFilter(yearsFilter));
+}
+
+/*
+    Copy the folded names of the existing Areas into an import's filters, if
+    there is an area filter (see ImportFilter).
+
+    @param filter
+        The filters for this import
+
+    @return
+        void
+*/
+void Areas::snapshotAreaNames(ImportFilter &filter) const
+{
+    if (filter.areas.empty())
+    {
+        return;
+    }
+
+    for (auto &it : areas)
+    {
+        auto &names = filter.areaNames[it.second.getLocalAuthorityCode()];
+
+        for (auto &name : it.second.getNames())
+        {
+            names[name.first] = BethYw::foldCase(name.second, true);
+        }
+    }
+}
+
+/*
+    The filter stage of an import pipeline. A row is dropped if its area is
+    outside the shard or does not pass the area filter, and keeps its area
+    but not its measure if the measure does not pass the measure filter.
+    This only reads the filters, never the Areas, so it is safe to run while
+    rows are being imported.
+
+    @param row
+        The row to filter
+
+    @param out
+        The rows to pass on
+
+    @param filter
+        The filters for this import
+
+    @return
+        void
+*/
+void Areas::filterRow(ImportRow &row, std::vector<ImportRow> &out, ImportFilter &filter) const
+{
+    if (!inShard(row.localAuthorityCode)
+        || !checkAreaFilter(filter, row.localAuthorityCode, row.named ? row.areaName : ""))
+    {
+        return;
+    }
+
+    row.hasMeasure = row.hasMeasure && checkMeasureFilter(filter.measures, row.measureCode, filter.measureCache);
+    out.push_back(std::move(row));
+}
+
+/*
+    The converter stage of an import pipeline, which parses the year and
+    value of each row with a measure and checks the year against the filter.
+    Rows without a measure are not converted.
+
+    @param row
+        The row to convert
+
+    @param out
+        The rows to pass on
+
+    @param filter
+        The filters for this import
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if the year or value cannot be converted
+*/
+void Areas::convertRow(ImportRow &row, std::vector<ImportRow> &out, const ImportFilter &filter) const
+{
+    if (row.hasMeasure && row.hasValue)
+    {
+        try 
+        {
+            row.year = std::stoul(row.yearText);
+
+            if (!row.numeric)
+            {
+                row.value = std::stod(row.valueText);
+            }
+        }
+        catch(const std::invalid_argument& e)
+        {
+            throw std::runtime_error("Malformed file!");
+        }
+
+        row.hasYear = filter.years.contains(row.year);
+    }
+
+    out.push_back(std::move(row));
+}
+
+/*
+    Run the filter and converter stages on the rows of an import, each on its
+    own thread, and import the rows that come out in batches (the sink). If a
+    stage throws, the rows before the error are still imported.
+
+    @param rows
+        The rows from the column plan of the import
+
+    @param filter
+        The filters for this import
+
+    @return
+        void
+
+    @throws
+        Any exception thrown by a stage
+*/
+void Areas::importRows(BethYw::RowStreamPtr<ImportRow> rows, ImportFilter &filter)
+{
+    using namespace BethYw;
+
+    rows = addStage<ImportRow, ImportRow>(std::move(rows), [&](ImportRow &row, std::vector<ImportRow> &out) {
+        filterRow(row, out, filter);
+    });
+    rows = addStage<ImportRow, ImportRow>(std::move(rows), [&](ImportRow &row, std::vector<ImportRow> &out) {
+        convertRow(row, out, filter);
+    });
+
+    ThreadedStage<ImportRow> converted(std::move(rows));
+    RowBatch batch;
+    ImportRow row;
+
+    try
+    {
+        while (converted.next(row))
+        {
+            const uint32_t codeId = row.named ? batch.internCode(row.localAuthorityCode, row.areaName)
+                                              : batch.internCode(row.localAuthorityCode);
+            const uint32_t measureId = row.hasMeasure ? batch.internMeasure(row.measureCode, row.measureName)
+                                                      : RowBatch::NO_MEASURE;
+
+            batch.add(codeId, measureId, row.hasYear ? row.year : RowBatch::NO_YEAR, row.value);
+
+            if (batch.full())
+            {
+                applyBatch(batch);
+            }
+        }
+    }
+    catch(...)
+    {
+        // Keep the rows before the error, as when they were applied one by one
+        applyBatch(batch);
+        throw;
+    }
+
+    applyBatch(batch);
+}
+
+/*
+    Apply a batch of rows and clear it. The rows are sorted by local
+    authority code, measure codename and year, keeping rows with the same key
+    in the order they were added, and then each Area and Measure is found or
+    created once and its values are set in order. The result is the same as
+    applying each row with setArea().
+
+    @param batch
+        The batch to apply
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if a run file cannot be written in external-memory
+        mode
+*/
+void Areas::applyBatch(RowBatch &batch)
+{
+    const size_t rows = batch.size();
+
+    if (rows == 0)
+    {
+        return;
+    }
+
+    if (predicate)
+    {
+        predicate->apply(batch);
+    }
+
+    // Rank the dictionary entries so rows can be sorted on a single integer
+    auto rank = [](const auto &keys) {
+        std::vector<uint32_t> order(keys.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            order[i] = i;
+        }
+
+        std::sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) {
+            return keys[a] < keys[b];
+        });
+
+        std::vector<uint32_t> ranks(keys.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+        {
+            // Entries with the same key (e.g. a code with two names) share a rank
+            ranks[order[i]] = i > 0 && keys[order[i]] == keys[order[i - 1]] ? ranks[order[i - 1]] : i;
+        }
+
+        return ranks;
+    };
+
+    std::vector<BethYw::GssCode> codeKeys;
+    codeKeys.reserve(batch.codes.size());
+    for (auto &code : batch.codes)
+    {
+        codeKeys.emplace_back(code);
+    }
+
+    const std::vector<uint32_t> codeRanks = rank(codeKeys);
+    const std::vector<uint32_t> measureRanks = rank(batch.measureCodes);
+
+    std::vector<uint64_t> keys(rows);
+    std::vector<uint32_t> order(rows);
+
+    for (uint32_t i = 0; i < rows; i++)
+    {
+        const uint64_t measureRank = batch.measureIds[i] == RowBatch::NO_MEASURE
+                                         ? 0xFFFF : measureRanks[batch.measureIds[i]];
+        keys[i] = ((uint64_t)codeRanks[batch.codeIds[i]] << 48) | (measureRank << 32) | batch.years[i];
+        order[i] = i;
+    }
+
+    BethYw::radixSortOrder(keys, order);
+
+    auto hint = areas.begin();
+    size_t i = 0;
+
+    while (i < rows)
+    {
+        const uint32_t codeId = batch.codeIds[order[i]];
+        const BethYw::GssCode &code = codeKeys[codeId];
+        const uint64_t codeKey = keys[order[i]] >> 48;
+
+        // The codes are in order, so the Area is usually at the hint
+        auto it = hint;
+        if (it == areas.end() || it->first != code)
+        {
+            it = areas.lower_bound(code);
+
+            if (it == areas.end() || it->first != code)
+            {
+                it = areas.emplace_hint(it, code, Area(batch.codes[codeId]));
+            }
+        }
+
+        Area &area = it->second;
+        hint = std::next(it);
+
+        // The name of the last row added for this Area takes precedence
+        bool hasName = false;
+        uint32_t nameRow = 0;
+
+        while (i < rows && keys[order[i]] >> 48 == codeKey)
+        {
+            const uint64_t measureKey = keys[order[i]] >> 32;
+            const uint32_t measureId = batch.measureIds[order[i]];
+            uint32_t labelRow = order[i];
+            Measure *measure = nullptr;
+
+            for (size_t j = i; j < rows && keys[order[j]] >> 32 == measureKey; j++)
+            {
+                labelRow = std::max(labelRow, order[j]);
+            }
+
+            if (measureId != RowBatch::NO_MEASURE)
+            {
+                measure = &area.emplaceMeasure(batch.measureCodes[measureId],
+                                               batch.measureLabels[batch.measureIds[labelRow]]);
+            }
+
+            for (; i < rows && keys[order[i]] >> 32 == measureKey; i++)
+            {
+                const uint32_t row = order[i];
+
+                if (batch.named[batch.codeIds[row]] && (!hasName || row > nameRow))
+                {
+                    hasName = true;
+                    nameRow = row;
+                }
+
+                if (measure != nullptr && batch.years[row] != RowBatch::NO_YEAR)
+                {
+                    measure->setValue(batch.years[row], batch.values[row]);
+                }
+            }
+        }
+
+        if (hasName)
+        {
+            area.setName("eng", batch.names[batch.codeIds[nameRow]]);
+        }
+
+        if (statsOnly)
+        {
+            area.summariseMeasures();
+        }
+    }
+
+    batch.clear();
+    maybeSpill(rows);
+}
+
+/*
+    This function imports CSV files that contain a single measure. The 
+    CSV file consists of columns containing the authority code and years.
+    Each row contains an authority code and values for each year (or no value
+    if the data doesn't exist).
+
+    @param is
+        The input stream from InputSource
+
+    @param cols
+        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+        that give the column header in the CSV file
+
+    @param areasFilter
+        An umodifiable pointer to set of umodifiable strings for areas to import,
+        or an empty set if all areas should be imported
+
+    @param measuresFilter
+        An umodifiable pointer to set of strings for measures to import, or an empty 
+        set if all measures should be imported
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @return
+        void
+
+    @throws 
+        std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+        std::out_of_range if there are not enough columns in cols
+*/
+void Areas::populateFromAuthorityByYearCSV(std::istream &is, const BethYw::SourceColumnMapping &cols, 
+                                           const StringFilterSet *const areasFilter, 
+                                           const StringFilterSet *const measuresFilter, 
+                                           const BethYw::YearFilter &yearsFilter)
+{
+    using namespace BethYw;
+
+    auto lines = RowStreamPtr<std::string>(new LineSplitter(RowStreamPtr<std::string>(new ByteSource(is)),
+                                                            limits.maxLineLength));
+    const std::vector<std::string> fileCols = readHeader(*lines, limits);
+
+    if (cols.size() != 3)
+    {
+        throw std::out_of_range("Cols length mismatch!");
+    }
+
+    if (fileCols.empty() || fileCols[0] != cols.at(AUTH_CODE))
+    {
+        throw std::runtime_error("Malformed file!");
+    }
+
+    ImportFilter filter(areasFilter, measuresFilter, yearsFilter);
+    snapshotAreaNames(filter);
+
+    // Project the years filter onto the columns once for the whole file, so
+    // the values of years that are filtered out are never converted
+    std::vector<bool> keepCols(fileCols.size(), true);
+    for (size_t i = 1; i < fileCols.size(); i++)
+    {
+        try
+        {
+            keepCols[i] = filter.years.contains(std::stoul(fileCols[i]));
+        }
+        catch(const std::exception &e)
+        {
+            // Not a year, so keep the column for the converter to reject
+        }
+    }
+
+    // Column plan: a row for each kept year of each line, or a single row
+    // without a year if the line has none
+    const std::string &measureCode = cols.at(SINGLE_MEASURE_CODE);
+    const std::string &measureName = cols.at(SINGLE_MEASURE_NAME);
+
+    auto rows = addStage<std::string, ImportRow>(std::move(lines), [&](std::string &line, std::vector<ImportRow> &out) {
+        const std::vector<std::string> data = splitFields(line, limits);
+
+        if (data.empty() || data.size() > fileCols.size())
+        {
+            throw std::runtime_error("Malformed file!");
+        }
+
+        ImportRow row;
+        row.localAuthorityCode = data[0];
+        row.measureCode = measureCode;
+        row.measureName = measureName;
+        row.hasMeasure = true;
+
+        row.hasValue = true;
+
+        for (size_t i = 1; i < data.size(); i++)
+        {
+            if (keepCols[i])
+            {
+                row.yearText = fileCols[i];
+                row.valueText = data[i];
+                out.push_back(row);
+            }
+        }
+
+        // The Area and Measure are still created if no year is kept
+        if (out.empty())
+        {
+            row.hasValue = false;
+            out.push_back(row);
+        }
+    });
+
+    importRows(std::move(rows), filter);
+}
+
+/*
+    Import CSV files that contain a single measure, with the years filter given as a
+    single inclusive range (see the overload above).
+*/
+void Areas::populateFromAuthorityByYearCSV(std::istream &is,
+                                           const BethYw::SourceColumnMapping &cols,
+                                           const StringFilterSet *const areasFilter,
+                                           const StringFilterSet *const measuresFilter,
+                                           const YearFilterTuple *const yearsFilter)
+{
+    populateFromAuthorityByYearCSV(is, cols, areasFilter, measuresFilter, BethYw::YearFilter(yearsFilter));
+}
+
+/*
+    Parse data from an standard input stream `is`, that has data of a particular
+    `type`, and with a given column mapping in `cols`.
+
+    @param is
+        The input stream from InputSource
+
+    @param type
+        A value from the BethYw::SourceDataType enum which states the underlying
+        data file structure
+
+    @param cols
+        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+        that give the column header in the CSV file
+
+    @return
+        void
+
+    @throws 
+        std::runtime_error if a parsing error occurs (e.g. due to a malformed file),
+        the stream is not open/valid/has any contents, or an unexpected type
+        is passed in.
+        std::out_of_range if there are not enough columns in cols
+*/
+void Areas::populate(std::istream &is, const BethYw::SourceDataType &type, const BethYw::SourceColumnMapping &cols)
+{
+    populate(is, type, cols, nullptr, nullptr, nullptr);
+}
+
+/*
+    Parse data from an standard input stream, that is of a particular type,
+    and with a given column mapping, filtering for specific areas, measures,
+    and years, and fill the container.
+
+    This overloaded function includes pointers to the three filters for areas,
+    measures, and years.
+
+    @param is
+        The input stream from InputSource
+
+    @param type
+        A value from the BethYw::SourceDataType enum which states the underlying
+        data file structure
+
+    @param cols
+        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+        that give the column header in the CSV file
+
+    @param areasFilter
+        An umodifiable pointer to set of umodifiable strings for areas to import,
+        or an empty set if all areas should be imported
+
+    @param measuresFilter
+        An umodifiable pointer to set of umodifiable strings for measures to import,
+        or an empty set if all measures should be imported
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @return
+        void
+
+    @throws 
+        std::runtime_error if a parsing error occurs (e.g. due to a malformed file),
+        the stream is not open/valid/has any contents, or an unexpected type
+        is passed in.
+        std::out_of_range if there are not enough columns in cols
+*/
+void Areas::populate(
+    std::istream &is,
+    const BethYw::SourceDataType &type,
+    const BethYw::SourceColumnMapping &cols,
+    const StringFilterSet *const areasFilter,
+    const StringFilterSet *const measuresFilter,
+    const BethYw::YearFilter &yearsFilter)
+{
+    if (!is.good())
+    {
+        throw std::runtime_error("Input stream is not good!");
+    }
+
+    switch (type)
+    {
+        case BethYw::AuthorityCodeCSV:
+            populateFromAuthorityCodeCSV(is, cols, areasFilter);
+            break;
+        
+        case BethYw::WelshStatsJSON:
+            populateFromWelshStatsJSON(is, cols, areasFilter, measuresFilter, yearsFilter);
+            break;
+
+        case BethYw::AuthorityByYearCSV:
+            populateFromAuthorityByYearCSV(is, cols, areasFilter, measuresFilter, yearsFilter);
+            break;
+
+        case BethYw::WelshStatsJSONL:
+            populateFromWelshStatsJSONL(is, cols, areasFilter, measuresFilter, yearsFilter);
+            break;
+
+        default:
+            throw std::runtime_error("Areas::populate: Unexpected data type");
+            break;
+    }
+}
+
 /*
-    Constructor for an Areas object.
+    Parse data from an standard input stream, with the years filter given as
+    a pointer to a single inclusive range, where <0,0> or a null pointer
+    imports all years (see the overload above).
 */
-Areas::Areas()
+void Areas::populate(
+    std::istream &is,
+    const BethYw::SourceDataType &type,
+    const BethYw::SourceColumnMapping &cols,
+    const StringFilterSet *const areasFilter,
+    const StringFilterSet *const measuresFilter,
+    const YearFilterTuple *const yearsFilter)
 {
+    populate(is, type, cols, areasFilter, measuresFilter, BethYw::YearFilter(yearsFilter));
 }
 
 /*
-    Add a particular Area to the Areas object.
+    Enable external-memory mode. Once the estimated size of the data imported
+    passes `bytes`, the measures of every Area are written out to a sorted run
+    file in `tempDir` and released from memory (the names are kept so they can
+    still be used by the areas filter). The runs are merged back together,
+    one Area at a time, when the data is output.
 
-    If an Area already exists with the same local authority code, overwrite all
-    data contained within the existing Area with those in the new
-    Area (i.e. they should be combined, but the new Area's data should take
-    precedence, e.g. replace a name with the same language identifier).
+    Note that in this mode getArea() only returns the data imported since the
+    last spill, so the full data is only available through forEachArea() and
+    the output functions.
 
-    @param localAuthorityCode
-        The local authority code of the Area
+    The limit bounds the data held by Areas objects, including the parts of a
+    multi-file dataset (see emptyCopy()). It does not bound the parsers: a
+    WelshStatsJSON file is parsed as a whole document, and the data cached
+    by a TailCache (see tail.h) is held in memory.
 
-    @param area
-        The Area object that will contain the Measure objects
+    @param bytes
+        The memory limit in bytes, or 0 to keep everything in memory
+
+    @param tempDir
+        The directory for the run files, including a trailing separator
 
     @return
         void
 */
-void Areas::setArea(const std::string &localAuthorityCode, const Area &area) noexcept
+void Areas::setMemoryLimit(const size_t bytes, const std::string &tempDir) noexcept
 {
-    if (areas.count(localAuthorityCode))
-    {
-        getArea(localAuthorityCode) += area;
-    }
-    else
-    {
-        areas.insert(std::make_pair(localAuthorityCode, area));
-    }
+    this->memoryLimit = bytes;
+    this->tempDir = tempDir;
 }
 
 /*
-    Retrieve an Area instance with a given local authority code.
+    Restrict this Areas object to importing local authority codes in the
+    range [first, last), for running across multiple processes.
 
-    @param localAuthorityCode
-        The local authority code to find the Area instance of
+    @param first
+        The first local authority code in the range, or an empty string to
+        start from the beginning
+
+    @param last
+        The local authority code after the end of the range, or an empty
+        string for no upper bound
 
     @return
-        An Area object
+        void
+*/
+void Areas::setShard(const std::string &first, const std::string &last) noexcept
+{
+    shardFirst = first;
+    shardLast = last;
+}
 
-    @throws
-        std::out_of_range if an Area with the set local authority code does not
-        exist in this Areas instance
+/*
+    Enable stats-only mode, where each Measure keeps its values as a compact
+    series of (year, value) pairs rather than a map as the data is imported
+    (see Measure::summarise()). The current value of every year is still
+    kept, so the statistics are exactly those of the full data, but in a few
+    bytes a year rather than a map node each. The output then only has the
+    Average, Diff. and % Diff. columns.
+
+    This cannot be combined with external-memory mode, as the run files store
+    a map of the values of each year.
+
+    @param statsOnly
+        Whether to only keep the compact series of each Measure
+
+    @return
+        void
 */
-Area& Areas::getArea(const std::string &localAuthorityCode)
+void Areas::setStatsOnly(const bool statsOnly) noexcept
 {
-    auto it = areas.find(localAuthorityCode);
+    this->statsOnly = statsOnly;
+}
 
-    if (it == areas.end())
-    {
-        throw std::out_of_range("No area found matching " + localAuthorityCode);
-    }
+/*
+    Set the where expression rows must match to keep their values as they
+    are imported. It is evaluated over each batch of rows before the batch
+    is applied, so values that don't match are never stored.
 
-    return it->second;
+    @param predicate
+        The compiled expression, or null to keep every value
+
+    @return
+        void
+*/
+void Areas::setPredicate(std::shared_ptr<const BethYw::RowPredicate> predicate) noexcept
+{
+    this->predicate = std::move(predicate);
 }
 
 /*
-    Retrieve the number of Areas within the container.
+    Set the limits the parsers enforce on the files imported, so a file with
+    a pathological line, field, nesting or number of columns is rejected
+    with a BethYw::ParserLimitError rather than exhausting memory or time.
+
+    @param limits
+        The limits (see rowstream.h)
 
     @return
-        The number of Area instances
+        void
 */
-const size_t Areas::size() const noexcept
+void Areas::setParserLimits(const BethYw::ParserLimits &limits) noexcept
 {
-    return areas.size();
+    this->limits = limits;
 }
 
 /*
-    This function specifically parses the compiled areas.csv file of local 
-    authority codes, and their names in English and Welsh.
+    Check whether a local authority code is in the range set by setShard().
 
-    This is a simple dataset that is a comma-separated values file (CSV), where
-    the first row gives the name of the columns, and then each row is a set of
-    data.
+    @param localAuthorityCode
+        The local authority code to check
 
-    @param is
-        The input stream from InputSource
+    @return bool
+        True if the code is in range (or there is no range), false if not
+*/
+const bool Areas::inShard(const std::string &localAuthorityCode) const noexcept
+{
+    return localAuthorityCode >= shardFirst && (shardLast.empty() || localAuthorityCode < shardLast);
+}
 
-    @param cols
-        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
-        that give the column header in the CSV file
+/*
+    Spill to a run file if external-memory mode is enabled and the estimated
+    size of the rows imported since the last spill passes the memory limit.
 
-    @param areasFilter
-        An umodifiable pointer to set of umodifiable strings for areas to import,
-        or an empty set if all areas should be imported
+    @param rows
+        The number of rows just imported
 
     @return
         void
 
-    @throws 
-        std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
-        std::out_of_range if there are not enough columns in cols
+    @throws
+        std::runtime_error if the run file cannot be written
 */
-void Areas::populateFromAuthorityCodeCSV(std::istream &is, const BethYw::SourceColumnMapping &cols, const StringFilterSet *const areasFilter)
+void Areas::maybeSpill(const size_t rows)
 {
-    std::string cell;
-    std::string line;
-    std::vector<std::string> fileCols;
-
-    if (!getline(is, line))
+    if (memoryLimit == 0)
     {
-        throw std::runtime_error("Malformed file!");
+        return;
     }
 
-    // Parese the first line to get the column headers
-    std::stringstream sstr(line);
-    while (getline(sstr, cell, ','))
-    {
-        fileCols.push_back(cell);
-    }
+    rowsSinceSpill += rows;
 
-    // If the cols passed in dont match the parsed cols invalid file
-    if (fileCols.size() != cols.size()) 
+    if (rowsSinceSpill * ESTIMATED_BYTES_PER_ROW > memoryLimit)
     {
-        throw std::out_of_range("Cols length mismatch!");
+        spill();
     }
+}
 
-    while (getline(is, line))
-    {
-        std::vector<std::string> areaData;
-        std::stringstream row(line);
+/*
+    Write every Area to a new run file, in order of local authority code, and
+    clear their measures.
 
-        while (getline(row, cell, ','))
-        {
-            areaData.push_back(cell);
-        }
+    @return
+        void
 
-        if (areaData.size() < 3)
-        {
-            throw std::runtime_error("Malformed file!");
-        }
+    @throws
+        std::runtime_error if the run file cannot be written
+*/
+void Areas::spill()
+{
+    if (!runs)
+    {
+        runs = std::make_shared<BethYw::RunSet>(tempDir);
+    }
 
-        if (checkFilter(areasFilter, areaData[0], true, {areaData[1], areaData[2]}))
-        {
-            Area area = Area(areaData[0]);
-            area.setName("eng", areaData[1]);
-            area.setName("cym", areaData[2]);
+    const std::string path = runs->nextPath();
+    std::ofstream file(path, std::ios::binary);
 
-            setArea(areaData[0], area);
-        }
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Areas::spill: Failed to open run file " + path);
     }
-}
-
-/*
-    Data from StatsWales is in the JSON format, and contains three
-    top-level keys: odata.metadata, value, odata.nextLink. value contains the
-    data we need.
 
-    If areasFilter is a non-empty set only include areas matching the filter. If
-    measuresFilter is a non-empty set only include measures matching the filter.
-    If yearsFilter is not equal to <0,0>, only import years within the range
-    specified by the tuple (inclusive).
+    for (auto &it : areas)
+    {
+        BethYw::writeArea(file, it.second);
+    }
 
-    @param is
-        The input stream from InputSource
+    file.close();
 
-    @param cols
-        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
-        that give the column header in the CSV file
+    if (file.fail())
+    {
+        std::remove(path.c_str());
+        throw std::runtime_error("Areas::spill: Failed to write run file " + path);
+    }
 
-    @param areasFilter
-        An umodifiable pointer to set of umodifiable strings of areas to import,
-        or an empty set if all areas should be imported
+    // Only release the measures once they are safely on disk
+    for (auto &it : areas)
+    {
+        it.second.clearMeasures();
+    }
 
-    @param measuresFilter
-        An umodifiable pointer to set of umodifiable strings of measures to import,
-        or an empty set if all measures should be imported
+    runs->add(path);
+    rowsSinceSpill = 0;
+}
 
-    @param yearsFilter
-        An umodifiable pointer to an umodifiable tuple of two unsigned integers,
-        where if both values are 0, then all years should be imported, otherwise
-        they should be treated as the range of years to be imported (inclusively)
+/*
+    Merge consecutive run files into one, in passes, until there are no more
+    than RUN_FAN_IN of them, so no more than RUN_FAN_IN + 1 run files are
+    open at a time whatever the number of spills. This only changes how the
+    data is stored, not the data itself.
 
     @return
         void
 
-    @throws 
-        std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
-        std::out_of_range if there are not enough columns in cols
+    @throws
+        std::runtime_error if a run file cannot be read or written
 */
-void Areas::populateFromWelshStatsJSON(std::istream &is, 
-                                       const BethYw::SourceColumnMapping &cols, 
-                                       const StringFilterSet *const areasFilter, 
-                                       const StringFilterSet *const measuresFilter,
-                                       const YearFilterTuple *const yearsFilter)
+void Areas::compactRuns() const
 {
-    json j;
-
-    try
-    {
-        is >> j;
-    }
-    catch(const std::exception& e)
+    while (runs->size() > RUN_FAN_IN)
     {
-        throw std::runtime_error("Malformed file!");
-    }
-
-    std::string localAuthorityCode;
-    std::string areaName;
-    std::string measureCode;
-    std::string measureName;
-    unsigned int year;
-    double value;
-
-    for (auto& el : j["value"].items()) {
-        auto &data = el.value();
-
-        try
+        for (size_t first = 0; first + 1 < runs->size(); first++)
         {
-            localAuthorityCode = data[cols.at(BethYw::AUTH_CODE)];
-            areaName = data[cols.at(BethYw::AUTH_NAME_ENG)];
-
-            // Check measure type and parse
-            if (cols.find(BethYw::MEASURE_CODE) != cols.end())
-            {
-                measureCode = data[cols.at(BethYw::MEASURE_CODE)];
-                measureName = data[cols.at(BethYw::MEASURE_NAME)];
-            }
-            else 
-            {
-                measureCode = cols.at(BethYw::SINGLE_MEASURE_CODE);
-                measureName = cols.at(BethYw::SINGLE_MEASURE_NAME);
-            }
+            const auto &paths = runs->getPaths();
+            const size_t count = std::min((size_t)RUN_FAN_IN, paths.size() - first);
+            const std::vector<std::string> group(paths.begin() + first, paths.begin() + first + count);
+            const std::string path = runs->nextPath();
+            std::ofstream file(path, std::ios::binary);
 
-            // Parse and convert the year
-            std::string yearString = data[cols.at(BethYw::YEAR)];
-            try 
-            {
-                year = std::stoul(yearString);
-            }
-            catch(const std::invalid_argument& e)
+            if (!file.is_open())
             {
-                throw std::runtime_error("Malformed file!");
+                throw std::runtime_error("Areas::forEachArea: Failed to open run file " + path);
             }
 
-            // Parse and convert the value
             try
             {
-                value = data[cols.at(BethYw::VALUE)];
+                mergeRuns(group, areas, false, [&file](const Area &area) {
+                    BethYw::writeArea(file, area);
+                });
             }
-            catch(const nlohmann::detail::type_error& e)
+            catch(...)
             {
-                std::string valueString = data[cols.at(BethYw::VALUE)];
-                try 
-                {
-                    value = std::stod(valueString);
-                }
-                catch(const std::invalid_argument& e)
-                {
-                    throw std::runtime_error("Malformed file!");
-                }
+                file.close();
+                std::remove(path.c_str());
+                throw;
             }
-        }
-        catch(const std::out_of_range& e)
-        {
-            throw std::out_of_range("Not enough cols!");
-        }
 
-        // Find any existing names for the currect area
-        // The names are passed into the filter check to be used in the extended argument filtering
-        std::vector<std::string> existingNames = getExistingNames(localAuthorityCode);
-        existingNames.push_back(areaName);
-    
-        if (checkFilter(areasFilter, localAuthorityCode, true, existingNames))
-        {
-            Area area = Area(localAuthorityCode);
-            area.setName("eng", areaName);
-            
-            if (checkFilter(measuresFilter, measureCode))
-            {
-                Measure measure = Measure(measureCode, measureName);
+            file.close();
 
-                if (checkFilter(yearsFilter, year))
-                {
-                    measure.setValue(year, value);
-                }
-                
-                area.setMeasure(measureCode, measure);
+            if (file.fail())
+            {
+                std::remove(path.c_str());
+                throw std::runtime_error("Areas::forEachArea: Failed to write run file " + path);
             }
 
-            setArea(localAuthorityCode, area);
+            runs->replace(first, count, path);
         }
     }
 }
 
 /*
-    This function imports CSV files that contain a single measure. The 
-    CSV file consists of columns containing the authority code and years.
-    Each row contains an authority code and values for each year (or no value
-    if the data doesn't exist).
-
-    @param is
-        The input stream from InputSource
-
-    @param cols
-        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
-        that give the column header in the CSV file
-
-    @param areasFilter
-        An umodifiable pointer to set of umodifiable strings for areas to import,
-        or an empty set if all areas should be imported
+    Call `callback` with each Area in order of local authority code.
 
-    @param measuresFilter
-        An umodifiable pointer to set of strings for measures to import, or an empty 
-        set if all measures should be imported
+    In external-memory mode the run files and the data still in memory are
+    merged as they are read (a k-way merge), with later runs taking precedence
+    in the same way as setArea(), so only one Area from each run is held in
+    memory at a time. If there are more than RUN_FAN_IN runs they are first
+    compacted (see compactRuns()).
 
-    @param yearsFilter
-        An umodifiable pointer to an umodifiable tuple of two unsigned integers,
-        where if both values are 0, then all years should be imported, otherwise
-        they should be treated as a the range of years to be imported
+    @param callback
+        The function to call with each Area
 
     @return
         void
 
-    @throws 
-        std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
-        std::out_of_range if there are not enough columns in cols
+    @throws
+        std::runtime_error if a run file cannot be read or written
 */
-void Areas::populateFromAuthorityByYearCSV(std::istream &is, const BethYw::SourceColumnMapping &cols, 
-                                           const StringFilterSet *const areasFilter, 
-                                           const StringFilterSet *const measuresFilter, 
-                                           const YearFilterTuple *const yearsFilter)
+void Areas::forEachArea(const std::function<void(const Area &)> &callback) const
 {
-    std::string cell;
-    std::string line;
-    std::vector<std::string> fileCols;
-
-    if (!getline(is, line))
+    if (!runs || runs->size() == 0)
     {
-        throw std::runtime_error("Malformed file!");
-    }
+        for (auto &it : areas)
+        {
+            callback(it.second);
+        }
 
-    std::stringstream sstr(line);
-    while (getline(sstr, cell, ','))
-    {
-        fileCols.push_back(cell);
+        return;
     }
 
-    if (cols.size() != 3)
-    {
-        throw std::out_of_range("Cols length mismatch!");
-    }
+    compactRuns();
+    mergeRuns(runs->getPaths(), areas, true, callback);
+}
 
-    if (fileCols[0] != cols.at(BethYw::AUTH_CODE))
+/*
+    Create an Areas object to import one part of a dataset into, e.g. one of
+    the files of a multi-file dataset. It has the same areas and names as this
+    one, so the area filter matches names in the same way, and the same shard
+    and where expression, but no measures. It keeps every value, so merge()
+    applies the stats-only mode of this object. In external-memory mode it
+    spills to its own runs beyond an equal share of the memory limit, so the
+    parts held at once stay within the limit between them.
+
+    @param parts
+        The number of parts that will be held at once
+
+    @return
+        The new Areas object
+*/
+Areas Areas::emptyCopy(const size_t parts) const
+{
+    Areas copy;
+    copy.shardFirst = shardFirst;
+    copy.shardLast = shardLast;
+    copy.predicate = predicate;
+    copy.limits = limits;
+
+    if (memoryLimit > 0)
     {
-        throw std::runtime_error("Malformed file!");
+        copy.memoryLimit = std::max<size_t>(1, memoryLimit / std::max<size_t>(1, parts));
+        copy.tempDir = tempDir;
     }
 
-    while (getline(is, line))
+    for (auto &it : areas)
     {
-        std::vector<std::string> data;
-        std::stringstream row(line);
+        Area area(it.second.getLocalAuthorityCode());
 
-        while (getline(row, cell, ','))
+        for (auto &name : it.second.getNames())
         {
-            data.push_back(cell);
-        }        
+            area.setName(name.first, name.second);
+        }
 
-        if (checkFilter(areasFilter, data[0], true, getExistingNames(data[0])))
-        {
-            Area area = Area(data[0]);
+        copy.areas.emplace_hint(copy.areas.end(), it.first, std::move(area));
+    }
 
-            if (checkFilter(measuresFilter, cols.at(BethYw::SINGLE_MEASURE_CODE)))
-            {
-                Measure measure = Measure(cols.at(BethYw::SINGLE_MEASURE_CODE), cols.at(BethYw::SINGLE_MEASURE_NAME));
+    return copy;
+}
 
-                for (unsigned int i = 1; i < data.size(); i++)
-                {
-                    unsigned int year;
+/*
+    Merge every Area of another Areas object into this one, with the other
+    object's data taking precedence in the same way as setArea(), as if its
+    data had been imported into this object.
 
-                    try 
-                    {
-                        year = std::stoul(fileCols[i]);
-                    }
-                    catch(const std::invalid_argument& e)
-                    {
-                        throw std::runtime_error("Malformed file!");
-                    }
+    @param other
+        The Areas object to merge, e.g. from emptyCopy()
 
-                    if (checkFilter(yearsFilter, year))
-                    {
-                        try
-                        {
-                            measure.setValue(year, std::stod(data[i]));
-                        }
-                        catch(const std::invalid_argument& e)
-                        {
-                            throw std::runtime_error("Malformed file!");
-                        }
-                    }
-                }
+    @return
+        void
 
-                area.setMeasure(cols.at(BethYw::SINGLE_MEASURE_CODE), measure);
+    @throws
+        std::runtime_error if a run file cannot be read or written in
+        external-memory mode
+*/
+void Areas::merge(const Areas &other)
+{
+    other.forEachArea([this](const Area &area) {
+        setArea(area.getLocalAuthorityCode(), area);
+
+        if (memoryLimit > 0)
+        {
+            size_t values = 0;
+            for (auto &measure : area.getMeasures())
+            {
+                values += measure.second.size();
             }
-            
-            setArea(data[0], area);
+
+            maybeSpill(values);
         }
-    }
+    });
 }
 
 /*
-    Parse data from an standard input stream `is`, that has data of a particular
-    `type`, and with a given column mapping in `cols`.
-
-    @param is
-        The input stream from InputSource
-
-    @param type
-        A value from the BethYw::SourceDataType enum which states the underlying
-        data file structure
+    Write this Areas object, and all its containing Area instances, and the
+    Measure instances within those, to an output stream as JSON. Each Area is
+    written as it is reached, so the whole document is never held in memory.
 
-    @param cols
-        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
-        that give the column header in the CSV file
+    @param os
+        The output stream to write to
 
     @return
         void
-
-    @throws 
-        std::runtime_error if a parsing error occurs (e.g. due to a malformed file),
-        the stream is not open/valid/has any contents, or an unexpected type
-        is passed in.
-        std::out_of_range if there are not enough columns in cols
 */
-void Areas::populate(std::istream &is, const BethYw::SourceDataType &type, const BethYw::SourceColumnMapping &cols)
+void Areas::writeJSON(std::ostream &os) const
 {
-    populate(is, type, cols, nullptr, nullptr, nullptr);
+    os << "{";
+    writeJSONMembers(os);
+    os << "}";
 }
 
 /*
-    Parse data from an standard input stream, that is of a particular type,
-    and with a given column mapping, filtering for specific areas, measures,
-    and years, and fill the container.
+    Write each Area as a member of a JSON object (i.e. "code":{...}), separated
+    by commas, without the enclosing braces. This is used by writeJSON() and to
+    join the output of multiple processes. A summarised Measure is written as
+    its average, difference and percentage difference instead of its values.
 
-    This overloaded function includes pointers to the three filters for areas,
-    measures, and years.
+    @param os
+        The output stream to write to
 
-    @param is
-        The input stream from InputSource
+    @return
+        void
+*/
+void Areas::writeJSONMembers(std::ostream &os) const
+{
+    bool first = true;
 
-    @param type
-        A value from the BethYw::SourceDataType enum which states the underlying
-        data file structure
+    forEachArea([&os, &first](const Area &area) {
+        json j;
 
-    @param cols
-        A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
-        that give the column header in the CSV file
+        for (auto &measure : area.getMeasures())
+        {
+            if (measure.second.isSummarised())
+            {
+                j["measures"][measure.first] = {
+                    {"average", measure.second.getAverage()},
+                    {"difference", measure.second.getDifference()},
+                    {"differenceAsPercentage", measure.second.getDifferenceAsPercentage()}};
+                continue;
+            }
 
-    @param areasFilter
-        An umodifiable pointer to set of umodifiable strings for areas to import,
-        or an empty set if all areas should be imported
+            for (auto &value : measure.second.getValues())
+            {
+                j["measures"][measure.first][std::to_string(value.first)] = value.second;
+            }
+        }
 
-    @param measuresFilter
-        An umodifiable pointer to set of umodifiable strings for measures to import,
-        or an empty set if all measures should be imported
+        j["names"] = area.getNames();
 
-    @param yearsFilter
-        An umodifiable pointer to an umodifiable tuple of two unsigned integers,
-        where if both values are 0, then all years should be imported, otherwise
-        they should be treated as a the range of years to be imported
+        os << (first ? "" : ",") << json(area.getLocalAuthorityCode()).dump() << ":" << j.dump();
+        first = false;
+    });
+}
+
+/*
+    Write this Areas object to an output stream as JSON in the columnar
+    layout, where the years of each Measure are written once and each Area
+    has an array of values aligned with them, with null for the years it has
+    no value for, e.g.
+
+        {"years":{"dens":[1991,2001]},
+         "areas":{"W06000011":{"measures":{"dens":[97.1,null]},"names":{...}}}}
+
+    The years are collected in a first pass over the Areas, and then each
+    Area is written as it is reached, as in writeJSON(). A summarised Measure
+    has no years and is written as in writeJSON().
+
+    @param os
+        The output stream to write to
 
     @return
         void
-
-    @throws 
-        std::runtime_error if a parsing error occurs (e.g. due to a malformed file),
-        the stream is not open/valid/has any contents, or an unexpected type
-        is passed in.
-        std::out_of_range if there are not enough columns in cols
 */
-void Areas::populate(
-    std::istream &is,
-    const BethYw::SourceDataType &type,
-    const BethYw::SourceColumnMapping &cols,
-    const StringFilterSet *const areasFilter,
-    const StringFilterSet *const measuresFilter,
-    const YearFilterTuple *const yearsFilter)
+void Areas::writeColumnarJSON(std::ostream &os) const
 {
-    if (!is.good())
-    {
-        throw std::runtime_error("Input stream is not good!");
-    }
+    std::map<std::string, std::map<unsigned int, size_t>> years;
 
-    switch (type)
+    forEachArea([&years](const Area &area) {
+        for (auto &measure : area.getMeasures())
+        {
+            auto &measureYears = years[measure.first];
+
+            for (auto &value : measure.second.getValues())
+            {
+                measureYears.emplace(value.first, 0);
+            }
+        }
+    });
+
+    // Number the years of each Measure and write them
+    json header = json::object();
+
+    for (auto &measure : years)
     {
-        case BethYw::AuthorityCodeCSV:
-            populateFromAuthorityCodeCSV(is, cols, areasFilter);
-            break;
-        
-        case BethYw::WelshStatsJSON:
-            populateFromWelshStatsJSON(is, cols, areasFilter, measuresFilter, yearsFilter);
-            break;
+        json list = json::array();
+        size_t index = 0;
 
-        case BethYw::AuthorityByYearCSV:
-            populateFromAuthorityByYearCSV(is, cols, areasFilter, measuresFilter, yearsFilter);
-            break;
+        for (auto &year : measure.second)
+        {
+            year.second = index++;
+            list.push_back(year.first);
+        }
 
-        default:
-            throw std::runtime_error("Areas::populate: Unexpected data type");
-            break;
+        header[measure.first] = list;
     }
+
+    os << "{\"years\":" << header.dump() << ",\"areas\":{";
+    bool first = true;
+
+    forEachArea([&os, &first, &years](const Area &area) {
+        json j;
+
+        for (auto &measure : area.getMeasures())
+        {
+            if (measure.second.isSummarised())
+            {
+                j["measures"][measure.first] = {
+                    {"average", measure.second.getAverage()},
+                    {"difference", measure.second.getDifference()},
+                    {"differenceAsPercentage", measure.second.getDifferenceAsPercentage()}};
+                continue;
+            }
+
+            const auto &measureYears = years.at(measure.first);
+            json values(measureYears.size(), nullptr);
+
+            for (auto &value : measure.second.getValues())
+            {
+                values[measureYears.at(value.first)] = value.second;
+            }
+
+            j["measures"][measure.first] = std::move(values);
+        }
+
+        j["names"] = area.getNames();
+
+        os << (first ? "" : ",") << json(area.getLocalAuthorityCode()).dump() << ":" << j.dump();
+        first = false;
+    });
+
+    os << "}}";
 }
 
 /*
@@ -545,23 +2236,9 @@ void Areas::populate(
 */
 const std::string Areas::toJSON() const noexcept
 {
-    json j;
-
-    for (auto area : areas)
-    {
-        for (auto measure : area.second.getMeasures())
-        {
-            for (auto value : measure.second.getValues())
-            {
-                j[area.first]["measures"][measure.first][std::to_string(value.first)] = value.second;
-            }
-        }
-
-        j[area.first]["names"] = area.second.getNames();
-    }
-
-    // If the json is empty return empty {}
-    return j.empty() ? "{}" : j.dump();
+    std::ostringstream os;
+    writeJSON(os);
+    return os.str();
 }
 
 /*
@@ -581,10 +2258,9 @@ std::ostream& operator<<(std::ostream &os, const Areas &areas)
 {
     if (areas.size() > 0) 
     {
-        for (auto it : areas.areas)
-        {
-            os << it.second << std::endl;
-        }
+        areas.forEachArea([&os](const Area &area) {
+            os << area << std::endl;
+        });
     }
     else 
     {
@@ -595,91 +2271,193 @@ std::ostream& operator<<(std::ostream &os, const Areas &areas)
 }
 
 /*
-    Searches a string filter set for a specific string, regardless of case. Has the
-    option to enable partial match (disabled by default), which will also return
-    true is the set contains a substring of the string passed in.
+    Searches a folded filter for a precomputed search key (see
+    BethYw::foldCase), requiring an exact match.
 
     @param filter
-        A refernce to the set
+        A reference to the folded filter, which matches everything if empty
 
-    @param x
-        The string to search for
-
-    @param enhancedSearch
-        Wheather to search for substrings
-
-    @param extraSearch
-        Also search for substrings within this vector
+    @param key
+        The search key to look for
 
     @return bool
-        True if the set contains the passed in string, false if not
+        True if the filter is empty or contains the key, false if not
  */
-const bool Areas::checkFilter(const StringFilterSet *const filter, 
-                              const std::string &x, const bool enhancedSearch, 
-                              std::vector<std::string> extraSearch) const noexcept
+const bool Areas::checkFilter(const FoldedFilter &filter, const std::string &key) const noexcept
 {
-    if (filter == nullptr || filter->empty())
+    if (filter.empty())
     {
         return true;
     }
 
-    std::string xLowerCase = x;
-    BethYw::stringToLower(xLowerCase);
+    return std::find(filter.begin(), filter.end(), key) != filter.end();
+}
 
-    for (auto it : *filter)
-    {
-        BethYw::stringToLower(it);
+/*
+    Searches a folded filter against a set of precomputed search keys for the
+    extended argument filtering, where a filter value matches if it is a
+    substring of any of the keys (e.g. the local authority code or a name).
 
-        if (it == xLowerCase)
-        {
-            return true;
-        }
+    @param filter
+        A reference to the folded filter, which matches everything if empty
+
+    @param keys
+        The search keys to look in
+
+    @return bool
+        True if the filter is empty or any value in it is found within a key,
+        false if not
+ */
+const bool Areas::checkFilter(const FoldedFilter &filter, const std::vector<std::string> &keys) const noexcept
+{
+    if (filter.empty())
+    {
+        return true;
+    }
 
-        // For the extended argument filtering also search substrings
-        if (enhancedSearch)
+    for (auto &it : filter)
+    {
+        for (auto &key : keys)
         {
-            if (xLowerCase.find(it) != std::string::npos) 
+            if (key.find(it) != std::string::npos)
             {
                 return true;
             }
-
-            BethYw::stringVectorToLower(extraSearch);
-            for (auto name : extraSearch)
-            {
-                if (name.find(it) != std::string::npos) 
-                {
-                    return true;
-                }
-            }
         }
     }
-    
+
     return false;
 }
 
+/*
+    Checks the areas filter for a row being imported, using the names of any
+    Area already stored with the local authority code along with the name
+    given in the row. The names come from the import's snapshot of the Areas
+    (see ImportFilter), which is updated here whenever a named row passes.
+    An area not in the snapshot (e.g. one spilled to a run file, or when
+    areas.csv was not imported) uses the names of the local authority in the
+    embedded table (see authorities.h), if it is there.
+    Results are memoised so each area is only folded and checked once per
+    name per import.
+
+    @param filter
+        The filters for this import
+
+    @param localAuthorityCode
+        The local authority code in the row
+
+    @param name
+        The English name in the row, or an empty string if there isn't one
+
+    @return bool
+        True if the row should be imported, false if not
+ */
+const bool Areas::checkAreaFilter(ImportFilter &filter, const std::string &localAuthorityCode,
+                                  const std::string &name) const noexcept
+{
+    if (filter.areas.empty())
+    {
+        return true;
+    }
+
+    auto cached = filter.areaCache.find(localAuthorityCode);
+    if (cached != filter.areaCache.end() && cached->second.first == name)
+    {
+        return cached->second.second;
+    }
+
+    std::vector<std::string> keys = {BethYw::foldCase(localAuthorityCode, true)};
+    auto existing = filter.areaNames.find(localAuthorityCode);
+
+    if (existing != filter.areaNames.end())
+    {
+        for (auto &it : existing->second)
+        {
+            keys.push_back(it.second);
+        }
+    }
+    else if (const BethYw::Authority *authority = BethYw::findAuthority(localAuthorityCode))
+    {
+        keys.push_back(BethYw::foldCase(authority->eng, true));
+        keys.push_back(BethYw::foldCase(authority->cym, true));
+    }
+
+    std::string foldedName;
+    if (!name.empty())
+    {
+        foldedName = BethYw::foldCase(name, true);
+        keys.push_back(foldedName);
+    }
+
+    const bool matches = checkFilter(filter.areas, keys);
+    filter.areaCache[localAuthorityCode] = std::make_pair(name, matches);
+
+    // The Area will have this name once the row has been imported
+    if (matches && !name.empty())
+    {
+        filter.areaNames[localAuthorityCode]["eng"] = foldedName;
+    }
+
+    return matches;
+}
+
+/*
+    Checks the measures filter for a row being imported. Results are memoised
+    in `cache` so each measure code is only folded and checked once per import.
+
+    @param filter
+        A reference to the folded measures filter
+
+    @param measureCode
+        The measure code in the row
+
+    @param cache
+        The memoised results for this import
+
+    @return bool
+        True if the row should be imported, false if not
+ */
+const bool Areas::checkMeasureFilter(const FoldedFilter &filter, const std::string &measureCode,
+                                     MeasureFilterCache &cache) const noexcept
+{
+    if (filter.empty())
+    {
+        return true;
+    }
+
+    auto cached = cache.find(measureCode);
+    if (cached != cache.end())
+    {
+        return cached->second;
+    }
+
+    const bool matches = checkFilter(filter, BethYw::foldCase(measureCode, true));
+    cache[measureCode] = matches;
+
+    return matches;
+}
+
 /*
     Checks if an integer is within the given range (inclusive).
 
     @param range
-        A tuple containing the high and low value of the range
+        A tuple containing the high and low value of the range, or <0,0> to
+        match every value
 
     @param x
-        The int to check
+        The value to check
 
     @return bool
-        True if the int is within the given range, false if not
+        True if the value is within the given range, false if not
  */
-const bool Areas::checkFilter(const YearFilterTuple *const filter, int x) const noexcept
+const bool Areas::checkFilter(const YearFilterTuple *const filter, const unsigned int x) const noexcept
 {
     if (filter == nullptr || *filter == std::tuple<unsigned int, unsigned int>{0, 0})
     {
         return true;
     }
-    
-    int low = std::get<0>(*filter);
-    int high = std::get<1>(*filter);
 
-    return ((x-low) <= (high-low));
+    return std::get<0>(*filter) <= x && x <= std::get<1>(*filter);
 }
 
 /*
@@ -696,11 +2474,11 @@ const bool Areas::checkFilter(const YearFilterTuple *const filter, int x) const
 const std::vector<std::string> Areas::getExistingNames(const std::string &localAuthorityCode) noexcept
 {
     std::vector<std::string> existingNames;
+    const Area *existingArea = findArea(localAuthorityCode);
 
-    if (areas.count(localAuthorityCode))
+    if (existingArea != nullptr)
     {
-        Area existingArea = getArea(localAuthorityCode);
-        for (auto existingName : existingArea.getNames())
+        for (auto &existingName : existingArea->getNames())
         {
             existingNames.push_back(existingName.second);
         }
@@ -23,13 +23,29 @@
             +-> Areas A class that contains all Area objects.
 */
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
 #include <tuple>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "datasets.h"
 #include "area.h"
+#include "gsscode.h"
+#include "rowstream.h"
+#include "store.h"
+#include "years.h"
+
+namespace BethYw
+{
+    class RowPredicate;
+    struct Authority;
+}
 
 /*
     An alias for filters based on strings such as categorisations e.g. area,
@@ -38,14 +54,131 @@
 using StringFilterSet = std::unordered_set<std::string>;
 
 /*
-    An alias for a year filter.
+    An alias for a string filter that has been case folded once up front, ready
+    to compare against the search keys precomputed by Area and Measure.
+*/
+using FoldedFilter = std::vector<std::string>;
+
+/*
+    Memoised area filter results for a single import, keyed by local authority
+    code (along with the name the result was computed for), so the filter is
+    checked once per area rather than once per row.
+*/
+using AreaFilterCache = std::unordered_map<std::string, std::pair<std::string, bool>>;
+
+/*
+    Memoised measure filter results for a single import, keyed by measure code.
+*/
+using MeasureFilterCache = std::unordered_map<std::string, bool>;
+
+/*
+    The folded names of each Area by language, keyed by local authority code.
+*/
+using AreaNameSnapshot = std::unordered_map<std::string, std::map<std::string, std::string>>;
+
+/*
+    The filters for a single import, with the string filters folded once up
+    front and the memoised results of checking them.
+
+    The area filter also matches the names of existing Areas. Those are
+    copied into areaNames before the import starts and kept up to date as
+    rows pass the filter, so the filter can run on its own thread while
+    earlier rows are still being added to the Areas.
+*/
+struct ImportFilter
+{
+    FoldedFilter areas;
+    FoldedFilter measures;
+    BethYw::YearFilter years;
+    AreaFilterCache areaCache;
+    MeasureFilterCache measureCache;
+    AreaNameSnapshot areaNames;
+
+    ImportFilter(const StringFilterSet *const areasFilter,
+                 const StringFilterSet *const measuresFilter,
+                 const BethYw::YearFilter &yearsFilter);
+};
+
+/*
+    A single row of a dataset as it moves through an import pipeline (see
+    rowstream.h). The column plan fills in the strings, the filter stage
+    clears hasMeasure if the measure should not be imported, and the
+    converter parses the year and value.
 */
-using YearFilterTuple = std::tuple<unsigned int, unsigned int>;
+struct ImportRow
+{
+    std::string localAuthorityCode;
+    std::string areaName;
+    bool named = false;
+
+    std::string measureCode;
+    std::string measureName;
+    bool hasMeasure = false;
+
+    // The year and value as text, or the value as a number if the source
+    // had one (hasValue is false if the row has no year at all)
+    std::string yearText;
+    std::string valueText;
+    bool hasValue = false;
+    bool numeric = false;
+
+    // Set by the converter if the year passes the filter
+    unsigned int year = 0;
+    double value = 0;
+    bool hasYear = false;
+};
+
+/*
+    A batch of rows waiting to be applied to an Areas object, so each Area and
+    Measure is only looked up once per batch rather than once per row. The
+    rows are stored as parallel arrays of ids into small dictionaries of the
+    local authority codes and measures in the batch.
+
+    A row may have no measure (NO_MEASURE), when only the Area should be
+    created, or no year (NO_YEAR), when only the Measure should be created.
+*/
+class RowBatch
+{
+public:
+    static constexpr size_t CAPACITY = 4096;
+    static constexpr uint32_t NO_MEASURE = UINT32_MAX;
+    static constexpr unsigned int NO_YEAR = UINT32_MAX;
+
+    // The rows
+    std::vector<uint32_t> codeIds;
+    std::vector<uint32_t> measureIds;
+    std::vector<unsigned int> years;
+    std::vector<double> values;
+
+    // The dictionaries, where each distinct (code, name) and (codename, label)
+    // has its own id
+    std::vector<std::string> codes;
+    std::vector<std::string> names;
+    std::vector<bool> named;
+    std::vector<std::string> measureCodes;
+    std::vector<std::string> measureLabels;
+
+    RowBatch();
+    uint32_t internCode(const std::string &code);
+    uint32_t internCode(const std::string &code, const std::string &name);
+    uint32_t internMeasure(std::string codename, const std::string &label);
+    void add(const uint32_t codeId, const uint32_t measureId, const unsigned int year, const double value);
+    const size_t size() const noexcept;
+    const bool full() const noexcept;
+    void clear() noexcept;
+
+private:
+    std::unordered_map<std::string, uint32_t> codeIndex;
+    std::unordered_map<std::string, uint32_t> measureIndex;
+};
 
 /*
-    An alias for the data within an Areas object stores Area objects.
+    An alias for the data within an Areas object stores Area objects. The
+    Areas are keyed on the packed form of their local authority codes (see
+    gsscode.h), so finding an Area and iterating in order of local authority
+    code are integer operations.
 */
-using AreasContainer = std::map<std::string, Area>;
+using AreasContainer = std::map<BethYw::GssCode, Area>;
 
 /*
     Areas is a class that stores all the data categorised by area. The 
@@ -56,10 +189,50 @@ class Areas
 private:
     AreasContainer areas;
 
+    // External-memory mode, where measures are spilled to sorted run files
+    // once the estimated size of the container passes memoryLimit. No more
+    // than RUN_FAN_IN runs are merged at a time (see compactRuns())
+    static constexpr size_t ESTIMATED_BYTES_PER_ROW = 64;
+    static constexpr size_t RUN_FAN_IN = 4;
+    size_t memoryLimit = 0;
+    size_t rowsSinceSpill = 0;
+    std::string tempDir;
+    std::shared_ptr<BethYw::RunSet> runs;
+    void maybeSpill(const size_t rows = 1);
+    void spill();
+    void compactRuns() const;
+
+    // The range of local authority codes to import, when sharded across
+    // processes (an empty shardLast means there is no upper bound)
+    std::string shardFirst;
+    std::string shardLast;
+    const bool inShard(const std::string &localAuthorityCode) const noexcept;
+
+    // Stats-only mode, where each Measure keeps its values as a compact
+    // series rather than a map, and only its statistics are output (see
+    // Measure::summarise())
+    bool statsOnly = false;
+
+    // The where expression rows must match to keep their values (see
+    // where.h), or null to keep every value
+    std::shared_ptr<const BethYw::RowPredicate> predicate;
+
+    // The limits the parsers enforce on each file (see rowstream.h)
+    BethYw::ParserLimits limits;
+
+    // The stages shared by the import pipelines (see rowstream.h)
+    void snapshotAreaNames(ImportFilter &filter) const;
+    void filterRow(ImportRow &row, std::vector<ImportRow> &out, ImportFilter &filter) const;
+    void convertRow(ImportRow &row, std::vector<ImportRow> &out, const ImportFilter &filter) const;
+    void importRows(BethYw::RowStreamPtr<ImportRow> rows, ImportFilter &filter);
+    void applyBatch(RowBatch &batch);
+
 public:
     Areas();
     const size_t size() const noexcept;
     Area& getArea(const std::string &localAuthorityCode);
+    Area *findArea(const std::string &localAuthorityCode) noexcept;
+    const Area *findArea(const std::string &localAuthorityCode) const noexcept;
     void setArea(const std::string &localAuthorityCode, const Area &area) noexcept;
 
     void populateFromAuthorityCodeCSV(
@@ -67,13 +240,39 @@ public:
         const BethYw::SourceColumnMapping &cols,
         const StringFilterSet *const areas = nullptr) noexcept(false);
 
+    void populateFromAuthorities(
+        const BethYw::Authority *const authorities,
+        const size_t count,
+        const StringFilterSet *const areasFilter = nullptr);
+
+    void populateFromWelshStatsJSON(
+        std::istream &is, 
+        const BethYw::SourceColumnMapping &cols, 
+        const StringFilterSet *const areasFilter = nullptr, 
+        const StringFilterSet *const measuresFilter = nullptr, 
+        const YearFilterTuple *const yearsFilter = nullptr);
+
     void populateFromWelshStatsJSON(
+        std::istream &is,
+        const BethYw::SourceColumnMapping &cols,
+        const StringFilterSet *const areasFilter,
+        const StringFilterSet *const measuresFilter,
+        const BethYw::YearFilter &yearsFilter);
+
+    void populateFromWelshStatsJSONL(
         std::istream &is, 
         const BethYw::SourceColumnMapping &cols, 
         const StringFilterSet *const areasFilter = nullptr, 
         const StringFilterSet *const measuresFilter = nullptr, 
         const YearFilterTuple *const yearsFilter = nullptr);
 
+    void populateFromWelshStatsJSONL(
+        std::istream &is,
+        const BethYw::SourceColumnMapping &cols,
+        const StringFilterSet *const areasFilter,
+        const StringFilterSet *const measuresFilter,
+        const BethYw::YearFilter &yearsFilter);
+
     void populateFromAuthorityByYearCSV(
         std::istream &is, 
         const BethYw::SourceColumnMapping &cols, 
@@ -81,6 +280,13 @@ public:
         const StringFilterSet *const measuresFilter = nullptr, 
         const YearFilterTuple *const yearsFilter = nullptr);
 
+    void populateFromAuthorityByYearCSV(
+        std::istream &is,
+        const BethYw::SourceColumnMapping &cols,
+        const StringFilterSet *const areasFilter,
+        const StringFilterSet *const measuresFilter,
+        const BethYw::YearFilter &yearsFilter);
+
     void populate(
         std::istream &is,
         const BethYw::SourceDataType &type,
@@ -94,13 +300,35 @@ public:
         const StringFilterSet *const measuresFilter = nullptr,
         const YearFilterTuple *const yearsFilter = nullptr) noexcept(false);
 
+    void populate(
+        std::istream &is,
+        const BethYw::SourceDataType &type,
+        const BethYw::SourceColumnMapping &cols,
+        const StringFilterSet *const areasFilter,
+        const StringFilterSet *const measuresFilter,
+        const BethYw::YearFilter &yearsFilter) noexcept(false);
+
+    void setMemoryLimit(const size_t bytes, const std::string &tempDir) noexcept;
+    void setShard(const std::string &first, const std::string &last) noexcept;
+    void setStatsOnly(const bool statsOnly) noexcept;
+    void setPredicate(std::shared_ptr<const BethYw::RowPredicate> predicate) noexcept;
+    void setParserLimits(const BethYw::ParserLimits &limits) noexcept;
+    void forEachArea(const std::function<void(const Area &)> &callback) const;
+    Areas emptyCopy(const size_t parts = 1) const;
+    void merge(const Areas &other);
+    void writeJSON(std::ostream &os) const;
+    void writeJSONMembers(std::ostream &os) const;
+    void writeColumnarJSON(std::ostream &os) const;
     const std::string toJSON() const noexcept;
     friend std::ostream& operator<<(std::ostream &os, const Areas &areas);
 
-    const bool checkFilter(const StringFilterSet *const filter, const std::string &x, 
-                           const bool enhancedSearch = false, 
-                           std::vector<std::string> extraSearch = {}) const noexcept;
-    const bool checkFilter(const YearFilterTuple *const filter, int x) const noexcept;
+    const bool checkFilter(const FoldedFilter &filter, const std::string &key) const noexcept;
+    const bool checkFilter(const FoldedFilter &filter, const std::vector<std::string> &keys) const noexcept;
+    const bool checkAreaFilter(ImportFilter &filter, const std::string &localAuthorityCode,
+                               const std::string &name) const noexcept;
+    const bool checkMeasureFilter(const FoldedFilter &filter, const std::string &measureCode,
+                                  MeasureFilterCache &cache) const noexcept;
+    const bool checkFilter(const YearFilterTuple *const filter, const unsigned int x) const noexcept;
     const std::vector<std::string> getExistingNames(const std::string &localAuthorityCode) noexcept;
 };
 
@@ -0,0 +1,76 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the lookups in the embedded table of local
+    authorities (see authorities.h).
+*/
+
+#include <cstring>
+
+#include "authorities.h"
+#include "authorities_table.h"
+#include "gsscode.h"
+#include "store.h"
+
+/*
+    Retrieve the embedded table of local authorities.
+
+    @param count
+        Set to the number of authorities in the table
+
+    @return
+        The table, in the order of the perfect hash
+*/
+const BethYw::Authority *BethYw::embeddedAuthorities(size_t &count) noexcept
+{
+    count = EmbeddedAuthorities::COUNT;
+    return EmbeddedAuthorities::TABLE;
+}
+
+/*
+    Find a local authority in the embedded table in constant time, without
+    allocating.
+
+    @param localAuthorityCode
+        The local authority code to find
+
+    @return
+        A pointer to the authority, or null if it is not in the table
+*/
+const BethYw::Authority *BethYw::findAuthority(const std::string &localAuthorityCode) noexcept
+{
+    using namespace EmbeddedAuthorities;
+
+    GssCode code;
+
+    if (!GssCode::find(localAuthorityCode, code) || !code.isPacked())
+    {
+        return nullptr;
+    }
+
+    const uint64_t key = code.getPacked();
+    const uint32_t displacement = DISPLACEMENTS[authorityHash(key, 0) % BUCKETS];
+    const Authority &authority = TABLE[authorityHash(key, displacement) % COUNT];
+
+    return localAuthorityCode == authority.code ? &authority : nullptr;
+}
+
+/*
+    Check whether the contents of an areas.csv file are the same as the file
+    the embedded table was generated from.
+
+    @param contents
+        The contents of the file
+
+    @return
+        true if the embedded table can be used instead of parsing the file
+*/
+const bool BethYw::matchesEmbeddedAuthorities(const std::string &contents) noexcept
+{
+    return contents.size() == EmbeddedAuthorities::FILE_SIZE
+           && hashBytes(contents.data(), contents.size()) == EmbeddedAuthorities::FILE_HASH;
+}
@@ -0,0 +1,71 @@
+#ifndef AUTHORITIES_H_
+#define AUTHORITIES_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for the table of local authorities
+    embedded in the program when it is built, so areas.csv does not have to
+    be parsed on every run.
+
+    The table is generated from datasets/areas.csv by genauthorities.cpp into
+    authorities_table.h, which is checked in. Regenerate it after changing
+    areas.csv with:
+
+        ./build.sh authorities
+
+    The generator also writes a fingerprint of the file (its size and a hash
+    of its bytes). loadAreas() only uses the table when the areas.csv on disk
+    has the same fingerprint, so a changed or different file is still parsed.
+
+    Codes are found in the table with a minimal perfect hash (hash and
+    displace): a first hash picks a bucket, and the bucket's displacement is
+    the seed of a second hash that gives each code in the table its own
+    slot. Finding a code is two hashes and one string comparison, with no
+    allocation.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace BethYw
+{
+    /*
+        A local authority and its names in English and Welsh.
+    */
+    struct Authority
+    {
+        const char *code;
+        const char *eng;
+        const char *cym;
+    };
+
+    /*
+        The hash used by both levels of the perfect hash, over the packed
+        form of a code (see gsscode.h).
+
+        @param key
+            The packed code
+
+        @param seed
+            0 for the first level, or the displacement of the bucket
+
+        @return
+            The hash
+    */
+    constexpr uint64_t authorityHash(const uint64_t key, const uint64_t seed)
+    {
+        return ((key ^ (seed * 0x9E3779B97F4A7C15ULL)) * 0xBF58476D1CE4E5B9ULL) >> 17;
+    }
+
+    const Authority *embeddedAuthorities(size_t &count) noexcept;
+    const Authority *findAuthority(const std::string &localAuthorityCode) noexcept;
+    const bool matchesEmbeddedAuthorities(const std::string &contents) noexcept;
+}
+
+#endif // AUTHORITIES_H_
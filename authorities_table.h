@@ -0,0 +1,56 @@
+#ifndef AUTHORITIES_TABLE_H_
+#define AUTHORITIES_TABLE_H_
+
+/*
+    Generated by genauthorities.cpp from areas.csv. Do not edit, but
+    regenerate with ./build.sh authorities (see authorities.h).
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#include "authorities.h"
+
+namespace BethYw
+{
+    namespace EmbeddedAuthorities
+    {
+        constexpr size_t FILE_SIZE = 784;
+        constexpr uint64_t FILE_HASH = 0x447d43d3ea85d401ULL;
+
+        constexpr size_t COUNT = 22;
+        constexpr size_t BUCKETS = 11;
+
+        constexpr uint32_t DISPLACEMENTS[BUCKETS] = {
+            1, 1, 5, 0, 8, 1, 2, 0, 98, 6, 68
+        };
+
+        // By slot of the perfect hash
+        constexpr Authority TABLE[COUNT] = {
+            {"W06000008", "Ceredigion", "Ceredigion"},
+            {"W06000015", "Cardiff", "Caerdydd"},
+            {"W06000002", "Gwynedd", "Gwynedd"},
+            {"W06000004", "Denbighshire", "Sir Ddinbych"},
+            {"W06000022", "Newport", "Casnewydd"},
+            {"W06000001", "Isle of Anglesey", "Ynys M\303\264n"},
+            {"W06000016", "Rhondda Cynon Taf", "Rhondda Cynon Taf"},
+            {"W06000024", "Merthyr Tydfil", "Merthyr Tudful"},
+            {"W06000005", "Flintshire", "Sir y Fflint"},
+            {"W06000021", "Monmouthshire", "Sir Fynwy"},
+            {"W06000006", "Wrexham", "Wrecsam"},
+            {"W06000003", "Conwy", "Conwy"},
+            {"W06000019", "Blaenau Gwent", "Blaenau Gwent"},
+            {"W06000011", "Swansea", "Abertawe"},
+            {"W06000012", "Neath Port Talbot", "Castell-nedd Port Talbot"},
+            {"W06000013", "Bridgend", "Pen-y-bont ar Ogwr"},
+            {"W06000010", "Carmarthenshire", "Sir Gaerfyrddin"},
+            {"W06000018", "Caerphilly", "Caerffili"},
+            {"W06000009", "Pembrokeshire", "Sir Benfro"},
+            {"W06000020", "Torfaen", "Torfaen"},
+            {"W06000014", "Vale of Glamorgan", "Bro Morgannwg"},
+            {"W06000023", "Powys", "Powys"}
+        };
+    }
+}
+
+#endif // AUTHORITIES_TABLE_H_
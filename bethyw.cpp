@@ -8,14 +8,28 @@
     This file contains all the helper functions for initialising and running Beth Yw?
 */
 
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 #include <regex>
+#include <sstream>
+#include <thread>
 
 #include "lib_cxxopts.hpp"
 
+#include "authorities.h"
 #include "bethyw.h"
 #include "input.h"
+#include "quantiles.h"
+#include "ranks.h"
+#include "shards.h"
+#include "similar.h"
+#include "shm.h"
+#include "tail.h"
+#include "versions.h"
 
 /*
     Run Beth Yw?, parsing the command line arguments, importing the data,
@@ -49,7 +63,16 @@ int BethYw::run(int argc, char *argv[])
     std::vector<InputFileSource> datasetsToImport;
     StringFilterSet areasFilter;
     StringFilterSet measuresFilter;
-    YearFilterTuple yearsFilter;
+    YearFilter yearsFilter;
+    size_t memoryLimit;
+    unsigned int shards;
+    unsigned int forecast;
+    ForecastMethod forecastMethod;
+    size_t neighbours;
+    unsigned int similarYear;
+    JSONLayout jsonLayout;
+    std::shared_ptr<const RowPredicate> predicate;
+    ParserLimits limits;
 
     try
     {
@@ -57,6 +80,15 @@ int BethYw::run(int argc, char *argv[])
         areasFilter = parseAreasArg(args);
         measuresFilter = parseMeasuresArg(args);
         yearsFilter = parseYearsArg(args);
+        memoryLimit = parseMemoryLimitArg(args);
+        shards = parseShardsArg(args);
+        forecast = parseForecastArg(args);
+        forecastMethod = parseForecastMethodArg(args);
+        neighbours = parseNeighboursArg(args);
+        similarYear = parseSimilarYearArg(args);
+        jsonLayout = parseJSONLayoutArg(args);
+        predicate = parseWhereArg(args);
+        limits = parseLimitsArg(args);
     }
     catch(const std::invalid_argument& e)
     {
@@ -64,19 +96,334 @@ int BethYw::run(int argc, char *argv[])
         return 1;
     }
 
+    const std::string tempDir = memoryLimit > 0 ? parseTempDirArg(args) : "";
+
+    const bool statsOnly = args.count("stats-only");
+
+    if (statsOnly && (memoryLimit > 0 || args.count("shm")))
+    {
+        std::cerr << "The stats-only argument cannot be used with memory-limit or shm" << std::endl;
+        return 1;
+    }
+
+    // Only parse the rows appended to each file since the last run, or
+    // since the last checkpoint of an import that was stopped
+    std::unique_ptr<TailCache> tail;
+    const bool checkpoint = args.count("checkpoint");
+
+    if (args.count("resume") && !checkpoint)
+    {
+        std::cerr << "The resume argument needs a checkpoint file" << std::endl;
+        return 1;
+    }
+
+    if (args.count("tail-cache") || checkpoint)
+    {
+        if (args.count("tail-cache") && checkpoint)
+        {
+            std::cerr << "The tail-cache and checkpoint arguments cannot be used together" << std::endl;
+            return 1;
+        }
+
+        if (shards > 1)
+        {
+            std::cerr << "The tail-cache and checkpoint arguments cannot be used with shards" << std::endl;
+            return 1;
+        }
+
+        tail.reset(new TailCache(args[checkpoint ? "checkpoint" : "tail-cache"].as<std::string>(),
+                                 sharedSegmentKey(dir, datasetsToImport, areasFilter, measuresFilter, yearsFilter,
+                                                  predicate ? predicate->getSource() : "")));
+
+        if (checkpoint)
+        {
+            tail->enableCheckpoints();
+        }
+
+        if (!checkpoint || args.count("resume"))
+        {
+            tail->load();
+        }
+    }
+
+    // Keep every version of the data imported, or output a past version
+    // instead of importing the datasets
+    std::unique_ptr<VersionStore> versions;
+    const bool asOf = args.count("as-of");
+
+    if (asOf && !args.count("versions"))
+    {
+        std::cerr << "The as-of argument needs a versions file" << std::endl;
+        return 1;
+    }
+
+    if (args.count("versions"))
+    {
+        if (shards > 1 || memoryLimit > 0 || statsOnly || args.count("shm"))
+        {
+            std::cerr << "The versions argument cannot be used with shards, memory-limit, stats-only or shm"
+                      << std::endl;
+            return 1;
+        }
+
+        versions.reset(new VersionStore(args["versions"].as<std::string>(),
+                                        sharedSegmentKey(dir, datasetsToImport, areasFilter, measuresFilter,
+                                                         yearsFilter, predicate ? predicate->getSource() : "")));
+
+        try
+        {
+            versions->load();
+        }
+        catch(const std::runtime_error& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    auto load = [&](Areas &data) {
+        if (memoryLimit > 0)
+        {
+            data.setMemoryLimit(memoryLimit, tempDir);
+        }
+
+        data.setStatsOnly(statsOnly);
+        data.setPredicate(predicate);
+        data.setParserLimits(limits);
+
+        const bool loaded = BethYw::loadDatasets(data, dir, datasetsToImport, areasFilter, measuresFilter,
+                                                 yearsFilter, tail.get());
+
+        if (loaded && tail)
+        {
+            // A finished import has nothing left to resume
+            if (checkpoint)
+            {
+                tail->discard();
+            }
+            else
+            {
+                try
+                {
+                    tail->save();
+                }
+                catch(const std::exception& e)
+                {
+                    // The data was imported, so carry on without the cache
+                    std::cerr << e.what() << std::endl;
+                }
+            }
+        }
+
+        if (loaded && versions)
+        {
+            try
+            {
+                versions->record(data, VersionStore::today());
+            }
+            catch(const std::exception& e)
+            {
+                // The data was imported, so carry on without recording it
+                std::cerr << e.what() << std::endl;
+            }
+        }
+
+        return loaded;
+    };
+
+    if (shards > 1 && jsonLayout == ColumnarLayout)
+    {
+        std::cerr << "The shards argument cannot be used with the columnar json-layout" << std::endl;
+        return 1;
+    }
+
+    if (shards > 1 && args.count("shm"))
+    {
+        std::cerr << "The shards and shm arguments cannot be used together" << std::endl;
+        return 1;
+    }
+
+    const bool quantiles = args.count("quantiles");
+
+    if (quantiles && (shards > 1 || statsOnly))
+    {
+        std::cerr << "The quantiles argument cannot be used with shards or stats-only" << std::endl;
+        return 1;
+    }
+
+    const bool ranks = args.count("ranks");
+
+    if (ranks && (shards > 1 || memoryLimit > 0 || statsOnly || quantiles))
+    {
+        std::cerr << "The ranks argument cannot be used with shards, memory-limit, stats-only or quantiles" << std::endl;
+        return 1;
+    }
+
+    if (forecast > 0 && (shards > 1 || memoryLimit > 0 || statsOnly || quantiles || ranks))
+    {
+        std::cerr << "The forecast argument cannot be used with shards, memory-limit, stats-only, quantiles or ranks"
+                  << std::endl;
+        return 1;
+    }
+
+    const bool similar = args.count("similar");
+
+    if (similar && (shards > 1 || statsOnly || quantiles || ranks || forecast > 0))
+    {
+        std::cerr << "The similar argument cannot be used with shards, stats-only, quantiles, ranks or forecast"
+                  << std::endl;
+        return 1;
+    }
+
+    if (shards > 1)
+    {
+        // Split the areas between processes using the codes in areas.csv
+        Areas codes = Areas();
+
+        try
+        {
+            BethYw::loadAreas(codes, dir, areasFilter);
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << "Error importing dataset:" << std::endl << e.what() << std::endl;
+            return 1;
+        }
+
+        try
+        {
+            return BethYw::runShards(BethYw::shardBoundaries(codes, shards), load, args.count("json"));
+        }
+        catch(const std::runtime_error& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     // Create the areas object and load the datasets
     Areas data = Areas();
-    BethYw::loadDatasets(data, dir, datasetsToImport, areasFilter, measuresFilter, yearsFilter);
 
-    if (args.count("json"))
+    if (args.count("shm"))
+    {
+        // Attach to the data published by an earlier invocation if its files
+        // haven't changed, otherwise import and publish it
+        std::vector<std::string> files = {dir + InputFiles::AREAS.FILE};
+        for (auto &dataset : datasetsToImport)
+        {
+            for (auto &file : InputFile::expand(dir + dataset.FILE))
+            {
+                files.push_back(file);
+            }
+        }
+
+        const std::string name = sharedSegmentName(
+            sharedSegmentKey(dir, datasetsToImport, areasFilter, measuresFilter, yearsFilter,
+                             predicate ? predicate->getSource() : ""));
+        const uint64_t fingerprint = fingerprintFiles(files);
+
+        if (!attachSharedAreas(data, name, fingerprint) && load(data))
+        {
+            publishSharedAreas(data, name, fingerprint);
+        }
+    }
+    else if (asOf)
     {
-        // The output as JSON is the json flag is present
-        std::cout << data.toJSON() << std::endl;
+        try
+        {
+            versions->reconstruct(data, args["as-of"].as<std::string>());
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
     }
     else
     {
-        // The output as tables by default
-        std::cout << data << std::endl;
+        load(data);
+    }
+
+    if (ranks)
+    {
+        addRanks(data);
+    }
+
+    if (forecast > 0)
+    {
+        addForecasts(data, forecast, forecastMethod);
+    }
+
+    // In external-memory mode the output reads the run files back
+    try
+    {
+        if (similar)
+        {
+            // Only output the areas nearest to the one given
+            std::string target = args["similar"].as<std::string>();
+            std::vector<Neighbour> nearest;
+
+            try
+            {
+                const FeatureMatrix matrix = buildFeatureMatrix(data, similarYear);
+                target = matrix.resolve(target);
+                nearest = matrix.nearest(target, neighbours);
+            }
+            catch(const std::out_of_range& e)
+            {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+
+            if (args.count("json"))
+            {
+                writeNeighboursJSON(std::cout, data, target, nearest);
+                std::cout << std::endl;
+            }
+            else
+            {
+                writeNeighbours(std::cout, data, target, nearest);
+            }
+        }
+        else if (quantiles)
+        {
+            // Only output the approximate quantiles of each measure
+            auto digests = digestMeasures(data);
+
+            if (args.count("json"))
+            {
+                writeQuantilesJSON(std::cout, digests);
+                std::cout << std::endl;
+            }
+            else
+            {
+                writeQuantiles(std::cout, digests);
+            }
+        }
+        else if (args.count("json"))
+        {
+            // The output as JSON is the json flag is present
+            if (jsonLayout == ColumnarLayout)
+            {
+                data.writeColumnarJSON(std::cout);
+            }
+            else
+            {
+                data.writeJSON(std::cout);
+            }
+
+            std::cout << std::endl;
+        }
+        else
+        {
+            // The output as tables by default
+            std::cout << data << std::endl;
+        }
+    }
+    catch(const std::runtime_error& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
 
     return 0;
@@ -117,13 +464,122 @@ cxxopts::Options BethYw::cxxoptsSetup()
         cxxopts::value<std::vector<std::string>>())(
 
         "y,years",
-        "Focus on a particular year (YYYY) or "
-        "inclusive range of years (YYYY-ZZZZ)",
+        "Focus on a particular year (YYYY), an inclusive range of years "
+        "(YYYY-ZZZZ), or a list of them separated by commas "
+        "(e.g. 1991,2001,2011-2019)",
         cxxopts::value<std::string>()->default_value("0"))(
 
+        "where",
+        "Only keep values matching an expression of comparisons of value, "
+        "year and measure, joined with and, or and not, e.g. "
+        "\"value > 40 and measure = no2\" or \"value between 50k and 100k\"",
+        cxxopts::value<std::string>())(
+
         "j,json",
         "Print the output as JSON instead of tables.")(
 
+        "json-layout",
+        "The layout of the JSON output: nested, with a value for each year "
+        "of each measure, or columnar, with the years of each measure listed "
+        "once and an aligned array of values for each area",
+        cxxopts::value<std::string>()->default_value("nested"))(
+
+        "stats-only",
+        "Only print the average, difference and percentage difference of "
+        "each measure, keeping the values of each measure in a compact "
+        "series rather than a map")(
+
+        "quantiles",
+        "Print the approximate 50th, 90th and 99th percentiles of each "
+        "measure across all the areas and years imported, instead of the areas")(
+
+        "ranks",
+        "Add the rank and percentile of each area among all the areas "
+        "imported, for each measure in each year")(
+
+        "forecast",
+        "Add a projection of each measure of each area for a number of "
+        "years after its last year, from a linear trend",
+        cxxopts::value<std::string>()->default_value("0"))(
+
+        "forecast-method",
+        "The trend used by forecast: ols for a least squares line, or holt "
+        "for Holt's linear exponential smoothing",
+        cxxopts::value<std::string>()->default_value("ols"))(
+
+        "similar",
+        "Print the areas most like the area with this authority code, "
+        "comparing the values of each measure imported in one year",
+        cxxopts::value<std::string>())(
+
+        "k,neighbours",
+        "The number of areas printed by similar",
+        cxxopts::value<std::string>()->default_value("5"))(
+
+        "similar-year",
+        "The year compared by similar (omit or set to 0 to use the latest "
+        "year of each measure)",
+        cxxopts::value<std::string>()->default_value("0"))(
+
+        "memory-limit",
+        "Limit the memory used for imported data to a number of megabytes "
+        "(or use a K, M or G suffix), spilling to sorted files on disk "
+        "beyond it (omit or set to 0 to keep everything in memory). A JSON "
+        "file is still parsed whole, and a tail cache is held in memory",
+        cxxopts::value<std::string>()->default_value("0"))(
+
+        "limits",
+        "Reject data files beyond limits on the length of a line, the size "
+        "of a field or string, the nesting of JSON and the number of columns "
+        "or members, as a comma-separated list of line, field, depth and "
+        "columns, e.g. line=16M,field=1M,depth=64,columns=100000 (sizes are "
+        "in bytes, or use a K, M or G suffix)",
+        cxxopts::value<std::string>())(
+
+        "shards",
+        "Split the import and output between a number of processes, "
+        "each handling a range of authority codes",
+        cxxopts::value<std::string>()->default_value("1"))(
+
+        "shm",
+        "Share the imported data with later runs through shared memory, "
+        "reusing data shared by an earlier run if its files are unchanged. "
+        "The shared data is still copied into each run's own memory")(
+
+        "tail-cache",
+        "Remember how much of each data file has been imported in this "
+        "file, and on later runs only parse the rows appended to each file "
+        "since, parsing a file again in full if its earlier rows changed",
+        cxxopts::value<std::string>())(
+
+        "checkpoint",
+        "Save the progress of the import to this file from time to time, so "
+        "an import that is stopped part of the way through can be resumed "
+        "with resume (the file is deleted once the import finishes)",
+        cxxopts::value<std::string>())(
+
+        "resume",
+        "Continue an import that was stopped from the last progress saved "
+        "to the checkpoint file")(
+
+        "versions",
+        "Keep every version of the data imported in this file, recording "
+        "the changes from the last version each time the data imported has "
+        "changed, e.g. after the datasets were revised, and the whole data "
+        "periodically, so a version is found without replaying them all",
+        cxxopts::value<std::string>())(
+
+        "as-of",
+        "Output a version kept in the versions file instead of importing the "
+        "datasets: a version number, or a date (YYYY-MM-DD) for the latest "
+        "version recorded on or before it",
+        cxxopts::value<std::string>())(
+
+        "temp-dir",
+        "Directory for the files written when over the memory limit "
+        "(defaults to $TMPDIR or /tmp)",
+        cxxopts::value<std::string>())(
+
         "h,help",
         "Print usage.");
 
@@ -263,149 +719,795 @@ StringFilterSet BethYw::parseMeasuresArg(cxxopts::ParseResult &args)
 }
 
 /*
-    Parse the years command line argument. Years is either a four digit year
-    value, or two four digit year values separated by a hyphen (i.e. either
-    YYYY or YYYY-ZZZZ). If one or both values are 0, then there is no filter 
-    to be applied. If no year argument is given return <0,0> to import all years.
+    Parse the years command line argument. Years is a list of four digit year
+    values and ranges of two four digit year values separated by a hyphen,
+    separated by commas (e.g. YYYY, YYYY-ZZZZ or YYYY,ZZZZ-ZZZZ). If a value
+    is 0, then there is no filter to be applied. If no year argument is
+    given return an empty filter to import all years.
+
+    The filter is also the std::tuple of its lowest and highest year, which is
+    <0,0> if there is no filter.
 
     @param args
         Parsed program arguments
 
     @return
-        A std::tuple containing two unsigned ints
+        The years filter
 
     @throws
         std::invalid_argument if the argument contains an invalid years value with
         the message: Invalid input for years argument
 */
-YearFilterTuple BethYw::parseYearsArg(cxxopts::ParseResult &args)
+BethYw::YearFilter BethYw::parseYearsArg(cxxopts::ParseResult &args)
 {
     if (!args.count("years"))
     {
-        return std::tuple<unsigned int, unsigned int>{0, 0};
+        return YearFilter();
     }
 
-    // Use regex to check the year filter is valid as a whole
-    std::string inputYears = args["years"].as<std::string>();
-    std::regex yearsMatch("^([0-9]{4}|0)(-[0-9]{4}|-0)?$");
+    return YearFilter::parse(args["years"].as<std::string>());
+}
+
+/*
+    Parse the memory limit command line argument, which is a number of
+    megabytes, or a number followed by a K, M or G suffix (any case) for
+    kilobytes, megabytes or gigabytes. If the argument is not given, or is 0,
+    there is no limit.
+
+    @param args
+        Parsed program arguments
 
-    if (!std::regex_match(inputYears.begin(), inputYears.end(), yearsMatch))
+    @return
+        The memory limit in bytes, or 0 for no limit
+
+    @throws
+        std::invalid_argument if the argument is not a valid size with the
+        message: Invalid input for memory limit argument
+*/
+size_t BethYw::parseMemoryLimitArg(cxxopts::ParseResult &args)
+{
+    if (!args.count("memory-limit"))
     {
-        throw std::invalid_argument("Invalid input for years argument");
+        return 0;
     }
 
-    unsigned int startYear = 1;
-    unsigned int endYear = 1;
+    std::string inputLimit = args["memory-limit"].as<std::string>();
+    std::regex limitMatch("^([0-9]+)([kKmMgG]?)$");
+    std::smatch limit;
 
-    std::regex yearMatch("([0-9]+)");
-    std::smatch year;
-
-    // Use regex to extract the first year
-    if (std::regex_search(inputYears, year, yearMatch))
+    if (!std::regex_match(inputLimit, limit, limitMatch))
     {
-        startYear = (unsigned int)std::stoi(year[1]);
-        inputYears = year.suffix().str();
+        throw std::invalid_argument("Invalid input for memory limit argument");
     }
 
-    // Use regex to extract the second year
-    if (std::regex_search(inputYears, year, yearMatch))
+    size_t multiplier = 1024 * 1024;
+    std::string suffix = limit[2];
+    stringToLower(suffix);
+
+    if (suffix == "k")
     {
-        endYear = (unsigned int)std::stoi(year[1]);
+        multiplier = 1024;
+    }
+    else if (suffix == "g")
+    {
+        multiplier = 1024 * 1024 * 1024;
     }
 
-    // Detect the year values and return the correct filter
-    if (startYear == 0 || endYear == 0)
+    unsigned long long number;
+
+    try
     {
-        return std::tuple<unsigned int, unsigned int>{0, 0};
+        number = std::stoull(limit[1]);
     }
-    else if (endYear == 1)
+    catch(const std::out_of_range& e)
     {
-        return std::tuple<unsigned int, unsigned int>{startYear, startYear};
+        throw std::invalid_argument("Invalid input for memory limit argument");
     }
-    else
+
+    if (number > SIZE_MAX / multiplier)
     {
-        return std::tuple<unsigned int, unsigned int>{startYear, endYear};
+        throw std::invalid_argument("Invalid input for memory limit argument");
     }
+
+    return (size_t)number * multiplier;
 }
 
 /*
-    Load the areas.csv file from the directory `dir`. Parse the file and
-    create the appropriate Area objects inside the Areas object passed to
-    the function in the `areas` argument.
-
-    @param areas
-        An Areas instance that should be modified (i.e. the populate() function
-        in the instance should be called)
-
-    @param dir
-        Directory where the areas.csv file is
+    Parse the shards command line argument, which is the number of processes
+    to split the import and output between. If the argument is not given there
+    is a single process.
 
-    @param areasFilter
-        An unordered set of areas to filter, or empty to import all areas
+    @param args
+        Parsed program arguments
 
     @return
-        void
+        The number of processes, between 1 and 1024
+
+    @throws
+        std::invalid_argument if the argument is not a valid number of
+        processes with the message: Invalid input for shards argument
 */
-void BethYw::loadAreas(Areas& areas, const std::string& dir, const StringFilterSet areasFilter)
+unsigned int BethYw::parseShardsArg(cxxopts::ParseResult &args)
 {
-    InputFile file(dir + InputFiles::AREAS.FILE);
-    areas.populate(file.open(), AuthorityCodeCSV, InputFiles::AREAS.COLS, &areasFilter);
-}
-
-
-/*
-    Import datasets from `datasetsToImport` as files in `dir` into areas, and
-    filtering them with the `areasFilter`, `measuresFilter`, and `yearsFilter`.
+    if (!args.count("shards"))
+    {
+        return 1;
+    }
 
-    This function should promise not to throw an exception. If there is an
-    error/exception thrown in any function called by thus function, catch it and
-    output 'Error importing dataset:', followed by a new line and then the output
-    of the what() function on the exception.
+    std::string inputShards = args["shards"].as<std::string>();
+    std::regex shardsMatch("^[0-9]{1,4}$");
 
-    @param areas
-        An Areas instance that should be modified (i.e. datasets loaded into it)
+    if (!std::regex_match(inputShards, shardsMatch))
+    {
+        throw std::invalid_argument("Invalid input for shards argument");
+    }
 
-    @param dir
-        The directory where the datasets are
+    unsigned int shards = (unsigned int)std::stoul(inputShards);
 
-    @param datasetsToImport
-        A vector of InputFileSource objects
+    if (shards < 1 || shards > 1024)
+    {
+        throw std::invalid_argument("Invalid input for shards argument");
+    }
 
-    @param areasFilter
-        An unordered set of areas (as authority codes encoded in std::strings)
-        to filter, or empty to import all areas
+    return shards;
+}
 
-    @param measuresFilter
-        An unordered set of measures (as measure codes encoded in std::strings)
-        to filter, or empty to import all measures
+/*
+    Parse the forecast command line argument, which is the number of years
+    to project each measure. If the argument is not given nothing is
+    projected.
 
-    @param yearsFilter
-        An two-pair tuple of unsigned ints corresponding to the range of years
-        to import, which should both be 0 to import all years.
+    @param args
+        Parsed program arguments
 
     @return
-        void
+        The number of years, between 0 and 100
+
+    @throws
+        std::invalid_argument if the argument is not a valid number of years
+        with the message: Invalid input for forecast argument
 */
-void BethYw::loadDatasets(Areas& areas, const std::string& dir,
-                          const std::vector<BethYw::InputFileSource> datasetsToImport,
-                          const StringFilterSet areasFilter,
-                          const StringFilterSet measuresFilter,
-                          const YearFilterTuple yearsFilter) noexcept
+unsigned int BethYw::parseForecastArg(cxxopts::ParseResult &args)
 {
-    try
-    {   
-        BethYw::loadAreas(areas, dir, areasFilter);
+    std::string inputForecast = args["forecast"].as<std::string>();
+    std::regex forecastMatch("^[0-9]{1,3}$");
 
-        for (auto dataset : datasetsToImport)
+    if (!std::regex_match(inputForecast, forecastMatch))
+    {
+        throw std::invalid_argument("Invalid input for forecast argument");
+    }
+
+    unsigned int forecast = (unsigned int)std::stoul(inputForecast);
+
+    if (forecast > 100)
+    {
+        throw std::invalid_argument("Invalid input for forecast argument");
+    }
+
+    return forecast;
+}
+
+/*
+    Parse the forecast-method command line argument (case-insensitive).
+
+    @param args
+        Parsed program arguments
+
+    @return
+        The ForecastMethod, LeastSquares by default
+
+    @throws
+        std::invalid_argument if the argument is not ols or holt with the
+        message: Invalid input for forecast-method argument
+*/
+BethYw::ForecastMethod BethYw::parseForecastMethodArg(cxxopts::ParseResult &args)
+{
+    std::string method = args["forecast-method"].as<std::string>();
+    stringToLower(method);
+
+    if (method == "ols")
+    {
+        return LeastSquares;
+    }
+
+    if (method == "holt")
+    {
+        return Holt;
+    }
+
+    throw std::invalid_argument("Invalid input for forecast-method argument");
+}
+
+/*
+    Parse the neighbours (k) command line argument, which is the number of
+    areas printed by the similar argument.
+
+    @param args
+        Parsed program arguments
+
+    @return
+        The number of areas, between 1 and 9999
+
+    @throws
+        std::invalid_argument if the argument is not a valid number of areas
+        with the message: Invalid input for neighbours argument
+*/
+size_t BethYw::parseNeighboursArg(cxxopts::ParseResult &args)
+{
+    std::string inputK = args["neighbours"].as<std::string>();
+    std::regex kMatch("^[0-9]{1,4}$");
+
+    if (!std::regex_match(inputK, kMatch) || std::stoul(inputK) < 1)
+    {
+        throw std::invalid_argument("Invalid input for neighbours argument");
+    }
+
+    return std::stoul(inputK);
+}
+
+/*
+    Parse the similar-year command line argument, which is the year compared
+    by the similar argument.
+
+    @param args
+        Parsed program arguments
+
+    @return
+        The year, or 0 to use the latest year of each measure
+
+    @throws
+        std::invalid_argument if the argument is not a valid year with the
+        message: Invalid input for similar-year argument
+*/
+unsigned int BethYw::parseSimilarYearArg(cxxopts::ParseResult &args)
+{
+    std::string inputYear = args["similar-year"].as<std::string>();
+    std::regex yearMatch("^[0-9]{1,4}$");
+
+    if (!std::regex_match(inputYear, yearMatch))
+    {
+        throw std::invalid_argument("Invalid input for similar-year argument");
+    }
+
+    return (unsigned int)std::stoul(inputYear);
+}
+
+/*
+    Parse the json-layout command line argument (case-insensitive).
+
+    @param args
+        Parsed program arguments
+
+    @return
+        The JSONLayout, NestedLayout by default
+
+    @throws
+        std::invalid_argument if the argument is not nested or columnar with
+        the message: Invalid input for json-layout argument
+*/
+BethYw::JSONLayout BethYw::parseJSONLayoutArg(cxxopts::ParseResult &args)
+{
+    std::string layout = args["json-layout"].as<std::string>();
+    stringToLower(layout);
+
+    if (layout == "nested")
+    {
+        return NestedLayout;
+    }
+
+    if (layout == "columnar")
+    {
+        return ColumnarLayout;
+    }
+
+    throw std::invalid_argument("Invalid input for json-layout argument");
+}
+
+/*
+    Parse the where command line argument, compiling the expression (see
+    where.h).
+
+    @param args
+        Parsed program arguments
+
+    @return
+        The compiled expression, or null if the argument is not given
+
+    @throws
+        std::invalid_argument if the expression is not valid with the
+        message: Invalid input for where argument
+*/
+std::shared_ptr<const BethYw::RowPredicate> BethYw::parseWhereArg(cxxopts::ParseResult &args)
+{
+    if (!args.count("where"))
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<const RowPredicate>(args["where"].as<std::string>());
+}
+
+/*
+    Parse the limits command line argument, which is a comma-separated list of
+    limits the parsers enforce on data files (see rowstream.h), e.g.
+    line=16M,field=1M,depth=64,columns=100000. Sizes are in bytes, or a
+    number followed by a K, M or G suffix (any case). Limits that are not
+    listed keep their defaults.
+
+    @param args
+        Parsed program arguments
+
+    @return
+        The parser limits
+
+    @throws
+        std::invalid_argument if the argument is not a valid list of limits
+        with the message: Invalid input for limits argument
+*/
+BethYw::ParserLimits BethYw::parseLimitsArg(cxxopts::ParseResult &args)
+{
+    ParserLimits limits;
+
+    if (!args.count("limits"))
+    {
+        return limits;
+    }
+
+    std::stringstream inputLimits(args["limits"].as<std::string>());
+    std::string item;
+    std::regex limitMatch("^(line|field|depth|columns)=([0-9]+)([kKmMgG]?)$");
+
+    while (std::getline(inputLimits, item, ','))
+    {
+        std::smatch limit;
+
+        if (!std::regex_match(item, limit, limitMatch))
+        {
+            throw std::invalid_argument("Invalid input for limits argument");
+        }
+
+        size_t multiplier = 1;
+        std::string suffix = limit[3];
+        stringToLower(suffix);
+
+        if (suffix == "k")
+        {
+            multiplier = 1024;
+        }
+        else if (suffix == "m")
+        {
+            multiplier = 1024 * 1024;
+        }
+        else if (suffix == "g")
+        {
+            multiplier = 1024 * 1024 * 1024;
+        }
+
+        unsigned long long number;
+
+        try
+        {
+            number = std::stoull(limit[2]);
+        }
+        catch(const std::out_of_range& e)
+        {
+            throw std::invalid_argument("Invalid input for limits argument");
+        }
+
+        if (number == 0 || number > SIZE_MAX / multiplier)
+        {
+            throw std::invalid_argument("Invalid input for limits argument");
+        }
+
+        const size_t value = (size_t)number * multiplier;
+
+        if (limit[1] == "line")
+        {
+            limits.maxLineLength = value;
+        }
+        else if (limit[1] == "field")
+        {
+            limits.maxFieldSize = value;
+        }
+        else if (limit[1] == "depth")
+        {
+            limits.maxDepth = value;
+        }
+        else
+        {
+            limits.maxColumns = value;
+        }
+    }
+
+    return limits;
+}
+
+/*
+    Parse the temporary directory command line argument, falling back to the
+    TMPDIR environment variable and then the system temporary directory.
+
+    @param args
+        Parsed program arguments
+
+    @return
+        The temporary directory, including a trailing separator
+*/
+std::string BethYw::parseTempDirArg(cxxopts::ParseResult &args)
+{
+    if (args.count("temp-dir"))
+    {
+        return args["temp-dir"].as<std::string>() + DIR_SEP;
+    }
+
+    const char *tmpDir = std::getenv("TMPDIR");
+
+    if (tmpDir != nullptr && tmpDir[0] != '\0')
+    {
+        return std::string(tmpDir) + DIR_SEP;
+    }
+
+#ifdef _WIN32
+    return std::string(".") + DIR_SEP;
+#else
+    return std::string("/tmp") + DIR_SEP;
+#endif
+}
+
+/*
+    Build a key describing the data imported for a set of arguments, for
+    naming the shared memory segment it is published to. The directory is
+    resolved to an absolute path where possible, and the filters are sorted,
+    so equivalent arguments give the same key.
+
+    @param dir
+        The directory where the datasets are
+
+    @param datasetsToImport
+        A vector of InputFileSource objects
+
+    @param areasFilter
+        An unordered set of areas to filter
+
+    @param measuresFilter
+        An unordered set of measures to filter
+
+    @param yearsFilter
+        The years filter
+
+    @return
+        The key
+*/
+std::string BethYw::sharedSegmentKey(const std::string &dir,
+                                     const std::vector<BethYw::InputFileSource> &datasetsToImport,
+                                     const StringFilterSet &areasFilter,
+                                     const StringFilterSet &measuresFilter,
+                                     const YearFilter &yearsFilter,
+                                     const std::string &where)
+{
+    std::string key = dir;
+
+#ifndef _WIN32
+    char *absolute = realpath(dir.c_str(), nullptr);
+    if (absolute != nullptr)
+    {
+        key = absolute;
+        free(absolute);
+    }
+#endif
+
+    key += '\0';
+    for (auto &dataset : datasetsToImport)
+    {
+        key += dataset.CODE + ',';
+    }
+
+    for (auto filter : {&areasFilter, &measuresFilter})
+    {
+        std::vector<std::string> sorted(filter->begin(), filter->end());
+        std::sort(sorted.begin(), sorted.end());
+
+        key += '\0';
+        for (auto &it : sorted)
+        {
+            key += it + ',';
+        }
+    }
+
+    key += '\0' + yearsFilter.toString();
+
+    if (!where.empty())
+    {
+        key += '\0' + where;
+    }
+
+    return key;
+}
+
+/*
+    Load the areas.csv file from the directory `dir`. Parse the file and
+    create the appropriate Area objects inside the Areas object passed to
+    the function in the `areas` argument.
+
+    If the file is the same as the one embedded when the program was built
+    (see authorities.h), the embedded table is used rather than parsing it.
+
+    @param areas
+        An Areas instance that should be modified (i.e. the populate() function
+        in the instance should be called)
+
+    @param dir
+        Directory where the areas.csv file is
+
+    @param areasFilter
+        An unordered set of areas to filter, or empty to import all areas
+
+    @return
+        void
+*/
+void BethYw::loadAreas(Areas& areas, const std::string& dir, const StringFilterSet areasFilter)
+{
+    InputFile file(dir + InputFiles::AREAS.FILE);
+    std::istream &is = file.open();
+    const std::string contents((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    if (matchesEmbeddedAuthorities(contents))
+    {
+        size_t count = 0;
+        const Authority *authorities = embeddedAuthorities(count);
+        areas.populateFromAuthorities(authorities, count, &areasFilter);
+        return;
+    }
+
+    std::istringstream stream(contents);
+    areas.populate(stream, AuthorityCodeCSV, InputFiles::AREAS.COLS, &areasFilter);
+}
+
+
+/*
+    Import areas.csv and the datasets from `datasetsToImport` as files in `dir`
+    into areas, filtering them with the `areasFilter`, `measuresFilter`, and
+    `yearsFilter`. This is the import shared by the command line program and
+    the libbethyw library, which each report errors in their own way.
+
+    @param areas
+        An Areas instance that should be modified (i.e. datasets loaded into it)
+
+    @param dir
+        The directory where the datasets are
+
+    @param datasetsToImport
+        A vector of InputFileSource objects
+
+    @param areasFilter
+        An unordered set of areas to filter, or empty to import all areas
+
+    @param measuresFilter
+        An unordered set of measures to filter, or empty to import all measures
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @param tail
+        A cache to import each file through, so only the rows appended to it
+        since it was last imported are parsed (see tail.h), or null to parse
+        every file in full
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if a file cannot be opened or parsed
+        std::out_of_range if there are not enough columns in a dataset
+*/
+void BethYw::importDatasets(Areas& areas, const std::string& dir,
+                            const std::vector<BethYw::InputFileSource> &datasetsToImport,
+                            const StringFilterSet &areasFilter,
+                            const StringFilterSet &measuresFilter,
+                            const YearFilter &yearsFilter,
+                            TailCache *const tail)
+{
+    BethYw::loadAreas(areas, dir, areasFilter);
+
+    for (auto dataset : datasetsToImport)
+    {
+        const std::vector<std::string> files = InputFile::expand(dir + dataset.FILE);
+
+        if (tail != nullptr)
+        {
+            for (auto &file : files)
+            {
+                tail->import(areas, file, dataset, areasFilter, measuresFilter, yearsFilter);
+            }
+
+            continue;
+        }
+
+        if (files.size() > 1)
         {
-            InputFile file(dir + dataset.FILE);
-            areas.populate(file.open(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+            BethYw::importDatasetFiles(areas, files, dataset, areasFilter, measuresFilter, yearsFilter);
+            continue;
         }
+
+        InputFile file(files.front());
+        areas.populate(file.open(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, yearsFilter);
+    }
+}
+
+/*
+    Import the files of a dataset whose FILE is a directory or glob pattern
+    (see InputFile::expand()) into areas, as if they were one file.
+
+    Each file is imported into its own copy of areas (see Areas::emptyCopy())
+    on a pool of threads, which take the largest remaining file next so a
+    large file doesn't start last and hold up the rest. The copies are then
+    merged into areas in order of precedence, so the result is the same as
+    importing the files one after another.
+
+    @param areas
+        An Areas instance that should be modified (i.e. datasets loaded into it)
+
+    @param files
+        The complete paths of the files, in order of precedence
+
+    @param dataset
+        The dataset the files are parts of
+
+    @param areasFilter
+        An unordered set of areas to filter, or empty to import all areas
+
+    @param measuresFilter
+        An unordered set of measures to filter, or empty to import all measures
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @param threads
+        The number of threads to use, or 0 for one per core
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if a file cannot be opened or parsed, after the
+        files before it have been merged
+        std::out_of_range if there are not enough columns in the dataset
+*/
+void BethYw::importDatasetFiles(Areas& areas,
+                                const std::vector<std::string> &files,
+                                const BethYw::InputFileSource &dataset,
+                                const StringFilterSet &areasFilter,
+                                const StringFilterSet &measuresFilter,
+                                const YearFilter &yearsFilter,
+                                unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    threads = std::min<unsigned int>(threads, files.size());
+
+    // Schedule the largest files first
+    std::vector<uint64_t> sizes(files.size());
+    std::vector<size_t> schedule(files.size());
+
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        sizes[i] = InputFile::size(files[i]);
+        schedule[i] = i;
+    }
+
+    std::stable_sort(schedule.begin(), schedule.end(), [&sizes](size_t a, size_t b) {
+        return sizes[a] > sizes[b];
+    });
+
+    std::vector<Areas> parts;
+    parts.reserve(files.size());
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        parts.push_back(areas.emptyCopy(files.size()));
+    }
+
+    std::vector<std::exception_ptr> errors(files.size());
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next(0);
+
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < schedule.size(); i = next++)
+            {
+                const size_t part = schedule[i];
+
+                try
+                {
+                    InputFile file(files[part]);
+                    parts[part].populate(file.open(), dataset.PARSER, dataset.COLS,
+                                         &areasFilter, &measuresFilter, yearsFilter);
+                }
+                catch(...)
+                {
+                    errors[part] = std::current_exception();
+                }
+            }
+        });
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    // Merge in order of precedence, stopping at the first file with an error
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (errors[i])
+        {
+            std::rethrow_exception(errors[i]);
+        }
+
+        areas.merge(parts[i]);
+        parts[i] = Areas();
+    }
+}
+
+/*
+    Import datasets from `datasetsToImport` as files in `dir` into areas, and
+    filtering them with the `areasFilter`, `measuresFilter`, and `yearsFilter`.
+
+    This function should promise not to throw an exception. If there is an
+    error/exception thrown in any function called by thus function, catch it and
+    output 'Error importing dataset:', followed by a new line and then the output
+    of the what() function on the exception.
+
+    @param areas
+        An Areas instance that should be modified (i.e. datasets loaded into it)
+
+    @param dir
+        The directory where the datasets are
+
+    @param datasetsToImport
+        A vector of InputFileSource objects
+
+    @param areasFilter
+        An unordered set of areas (as authority codes encoded in std::strings)
+        to filter, or empty to import all areas
+
+    @param measuresFilter
+        An unordered set of measures (as measure codes encoded in std::strings)
+        to filter, or empty to import all measures
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @param tail
+        A cache to import each file through (see tail.h), or null to parse
+        every file in full
+
+    @return
+        true if every dataset was imported, false if there was an error
+*/
+bool BethYw::loadDatasets(Areas& areas, const std::string& dir,
+                          const std::vector<BethYw::InputFileSource> datasetsToImport,
+                          const StringFilterSet areasFilter,
+                          const StringFilterSet measuresFilter,
+                          const YearFilter &yearsFilter,
+                          TailCache *const tail) noexcept
+{
+    try
+    {   
+        BethYw::importDatasets(areas, dir, datasetsToImport, areasFilter, measuresFilter, yearsFilter, tail);
     }
     catch(const std::exception& e)
     {
         std::cerr << "Error importing dataset:" << std::endl << e.what() << std::endl;
+        return false;
     }
+
+    return true;
 }
 
 /*
@@ -422,6 +1524,203 @@ void BethYw::stringToLower(std::string &string)
     transform(string.begin(), string.end(), string.begin(), ::tolower);
 }
 
+namespace
+{
+    /*
+        Case folding tables for the two-byte UTF-8 range U+00C0-U+017F (Latin-1
+        Supplement letters and Latin Extended-A) and the three-byte range
+        U+1E00-U+1EFF (Latin Extended Additional, which holds the Welsh w/y
+        grave, acute and diaeresis forms).
+
+        The _FOLD tables hold the lowercase code point as an offset from the
+        start of the range. The _BASE tables hold the unaccented ASCII letter
+        for each code point, or '.' if it has none (e.g. ae, eth, sharp s).
+    */
+    const unsigned char LATIN_1_FOLD[] = {
+        0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+        0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x17, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x1F,
+        0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F,
+        0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+        0x41, 0x41, 0x43, 0x43, 0x45, 0x45, 0x47, 0x47, 0x49, 0x49, 0x4B, 0x4B, 0x4D, 0x4D, 0x4F, 0x4F,
+        0x51, 0x51, 0x53, 0x53, 0x55, 0x55, 0x57, 0x57, 0x59, 0x59, 0x5B, 0x5B, 0x5D, 0x5D, 0x5F, 0x5F,
+        0x61, 0x61, 0x63, 0x63, 0x65, 0x65, 0x67, 0x67, 0x69, 0x69, 0x6B, 0x6B, 0x6D, 0x6D, 0x6F, 0x6F,
+        0x70, 0x71, 0x73, 0x73, 0x75, 0x75, 0x77, 0x77, 0x78, 0x7A, 0x7A, 0x7C, 0x7C, 0x7E, 0x7E, 0x80,
+        0x80, 0x82, 0x82, 0x84, 0x84, 0x86, 0x86, 0x88, 0x88, 0x89, 0x8B, 0x8B, 0x8D, 0x8D, 0x8F, 0x8F,
+        0x91, 0x91, 0x93, 0x93, 0x95, 0x95, 0x97, 0x97, 0x99, 0x99, 0x9B, 0x9B, 0x9D, 0x9D, 0x9F, 0x9F,
+        0xA1, 0xA1, 0xA3, 0xA3, 0xA5, 0xA5, 0xA7, 0xA7, 0xA9, 0xA9, 0xAB, 0xAB, 0xAD, 0xAD, 0xAF, 0xAF,
+        0xB1, 0xB1, 0xB3, 0xB3, 0xB5, 0xB5, 0xB7, 0xB7, 0x3F, 0xBA, 0xBA, 0xBC, 0xBC, 0xBE, 0xBE, 0xBF,
+    };
+    const char LATIN_1_BASE[] =
+        "aaaaaa.ceeeeiiii.nooooo..uuuuy..aaaaaa.ceeeeiiii.nooooo..uuuuy.y"
+        "aaaaaaccccccccdd..eeeeeeeeeegggggggghh..iiiiiiiii...jjkk.llllll."
+        "...nnnnnn...oooooo..rrrrrrsssssssstttt..uuuuuuuuuuuuwwyyyzzzzzz.";
+    const unsigned char LATIN_EXTENDED_ADDITIONAL_FOLD[] = {
+        0x01, 0x01, 0x03, 0x03, 0x05, 0x05, 0x07, 0x07, 0x09, 0x09, 0x0B, 0x0B, 0x0D, 0x0D, 0x0F, 0x0F,
+        0x11, 0x11, 0x13, 0x13, 0x15, 0x15, 0x17, 0x17, 0x19, 0x19, 0x1B, 0x1B, 0x1D, 0x1D, 0x1F, 0x1F,
+        0x21, 0x21, 0x23, 0x23, 0x25, 0x25, 0x27, 0x27, 0x29, 0x29, 0x2B, 0x2B, 0x2D, 0x2D, 0x2F, 0x2F,
+        0x31, 0x31, 0x33, 0x33, 0x35, 0x35, 0x37, 0x37, 0x39, 0x39, 0x3B, 0x3B, 0x3D, 0x3D, 0x3F, 0x3F,
+        0x41, 0x41, 0x43, 0x43, 0x45, 0x45, 0x47, 0x47, 0x49, 0x49, 0x4B, 0x4B, 0x4D, 0x4D, 0x4F, 0x4F,
+        0x51, 0x51, 0x53, 0x53, 0x55, 0x55, 0x57, 0x57, 0x59, 0x59, 0x5B, 0x5B, 0x5D, 0x5D, 0x5F, 0x5F,
+        0x61, 0x61, 0x63, 0x63, 0x65, 0x65, 0x67, 0x67, 0x69, 0x69, 0x6B, 0x6B, 0x6D, 0x6D, 0x6F, 0x6F,
+        0x71, 0x71, 0x73, 0x73, 0x75, 0x75, 0x77, 0x77, 0x79, 0x79, 0x7B, 0x7B, 0x7D, 0x7D, 0x7F, 0x7F,
+        0x81, 0x81, 0x83, 0x83, 0x85, 0x85, 0x87, 0x87, 0x89, 0x89, 0x8B, 0x8B, 0x8D, 0x8D, 0x8F, 0x8F,
+        0x91, 0x91, 0x93, 0x93, 0x95, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x9E, 0x9F,
+        0xA1, 0xA1, 0xA3, 0xA3, 0xA5, 0xA5, 0xA7, 0xA7, 0xA9, 0xA9, 0xAB, 0xAB, 0xAD, 0xAD, 0xAF, 0xAF,
+        0xB1, 0xB1, 0xB3, 0xB3, 0xB5, 0xB5, 0xB7, 0xB7, 0xB9, 0xB9, 0xBB, 0xBB, 0xBD, 0xBD, 0xBF, 0xBF,
+        0xC1, 0xC1, 0xC3, 0xC3, 0xC5, 0xC5, 0xC7, 0xC7, 0xC9, 0xC9, 0xCB, 0xCB, 0xCD, 0xCD, 0xCF, 0xCF,
+        0xD1, 0xD1, 0xD3, 0xD3, 0xD5, 0xD5, 0xD7, 0xD7, 0xD9, 0xD9, 0xDB, 0xDB, 0xDD, 0xDD, 0xDF, 0xDF,
+        0xE1, 0xE1, 0xE3, 0xE3, 0xE5, 0xE5, 0xE7, 0xE7, 0xE9, 0xE9, 0xEB, 0xEB, 0xED, 0xED, 0xEF, 0xEF,
+        0xF1, 0xF1, 0xF3, 0xF3, 0xF5, 0xF5, 0xF7, 0xF7, 0xF9, 0xF9, 0xFB, 0xFB, 0xFD, 0xFD, 0xFF, 0xFF,
+    };
+    const char LATIN_EXTENDED_ADDITIONAL_BASE[] =
+        "aabbbbbbccddddddddddeeeeeeeeeeffgghhhhhhhhhhiiiikkkkkkllllllllmm"
+        "mmmmnnnnnnnnoooooooopppprrrrrrrrssssssssssttttttttuuuuuuuuuuvvvv"
+        "wwwwwwwwwwxxxxyyzzzzzzhtwy......aaaaaaaaaaaaaaaaaaaaaaaaeeeeeeee"
+        "eeeeeeeeiiiioooooooooooooooooooooooouuuuuuuuuuuuuuyyyyyyyy......";
+
+    /*
+        Append a code point to a string encoded as UTF-8.
+
+        @param string
+            The string to append to
+
+        @param codePoint
+            The code point to encode
+
+        @return
+            void
+    */
+    void appendUtf8(std::string &string, const unsigned int codePoint)
+    {
+        if (codePoint < 0x80)
+        {
+            string += (char)codePoint;
+        }
+        else if (codePoint < 0x800)
+        {
+            string += (char)(0xC0 | (codePoint >> 6));
+            string += (char)(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            string += (char)(0xE0 | (codePoint >> 12));
+            string += (char)(0x80 | ((codePoint >> 6) & 0x3F));
+            string += (char)(0x80 | (codePoint & 0x3F));
+        }
+    }
+}
+
+/*
+    Case fold a UTF-8 string for case-insensitive comparison. ASCII letters are
+    lowercased, as are accented Latin letters (e.g. Ô, Ŵ and Ẁ). Optionally
+    accents can also be stripped so that "Ynys Mon" matches "Ynys Môn". Any
+    other bytes, including malformed UTF-8, are copied through unchanged.
+
+    @param string
+        The UTF-8 string to fold
+
+    @param stripAccents
+        Whether to replace accented letters with their unaccented ASCII letter
+
+    @return
+        The folded string
+ */
+std::string BethYw::foldCase(const std::string &string, const bool stripAccents)
+{
+    std::string folded;
+    folded.reserve(string.size());
+
+    const size_t length = string.size();
+    for (size_t i = 0; i < length; i++)
+    {
+        const unsigned char c = string[i];
+
+        if (c < 0x80)
+        {
+            folded += (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : (char)c;
+            continue;
+        }
+
+        unsigned int codePoint = 0;
+        size_t width = 0;
+
+        if ((c & 0xE0) == 0xC0 && i + 1 < length)
+        {
+            codePoint = ((c & 0x1F) << 6) | (string[i + 1] & 0x3F);
+            width = 2;
+        }
+        else if ((c & 0xF0) == 0xE0 && i + 2 < length)
+        {
+            codePoint = ((c & 0x0F) << 12) | ((string[i + 1] & 0x3F) << 6) | (string[i + 2] & 0x3F);
+            width = 3;
+        }
+
+        const unsigned char *foldTable = nullptr;
+        const char *baseTable = nullptr;
+        unsigned int rangeStart = 0;
+
+        if (codePoint >= 0xC0 && codePoint <= 0x17F)
+        {
+            foldTable = LATIN_1_FOLD;
+            baseTable = LATIN_1_BASE;
+            rangeStart = 0xC0;
+        }
+        else if (codePoint >= 0x1E00 && codePoint <= 0x1EFF)
+        {
+            foldTable = LATIN_EXTENDED_ADDITIONAL_FOLD;
+            baseTable = LATIN_EXTENDED_ADDITIONAL_BASE;
+            rangeStart = 0x1E00;
+        }
+
+        if (foldTable == nullptr)
+        {
+            // Not a letter we know how to fold, so copy the byte through
+            folded += (char)c;
+            continue;
+        }
+
+        const unsigned int offset = codePoint - rangeStart;
+
+        if (stripAccents && baseTable[offset] != '.')
+        {
+            folded += baseTable[offset];
+        }
+        else
+        {
+            appendUtf8(folded, rangeStart + foldTable[offset]);
+        }
+
+        i += width - 1;
+    }
+
+    return folded;
+}
+
+/*
+    Case fold (and strip the accents of) every string in a filter set, so
+    that the filter can be compared directly against precomputed search keys.
+
+    @param set
+        A pointer to the string set to fold, which may be null
+
+    @return
+        The folded strings, or an empty vector if the set is null or empty
+ */
+FoldedFilter BethYw::foldStringSet(const StringFilterSet *const set)
+{
+    FoldedFilter folded;
+
+    if (set != nullptr)
+    {
+        for (auto &it : *set)
+        {
+            folded.push_back(foldCase(it, true));
+        }
+    }
+
+    return folded;
+}
+
 /*
     Takes a string vector and converts each string to lowercase.
 
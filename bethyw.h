@@ -20,6 +20,8 @@
 
 #include "datasets.h"
 #include "areas.h"
+#include "forecast.h"
+#include "where.h"
 
 const char DIR_SEP =
 #ifdef _WIN32
@@ -30,21 +32,66 @@ const char DIR_SEP =
 
 namespace BethYw
 {
+    class TailCache;
+
     const std::string STUDENT_NUMBER = "991368";
+
+    /*
+        The layout of the JSON output (see Areas::writeJSON() and
+        Areas::writeColumnarJSON()).
+    */
+    enum JSONLayout
+    {
+        NestedLayout,
+        ColumnarLayout
+    };
+
     int run(int argc, char *argv[]);
     cxxopts::Options cxxoptsSetup();
     std::vector<BethYw::InputFileSource> parseDatasetsArg(cxxopts::ParseResult &args);
     StringFilterSet parseAreasArg(cxxopts::ParseResult &args);
     StringFilterSet parseMeasuresArg(cxxopts::ParseResult &args);
-    YearFilterTuple parseYearsArg(cxxopts::ParseResult &args);
+    YearFilter parseYearsArg(cxxopts::ParseResult &args);
+    size_t parseMemoryLimitArg(cxxopts::ParseResult &args);
+    unsigned int parseShardsArg(cxxopts::ParseResult &args);
+    unsigned int parseForecastArg(cxxopts::ParseResult &args);
+    ForecastMethod parseForecastMethodArg(cxxopts::ParseResult &args);
+    size_t parseNeighboursArg(cxxopts::ParseResult &args);
+    unsigned int parseSimilarYearArg(cxxopts::ParseResult &args);
+    JSONLayout parseJSONLayoutArg(cxxopts::ParseResult &args);
+    std::shared_ptr<const RowPredicate> parseWhereArg(cxxopts::ParseResult &args);
+    ParserLimits parseLimitsArg(cxxopts::ParseResult &args);
+    std::string parseTempDirArg(cxxopts::ParseResult &args);
     void loadAreas(Areas& areas, const std::string& dir, const StringFilterSet areasFilter);
-    void loadDatasets(Areas& areas, const std::string& dir,
+    std::string sharedSegmentKey(const std::string &dir,
+                                 const std::vector<BethYw::InputFileSource> &datasetsToImport,
+                                 const StringFilterSet &areasFilter,
+                                 const StringFilterSet &measuresFilter,
+                                 const YearFilter &yearsFilter,
+                                 const std::string &where = "");
+    void importDatasets(Areas& areas, const std::string& dir,
+                        const std::vector<BethYw::InputFileSource> &datasetsToImport,
+                        const StringFilterSet &areasFilter,
+                        const StringFilterSet &measuresFilter,
+                        const YearFilter &yearsFilter,
+                        TailCache *const tail = nullptr);
+    void importDatasetFiles(Areas& areas,
+                            const std::vector<std::string> &files,
+                            const BethYw::InputFileSource &dataset,
+                            const StringFilterSet &areasFilter,
+                            const StringFilterSet &measuresFilter,
+                            const YearFilter &yearsFilter,
+                            unsigned int threads = 0);
+    bool loadDatasets(Areas& areas, const std::string& dir,
                       const std::vector<BethYw::InputFileSource> datasetsToImport,
                       const StringFilterSet areasFilter,
                       const StringFilterSet measuresFilter,
-                      const YearFilterTuple yearsFilter) noexcept;
+                      const YearFilter &yearsFilter,
+                      TailCache *const tail = nullptr) noexcept;
 
     void stringToLower(std::string &string);
+    std::string foldCase(const std::string &string, const bool stripAccents = false);
+    FoldedFilter foldStringSet(const StringFilterSet *const set);
     void stringVectorToLower(std::vector<std::string> &vector);
     std::unordered_set<std::string> stringVectorToUnorderedSet(const std::vector<std::string> &vector);
 }
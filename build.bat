@@ -2,9 +2,10 @@
 
 SET bin_dir=bin
 SET tests_dir=tests
-SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp
+SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp store.cpp shards.cpp shm.cpp numeric.cpp quantiles.cpp rowstream.cpp ranks.cpp forecast.cpp similar.cpp where.cpp years.cpp gsscode.cpp authorities.cpp tail.cpp versions.cpp
 SET main_file=main.cpp
 SET executable=%bin_dir%\bethyw.exe
+SET extra_flags=
 
 COPY bin\bethyw2.exe bin\bethyw.exe
 
@@ -13,7 +14,7 @@ IF "%1"=="" GOTO compile
 SET testStr=%1%
 SET testStr=%testStr:~0,4%
 IF %testStr%==test (
-  SET source_files=%source_files% %tests_dir%\%1%.cpp
+  SET source_files=%source_files% libbethyw.cpp %tests_dir%\%1%.cpp
   SET main_file=%bin_dir%\catch.o
   SET executable=%bin_dir%\bethyw-test.exe
 
@@ -21,10 +22,21 @@ IF %testStr%==test (
      g++ --std=c++11 -c lib_catch_main.cpp -o %bin_dir%\catch.o
   )
 )
+IF "%1"=="authorities" (
+  IF NOT EXIST %bin_dir% MKDIR %bin_dir%
+  g++ --std=c++14 -Wall genauthorities.cpp gsscode.cpp -o %bin_dir%\genauthorities.exe
+  %bin_dir%\genauthorities.exe datasets\areas.csv authorities_table.h
+)
+IF "%1"=="lib" (
+  SET source_files=%source_files% libbethyw.cpp
+  SET main_file=
+  SET executable=%bin_dir%\libbethyw.dll
+  SET extra_flags=-shared
+)
 
 :compile
 IF NOT EXIST %bin_dir% MKDIR %bin_dir%
 IF EXIST %executable% DEL %executable%
-g++ --std=c++14 -Wall %source_files% %main_file% -o %executable%
+g++ --std=c++14 -Wall -pthread %extra_flags% %source_files% %main_file% -o %executable%
 
 :end
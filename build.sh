@@ -2,19 +2,20 @@
 
 BIN_DIR="bin"
 TESTS_DIR="tests"
-SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp"
+SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp store.cpp shards.cpp shm.cpp numeric.cpp quantiles.cpp rowstream.cpp ranks.cpp forecast.cpp similar.cpp where.cpp years.cpp gsscode.cpp authorities.cpp tail.cpp versions.cpp"
 MAIN_FILE="main.cpp"
 EXECUTABLE="./${BIN_DIR}/bethyw"
+EXTRA_FLAGS=""
 
 set -x
 cd "${0%/*}"
 
 if [ $# -gt 1 ]; then
-  echo "Unknown arguments!" "Only one argument accepted, and must begin with test"
+  echo "Unknown arguments!" "Only one argument accepted, and must be lib, authorities or begin with test"
   exit
 elif [ $# -eq 1 ]; then
   if [[ $1 == test* ]]; then
-    SOURCE_FILES="${SOURCE_FILES} ./${TESTS_DIR}/$1.cpp"
+    SOURCE_FILES="${SOURCE_FILES} libbethyw.cpp ./${TESTS_DIR}/$1.cpp"
     MAIN_FILE="./${BIN_DIR}/catch.o"
     EXECUTABLE="./${BIN_DIR}/bethyw-test"
 
@@ -22,9 +23,20 @@ elif [ $# -eq 1 ]; then
     if [ ! -f ./${BIN_DIR}/catch.o ]; then
       g++ --std=c++11 -c ./lib_catch_main.cpp -o ./${BIN_DIR}/catch.o
     fi
+  elif [[ $1 == lib ]]; then
+    SOURCE_FILES="${SOURCE_FILES} libbethyw.cpp"
+    MAIN_FILE=""
+    EXECUTABLE="./${BIN_DIR}/libbethyw.so"
+    EXTRA_FLAGS="-shared -fPIC -fvisibility=hidden"
+  elif [[ $1 == authorities ]]; then
+    # Regenerate the embedded table of local authorities (see authorities.h)
+    # from areas.csv, and then build the program as usual
+    mkdir -p ${BIN_DIR}
+    g++ --std=c++14 -pedantic -Wall genauthorities.cpp gsscode.cpp -o ./${BIN_DIR}/genauthorities || exit 1
+    ./${BIN_DIR}/genauthorities datasets/areas.csv authorities_table.h || exit 1
   fi
 fi
 
 mkdir -p ${BIN_DIR}
 rm ${EXECUTABLE} 2> /dev/null
-g++ --std=c++14 -pedantic -Wall ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE}
\ No newline at end of file
+g++ --std=c++14 -pedantic -Wall -pthread ${EXTRA_FLAGS} ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE}
\ No newline at end of file
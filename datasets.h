@@ -50,7 +50,8 @@ enum SourceDataType {
   None,
   AuthorityCodeCSV,
   WelshStatsJSON,
-  AuthorityByYearCSV
+  AuthorityByYearCSV,
+  WelshStatsJSONL
 };
 
 /*
@@ -94,7 +95,10 @@ struct InputFileSource {
   // NAME is the name given to this dataset
   const std::string NAME;
 
-  // FILE is the name of the file in the datasets directory
+  // FILE is the name of the file in the datasets directory, or of a
+  // subdirectory or glob pattern (e.g. "pop/release-*.csv") for a dataset
+  // split across several files, which are imported as one dataset (see
+  // InputFile::expand())
   const std::string FILE;
 
   // PARSER is a SourceDataType that tells the populate() function in Areas how
@@ -0,0 +1,252 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the trend fitting and
+    forecasting of each series.
+*/
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "forecast.h"
+
+namespace
+{
+    /*
+        The projected values of one series.
+    */
+    struct Forecast
+    {
+        std::string localAuthorityCode;
+        std::string codename;
+        std::string label;
+        std::vector<unsigned int> years;
+        std::vector<double> values;
+    };
+}
+
+/*
+    Project the trend to a year.
+
+    @param year
+        The year
+
+    @return
+        The value of the trend in that year
+*/
+double BethYw::Trend::project(const unsigned int year) const noexcept
+{
+    return intercept + slope * year;
+}
+
+/*
+    Fit an ordinary least squares line to a series. The years are centred on
+    their mean before the sums are taken, which keeps the sums small enough
+    to be accurate.
+
+    @param years
+        The years of the series, in increasing order
+
+    @param values
+        The value for each year
+
+    @param length
+        The number of years
+
+    @param trend
+        Set to the fitted line
+
+    @return
+        true if the line was fitted, false if there are fewer than two years
+*/
+bool BethYw::fitLeastSquares(const unsigned int *years, const double *values, const size_t length,
+                             Trend &trend) noexcept
+{
+    if (length < 2)
+    {
+        return false;
+    }
+
+    double sumX = 0;
+    double sumY = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        sumX += years[i];
+        sumY += values[i];
+    }
+
+    const double meanX = sumX / length;
+    const double meanY = sumY / length;
+    double sumXX = 0;
+    double sumXY = 0;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        const double x = years[i] - meanX;
+        sumXX += x * x;
+        sumXY += x * (values[i] - meanY);
+    }
+
+    trend.slope = sumXY / sumXX;
+    trend.intercept = meanY - trend.slope * meanX;
+
+    return true;
+}
+
+/*
+    Fit Holt's linear exponential smoothing to a series. The level starts at
+    the first value and the trend at the change to the second. Where there is
+    a gap between years the level is moved along the trend for the whole gap
+    and the trend is measured per year, so gaps are handled the same as
+    consecutive years.
+
+    @param years
+        The years of the series, in increasing order
+
+    @param values
+        The value for each year
+
+    @param length
+        The number of years
+
+    @param trend
+        Set to the line through the final level with the final trend
+
+    @return
+        true if the series was fitted, false if there are fewer than two years
+*/
+bool BethYw::fitHolt(const unsigned int *years, const double *values, const size_t length,
+                     Trend &trend) noexcept
+{
+    if (length < 2)
+    {
+        return false;
+    }
+
+    double level = values[0];
+    double slope = (values[1] - values[0]) / (double)(years[1] - years[0]);
+
+    for (size_t i = 1; i < length; i++)
+    {
+        const double gap = years[i] - years[i - 1];
+        const double previous = level;
+        level = HOLT_ALPHA * values[i] + (1 - HOLT_ALPHA) * (level + slope * gap);
+        slope = HOLT_BETA * (level - previous) / gap + (1 - HOLT_BETA) * slope;
+    }
+
+    trend.slope = slope;
+    trend.intercept = level - slope * years[length - 1];
+
+    return true;
+}
+
+/*
+    Project every series a number of years past its last year, and add the
+    projections to the areas as derived Measures (see forecast.h). Each
+    thread fits every nth Area, and the projections are added once all the
+    threads have finished. Series with fewer than two values are skipped.
+
+    @param areas
+        The Areas to project, which must all be in memory
+
+    @param horizon
+        The number of years to project
+
+    @param method
+        The method used to fit each series
+
+    @param threads
+        The number of threads to use, or 0 to use one per hardware thread
+
+    @return
+        void
+*/
+void BethYw::addForecasts(Areas &areas, const unsigned int horizon, const ForecastMethod method,
+                          unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    auto fit = method == Holt ? fitHolt : fitLeastSquares;
+    std::vector<std::vector<Forecast>> forecasts(threads);
+    std::vector<std::thread> workers;
+
+    auto forecastAreas = [&](const unsigned int t) {
+        std::vector<unsigned int> years;
+        std::vector<double> values;
+        size_t index = 0;
+
+        areas.forEachArea([&](const Area &area) {
+            if (index++ % threads != t)
+            {
+                return;
+            }
+
+            for (auto &measure : area.getMeasures())
+            {
+                years.clear();
+                values.clear();
+
+                for (auto &value : measure.second.getValues())
+                {
+                    years.push_back(value.first);
+                    values.push_back(value.second);
+                }
+
+                Trend trend;
+                if (!fit(years.data(), values.data(), years.size(), trend))
+                {
+                    continue;
+                }
+
+                Forecast forecast;
+                forecast.localAuthorityCode = area.getLocalAuthorityCode();
+                forecast.codename = measure.first;
+                forecast.label = measure.second.getLabel();
+
+                for (unsigned int year = years.back() + 1; year <= years.back() + horizon; year++)
+                {
+                    forecast.years.push_back(year);
+                    forecast.values.push_back(trend.project(year));
+                }
+
+                forecasts[t].push_back(std::move(forecast));
+            }
+        });
+    };
+
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        workers.emplace_back(forecastAreas, t);
+    }
+
+    forecastAreas(0);
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (auto &partial : forecasts)
+    {
+        for (auto &forecast : partial)
+        {
+            Measure &measure = areas.getArea(forecast.localAuthorityCode)
+                                   .emplaceMeasure(forecast.codename + FORECAST_SUFFIX,
+                                                   forecast.label + " forecast");
+
+            for (size_t i = 0; i < forecast.years.size(); i++)
+            {
+                measure.setValue(forecast.years[i], forecast.values[i]);
+            }
+        }
+    }
+}
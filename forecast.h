@@ -0,0 +1,71 @@
+#ifndef FORECAST_H_
+#define FORECAST_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for fitting a linear trend to every
+    series (the values of one Measure of one Area) and projecting it a few
+    years ahead.
+
+    The projected values are added to each Area as a derived Measure, e.g.
+    "pop-forecast", with a value for each of the years after the last year
+    of "pop", so they are never mixed up with the real values.
+
+    Each series is copied into dense arrays of years and values, which the
+    fitting functions read in a single loop. The years are used as they are,
+    so a series with gaps is fitted against the years it has.
+*/
+
+#include <cstddef>
+#include <string>
+
+#include "areas.h"
+
+namespace BethYw
+{
+    /*
+        The suffix of the codenames of the derived Measures.
+    */
+    const std::string FORECAST_SUFFIX = "-forecast";
+
+    /*
+        The method used to project each series.
+
+        LeastSquares  An ordinary least squares line through every value.
+        Holt          Holt's linear exponential smoothing, which follows
+                      recent changes in the trend more closely.
+    */
+    enum ForecastMethod
+    {
+        LeastSquares,
+        Holt
+    };
+
+    /*
+        The smoothing factors of the level and trend for ForecastMethod::Holt.
+    */
+    constexpr double HOLT_ALPHA = 0.5;
+    constexpr double HOLT_BETA = 0.3;
+
+    /*
+        A fitted trend, which projects a year to a value.
+    */
+    struct Trend
+    {
+        double slope;
+        double intercept;
+        double project(const unsigned int year) const noexcept;
+    };
+
+    bool fitLeastSquares(const unsigned int *years, const double *values, const size_t length, Trend &trend) noexcept;
+    bool fitHolt(const unsigned int *years, const double *values, const size_t length, Trend &trend) noexcept;
+    void addForecasts(Areas &areas, const unsigned int horizon, const ForecastMethod method,
+                      unsigned int threads = 0);
+}
+
+#endif // FORECAST_H_
@@ -0,0 +1,291 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the build step that generates authorities_table.h from
+    areas.csv (see authorities.h). It is built and run by:
+
+        ./build.sh authorities
+
+    The perfect hash is found with hash and displace: the codes are split
+    into buckets by a first hash, and then, largest bucket first, each bucket
+    is given the smallest displacement for which a second hash puts all its
+    codes in slots that are still free. With half as many buckets as codes
+    this takes a few thousand attempts at most.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "authorities.h"
+#include "gsscode.h"
+
+namespace
+{
+    struct Row
+    {
+        std::string code;
+        std::string eng;
+        std::string cym;
+        uint64_t key;
+    };
+
+    /*
+        Split text at a delimiter with the same results as the import
+        pipeline (see BethYw::splitFields()).
+    */
+    std::vector<std::string> split(const std::string &text, const char delimiter)
+    {
+        std::vector<std::string> parts;
+        std::istringstream stream(text);
+        std::string part;
+
+        while (std::getline(stream, part, delimiter))
+        {
+            parts.push_back(part);
+        }
+
+        return parts;
+    }
+
+    /*
+        Write a string as a C++ string literal, escaping anything that is not
+        printable ASCII so the generated file does not depend on the source
+        character set.
+    */
+    std::string literal(const std::string &text)
+    {
+        std::ostringstream out;
+        out << '"';
+
+        for (const unsigned char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out << '\\' << c;
+            }
+            else if (c < 0x20 || c >= 0x7F)
+            {
+                out << '\\' << std::oct << std::setw(3) << std::setfill('0') << (unsigned int)c << std::dec;
+            }
+            else
+            {
+                out << c;
+            }
+        }
+
+        out << '"';
+        return out.str();
+    }
+
+    /*
+        The same FNV-1a hash as BethYw::hashBytes(), which the program uses
+        to check the fingerprint.
+    */
+    uint64_t fingerprint(const std::string &bytes)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+
+        for (const unsigned char c : bytes)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc != 3)
+    {
+        std::cerr << "Usage: genauthorities AREAS_CSV OUTPUT_HEADER" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+
+    if (!file.is_open())
+    {
+        std::cerr << "Cannot open " << argv[1] << std::endl;
+        return 1;
+    }
+
+    const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<std::string> lines = split(contents, '\n');
+    std::vector<Row> rows;
+
+    for (size_t i = 1; i < lines.size(); i++)
+    {
+        const std::vector<std::string> fields = split(lines[i], ',');
+
+        if (fields.size() < 3)
+        {
+            std::cerr << "Malformed line " << i + 1 << " in " << argv[1] << std::endl;
+            return 1;
+        }
+
+        BethYw::GssCode code(fields[0]);
+
+        if (!code.isPacked())
+        {
+            std::cerr << fields[0] << " is not a GSS code, so areas.csv cannot be embedded" << std::endl;
+            return 1;
+        }
+
+        rows.push_back(Row{fields[0], fields[1], fields[2], code.getPacked()});
+    }
+
+    if (rows.empty())
+    {
+        std::cerr << "No areas in " << argv[1] << std::endl;
+        return 1;
+    }
+
+    // Duplicate codes would always collide, so no perfect hash could be found
+    std::vector<uint64_t> keys;
+    for (auto &row : rows)
+    {
+        keys.push_back(row.key);
+    }
+
+    std::sort(keys.begin(), keys.end());
+
+    if (std::adjacent_find(keys.begin(), keys.end()) != keys.end())
+    {
+        std::cerr << "A code is in " << argv[1] << " more than once" << std::endl;
+        return 1;
+    }
+
+    const size_t count = rows.size();
+    const size_t bucketCount = (count + 1) / 2;
+
+    std::vector<std::vector<size_t>> buckets(bucketCount);
+    for (size_t i = 0; i < count; i++)
+    {
+        buckets[BethYw::authorityHash(rows[i].key, 0) % bucketCount].push_back(i);
+    }
+
+    std::vector<size_t> bucketOrder(bucketCount);
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        bucketOrder[i] = i;
+    }
+
+    std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&buckets](size_t a, size_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::vector<uint32_t> displacements(bucketCount, 0);
+    std::vector<long> slots(count, -1);
+
+    for (const size_t bucket : bucketOrder)
+    {
+        if (buckets[bucket].empty())
+        {
+            continue;
+        }
+
+        for (uint32_t displacement = 1; ; displacement++)
+        {
+            if (displacement == UINT32_MAX)
+            {
+                std::cerr << "Could not find a perfect hash" << std::endl;
+                return 1;
+            }
+
+            std::vector<size_t> chosen;
+            for (const size_t row : buckets[bucket])
+            {
+                const size_t slot = BethYw::authorityHash(rows[row].key, displacement) % count;
+
+                if (slots[slot] != -1 || std::find(chosen.begin(), chosen.end(), slot) != chosen.end())
+                {
+                    chosen.clear();
+                    break;
+                }
+
+                chosen.push_back(slot);
+            }
+
+            if (chosen.size() == buckets[bucket].size())
+            {
+                for (size_t i = 0; i < chosen.size(); i++)
+                {
+                    slots[chosen[i]] = buckets[bucket][i];
+                }
+
+                displacements[bucket] = displacement;
+                break;
+            }
+        }
+    }
+
+    std::ofstream out(argv[2], std::ios::binary);
+
+    if (!out.is_open())
+    {
+        std::cerr << "Cannot write " << argv[2] << std::endl;
+        return 1;
+    }
+
+    out << "#ifndef AUTHORITIES_TABLE_H_\n"
+           "#define AUTHORITIES_TABLE_H_\n"
+           "\n"
+           "/*\n"
+           "    Generated by genauthorities.cpp from areas.csv. Do not edit, but\n"
+           "    regenerate with ./build.sh authorities (see authorities.h).\n"
+           "*/\n"
+           "\n"
+           "#include <cstddef>\n"
+           "#include <cstdint>\n"
+           "\n"
+           "#include \"authorities.h\"\n"
+           "\n"
+           "namespace BethYw\n"
+           "{\n"
+           "    namespace EmbeddedAuthorities\n"
+           "    {\n"
+           "        constexpr size_t FILE_SIZE = " << contents.size() << ";\n"
+           "        constexpr uint64_t FILE_HASH = 0x" << std::hex << fingerprint(contents) << std::dec << "ULL;\n"
+           "\n"
+           "        constexpr size_t COUNT = " << count << ";\n"
+           "        constexpr size_t BUCKETS = " << bucketCount << ";\n"
+           "\n"
+           "        constexpr uint32_t DISPLACEMENTS[BUCKETS] = {";
+
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        out << (i % 12 == 0 ? "\n            " : " ") << displacements[i] << (i + 1 < bucketCount ? "," : "");
+    }
+
+    out << "\n        };\n"
+           "\n"
+           "        // By slot of the perfect hash\n"
+           "        constexpr Authority TABLE[COUNT] = {\n";
+
+    for (size_t slot = 0; slot < count; slot++)
+    {
+        const Row &row = rows[slots[slot]];
+        out << "            {" << literal(row.code) << ", " << literal(row.eng) << ", " << literal(row.cym) << "}"
+            << (slot + 1 < count ? "," : "") << "\n";
+    }
+
+    out << "        };\n"
+           "    }\n"
+           "}\n"
+           "\n"
+           "#endif // AUTHORITIES_TABLE_H_\n";
+
+    return out.good() ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the GssCode class and the radix
+    sort of integer keys.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_set>
+
+#include "gsscode.h"
+
+namespace
+{
+    /*
+        The interned codes. The nodes of an unordered_set are never moved, so
+        pointers to the strings stay valid as more are added, and reading a
+        string through its pointer does not need the lock.
+    */
+    std::unordered_set<std::string> &internedCodes()
+    {
+        static std::unordered_set<std::string> codes;
+        return codes;
+    }
+
+    std::mutex &internedCodesMutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    /*
+        Write a packed code back out as its nine characters.
+    */
+    void unpack(const uint64_t packed, char text[9])
+    {
+        text[0] = (char)('A' + (packed >> 27));
+
+        uint64_t digits = packed & ((1 << 27) - 1);
+        for (int i = 8; i > 0; i--)
+        {
+            text[i] = (char)('0' + digits % 10);
+            digits /= 10;
+        }
+    }
+}
+
+/*
+    Construct the key for a local authority code, interning the code if it
+    cannot be packed.
+
+    @param code
+        The local authority code
+*/
+BethYw::GssCode::GssCode(const std::string &code)
+{
+    if (pack(code, packed))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(internedCodesMutex());
+    interned = &*internedCodes().insert(code).first;
+}
+
+/*
+    Find the key for a local authority code without interning it, e.g. to
+    look up a code that may not have been imported. A code that cannot be
+    packed and has never been interned cannot be a key of anything.
+
+    @param code
+        The local authority code
+
+    @param found
+        Set to the key, if there is one
+
+    @return
+        true if there is a key for the code
+*/
+bool BethYw::GssCode::find(const std::string &code, GssCode &found) noexcept
+{
+    uint64_t packed = 0;
+
+    if (pack(code, packed))
+    {
+        found.packed = packed;
+        found.interned = nullptr;
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(internedCodesMutex());
+    auto it = internedCodes().find(code);
+
+    if (it == internedCodes().end())
+    {
+        return false;
+    }
+
+    found.packed = 0;
+    found.interned = &*it;
+    return true;
+}
+
+/*
+    Pack a code of one uppercase letter and eight digits into an integer.
+
+    @param code
+        The local authority code
+
+    @param packed
+        Set to the packed code, if it is well-formed
+
+    @return
+        true if the code was packed
+*/
+bool BethYw::GssCode::pack(const std::string &code, uint64_t &packed) noexcept
+{
+    if (code.size() != 9 || code[0] < 'A' || code[0] > 'Z')
+    {
+        return false;
+    }
+
+    uint64_t digits = 0;
+    for (size_t i = 1; i < 9; i++)
+    {
+        if (code[i] < '0' || code[i] > '9')
+        {
+            return false;
+        }
+
+        digits = digits * 10 + (code[i] - '0');
+    }
+
+    packed = ((uint64_t)(code[0] - 'A') << 27) | digits;
+    return true;
+}
+
+/*
+    Compare two codes as strings, when at least one is interned.
+
+    @param lhs
+        The first code
+
+    @param rhs
+        The second code
+
+    @return
+        A negative number, zero or a positive number if lhs is before, the
+        same as or after rhs
+*/
+int BethYw::GssCode::compareSlow(const GssCode &lhs, const GssCode &rhs) noexcept
+{
+    char lhsText[9];
+    char rhsText[9];
+    const char *lhsData = lhsText;
+    const char *rhsData = rhsText;
+    size_t lhsSize = 9;
+    size_t rhsSize = 9;
+
+    if (lhs.interned != nullptr)
+    {
+        lhsData = lhs.interned->data();
+        lhsSize = lhs.interned->size();
+    }
+    else
+    {
+        unpack(lhs.packed, lhsText);
+    }
+
+    if (rhs.interned != nullptr)
+    {
+        rhsData = rhs.interned->data();
+        rhsSize = rhs.interned->size();
+    }
+    else
+    {
+        unpack(rhs.packed, rhsText);
+    }
+
+    const int result = std::memcmp(lhsData, rhsData, std::min(lhsSize, rhsSize));
+
+    if (result != 0)
+    {
+        return result;
+    }
+
+    return lhsSize < rhsSize ? -1 : (lhsSize > rhsSize ? 1 : 0);
+}
+
+/*
+    Check whether the code was packed, rather than interned.
+
+    @return
+        true if the code is packed
+*/
+const bool BethYw::GssCode::isPacked() const noexcept
+{
+    return interned == nullptr;
+}
+
+/*
+    Retrieve the packed code.
+
+    @return
+        The packed code, or 0 if the code is interned
+*/
+const uint64_t BethYw::GssCode::getPacked() const noexcept
+{
+    return packed;
+}
+
+/*
+    Retrieve the code as a string.
+
+    @return
+        The local authority code
+*/
+const std::string BethYw::GssCode::toString() const
+{
+    if (interned != nullptr)
+    {
+        return *interned;
+    }
+
+    char text[9];
+    unpack(packed, text);
+    return std::string(text, 9);
+}
+
+/*
+    Sort the indices of a list of keys by their keys, with a least significant
+    digit radix sort over each byte of the keys. The sort is stable, so
+    indices with the same key keep their order. Bytes that are the same in
+    every key (e.g. the high bytes of a year) are skipped.
+
+    @param keys
+        The keys to sort by
+
+    @param order
+        The indices into keys to sort, which is sorted in place
+
+    @return
+        void
+*/
+void BethYw::radixSortOrder(const std::vector<uint64_t> &keys, std::vector<uint32_t> &order)
+{
+    std::vector<uint32_t> buffer(order.size());
+
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[257] = {0};
+
+        for (const uint32_t index : order)
+        {
+            counts[((keys[index] >> shift) & 0xFF) + 1]++;
+        }
+
+        // Every key has the same byte, so this pass would not move anything
+        if (std::find(std::begin(counts), std::end(counts), order.size()) != std::end(counts))
+        {
+            continue;
+        }
+
+        for (size_t i = 1; i < 257; i++)
+        {
+            counts[i] += counts[i - 1];
+        }
+
+        for (const uint32_t index : order)
+        {
+            buffer[counts[(keys[index] >> shift) & 0xFF]++] = index;
+        }
+
+        order.swap(buffer);
+    }
+}
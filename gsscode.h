@@ -0,0 +1,78 @@
+#ifndef GSSCODE_H_
+#define GSSCODE_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the GssCode class, a compact key for local authority
+    codes, and a radix sort for the integer keys built from them.
+
+    Local authority codes follow the Government Statistical Service (GSS)
+    pattern of one uppercase letter and eight digits, e.g. W06000001. A code
+    of that form is packed into an integer:
+
+        bits 27-31   the letter (A = 0, ..., Z = 25)
+        bits 0-26    the eight digits as a number (0 to 99999999)
+
+    so comparing two packed codes is a single integer comparison, in the same
+    order as comparing the strings. Any other code (e.g. lowercase, or a test
+    code such as W1) is interned instead: there is one copy of each string,
+    which lives until the program ends, and the GssCode points at it. A
+    comparison that involves an interned code compares the strings, so every
+    GssCode still orders the same way as its string.
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BethYw
+{
+    class GssCode
+    {
+    private:
+        uint64_t packed = 0;
+        const std::string *interned = nullptr;
+
+        static bool pack(const std::string &code, uint64_t &packed) noexcept;
+        static int compareSlow(const GssCode &lhs, const GssCode &rhs) noexcept;
+
+    public:
+        GssCode() = default;
+        explicit GssCode(const std::string &code);
+        static bool find(const std::string &code, GssCode &found) noexcept;
+
+        const bool isPacked() const noexcept;
+        const uint64_t getPacked() const noexcept;
+        const std::string toString() const;
+
+        friend bool operator==(const GssCode &lhs, const GssCode &rhs) noexcept
+        {
+            // Interned strings are unique, so the pointers can be compared
+            return lhs.packed == rhs.packed && lhs.interned == rhs.interned;
+        }
+
+        friend bool operator!=(const GssCode &lhs, const GssCode &rhs) noexcept
+        {
+            return !(lhs == rhs);
+        }
+
+        friend bool operator<(const GssCode &lhs, const GssCode &rhs) noexcept
+        {
+            if (lhs.interned == nullptr && rhs.interned == nullptr)
+            {
+                return lhs.packed < rhs.packed;
+            }
+
+            return compareSlow(lhs, rhs) < 0;
+        }
+    };
+
+    void radixSortOrder(const std::vector<uint64_t> &keys, std::vector<uint32_t> &order);
+}
+
+#endif // GSSCODE_H_
@@ -10,6 +10,16 @@
     by the functions in data.cpp.
  */
 
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#endif
+
 #include "input.h"
 
 /*
@@ -75,3 +85,171 @@ std::ifstream& InputFile::open()
 
     return file;
 }
+
+/*
+    Expand the FILE of a dataset into the files to import. FILE may be:
+
+        a glob pattern (containing *, ? or [), e.g. pop/release-*.csv, which
+        is expanded to the regular files that match it
+
+        a directory, which is expanded to the regular files in it (but not in
+        its subdirectories), ignoring hidden files
+
+        anything else, which is a single file
+
+    The files are ordered by precedence, lowest first, by comparing their
+    names as version keys (see versionLess()), so a file imported later takes
+    precedence in the same way as a dataset imported later.
+
+    A pattern that matches no files, or a path that doesn't exist, is returned
+    as it is, so opening it fails with the usual error. Only single files are
+    supported on Windows.
+
+    @param path
+        The complete path, directory or pattern
+
+    @return
+        The complete paths of the files to import, in order of precedence
+*/
+std::vector<std::string> InputFile::expand(const std::string &path)
+{
+    std::vector<std::string> files;
+
+#ifndef _WIN32
+    struct stat info;
+
+    if (path.find_first_of("*?[") != std::string::npos)
+    {
+        glob_t matches;
+
+        if (glob(path.c_str(), 0, nullptr, &matches) == 0)
+        {
+            for (size_t i = 0; i < matches.gl_pathc; i++)
+            {
+                if (stat(matches.gl_pathv[i], &info) == 0 && S_ISREG(info.st_mode))
+                {
+                    files.push_back(matches.gl_pathv[i]);
+                }
+            }
+        }
+
+        globfree(&matches);
+    }
+    else if (stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+    {
+        const std::string directory = path.back() == '/' ? path : path + '/';
+        DIR *handle = opendir(directory.c_str());
+
+        if (handle != nullptr)
+        {
+            while (const dirent *entry = readdir(handle))
+            {
+                const std::string file = directory + entry->d_name;
+
+                if (entry->d_name[0] != '.' && stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+                {
+                    files.push_back(file);
+                }
+            }
+
+            closedir(handle);
+        }
+    }
+#endif
+
+    if (files.empty())
+    {
+        files.push_back(path);
+    }
+
+    std::stable_sort(files.begin(), files.end(), versionLess);
+    return files;
+}
+
+/*
+    Retrieve the size of a file, e.g. to schedule the largest files first.
+
+    @param path
+        The complete path of the file
+
+    @return
+        The size in bytes, or 0 if it is not known
+*/
+const uint64_t InputFile::size(const std::string &path) noexcept
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    const std::streamoff end = file.is_open() ? (std::streamoff)file.tellg() : 0;
+
+    return end > 0 ? (uint64_t)end : 0;
+}
+
+/*
+    Compare two file names as version keys: runs of digits are compared as
+    numbers, and everything else character by character, so release-2.csv
+    comes before release-10.csv, and pop-2019.csv before pop-2020.csv.
+
+    @param lhs
+        The first name
+
+    @param rhs
+        The second name
+
+    @return
+        true if lhs comes before rhs
+*/
+const bool InputFile::versionLess(const std::string &lhs, const std::string &rhs) noexcept
+{
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < lhs.size() && j < rhs.size())
+    {
+        if (std::isdigit((unsigned char)lhs[i]) && std::isdigit((unsigned char)rhs[j]))
+        {
+            // Compare the runs of digits by length without leading zeros,
+            // and then digit by digit
+            size_t lhsEnd = i;
+            size_t rhsEnd = j;
+            while (lhsEnd < lhs.size() && std::isdigit((unsigned char)lhs[lhsEnd])) lhsEnd++;
+            while (rhsEnd < rhs.size() && std::isdigit((unsigned char)rhs[rhsEnd])) rhsEnd++;
+
+            size_t lhsStart = i;
+            size_t rhsStart = j;
+            while (lhsStart + 1 < lhsEnd && lhs[lhsStart] == '0') lhsStart++;
+            while (rhsStart + 1 < rhsEnd && rhs[rhsStart] == '0') rhsStart++;
+
+            if (lhsEnd - lhsStart != rhsEnd - rhsStart)
+            {
+                return lhsEnd - lhsStart < rhsEnd - rhsStart;
+            }
+
+            const int order = lhs.compare(lhsStart, lhsEnd - lhsStart, rhs, rhsStart, rhsEnd - rhsStart);
+
+            if (order != 0)
+            {
+                return order < 0;
+            }
+
+            i = lhsEnd;
+            j = rhsEnd;
+        }
+        else
+        {
+            if (lhs[i] != rhs[j])
+            {
+                return (unsigned char)lhs[i] < (unsigned char)rhs[j];
+            }
+
+            i++;
+            j++;
+        }
+    }
+
+    if (i < lhs.size() || j < rhs.size())
+    {
+        return i == lhs.size() && j < rhs.size();
+    }
+
+    // Equal as versions (e.g. 01 and 1), so fall back to the plain order
+    return lhs < rhs;
+}
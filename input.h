@@ -13,8 +13,10 @@
     InputFile is a concrete derivation of InputSource, for input from files.
  */
 
+#include <cstdint>
 #include <string>
 #include <fstream>
+#include <vector>
 
 /*
     InputSource is an abstract/purely virtual base class for 
@@ -43,6 +45,10 @@ public:
     InputFile(const std::string &filePath);
     ~InputFile();
     std::ifstream& open();
+
+    static std::vector<std::string> expand(const std::string &path);
+    static const uint64_t size(const std::string &path) noexcept;
+    static const bool versionLess(const std::string &lhs, const std::string &rhs) noexcept;
 };
 
 #endif // INPUT_H_
\ No newline at end of file
@@ -0,0 +1,662 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the libbethyw C interface. Data
+    is imported with the same functions as the command line program, and then
+    each Measure is copied once into contiguous arrays of years and values
+    which are lent to the caller.
+*/
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "libbethyw.h"
+#include "bethyw.h"
+#include "similar.h"
+#include "tail.h"
+
+/*
+    A series of values for one Measure of one Area, stored contiguously.
+*/
+struct BethYwSeries
+{
+    std::string codename;
+    std::string label;
+    std::vector<unsigned int> years;
+    std::vector<double> values;
+};
+
+/*
+    The code, names and series of one Area. The series are ordered by
+    codename.
+*/
+struct BethYwArea
+{
+    std::string code;
+    AreaNames names;
+    std::vector<BethYwSeries> series;
+};
+
+/*
+    The parsed arguments of a bethyw_load(), and the cache of the files it
+    imported so bethyw_refresh() only parses the rows appended since.
+*/
+struct BethYwLoad
+{
+    const std::vector<BethYw::InputFileSource> datasetsToImport;
+    const StringFilterSet areasFilter;
+    const StringFilterSet measuresFilter;
+    const BethYw::YearFilter yearsFilter;
+    BethYw::TailCache tail;
+};
+
+struct bethyw_handle
+{
+    std::string dir;
+    std::vector<std::string> codes;
+    // Keyed by case folded code, so codes are found in any case as with the
+    // areas argument, as measures are by lowercased codename
+    std::map<std::string, BethYwArea> areas;
+    mutable std::string error;
+
+    // The feature matrices built by bethyw_similar(), by year, which are
+    // kept until the next bethyw_load()
+    mutable std::map<unsigned int, BethYw::FeatureMatrix> matrices;
+
+    // The arguments of the last bethyw_load(), and how much of each file it
+    // imported, for bethyw_refresh()
+    std::unique_ptr<BethYwLoad> load;
+};
+
+namespace
+{
+    /*
+        Find an Area in a handle, setting the error if there isn't one.
+
+        @param handle
+            The handle to search
+
+        @param code
+            The local authority code of the Area
+
+        @return
+            The Area, or nullptr if it was not found
+    */
+    const BethYwArea *findArea(const bethyw_handle *handle, const char *code)
+    {
+        if (handle == nullptr || code == nullptr)
+        {
+            return nullptr;
+        }
+
+        auto it = handle->areas.find(BethYw::foldCase(code));
+
+        if (it == handle->areas.end())
+        {
+            handle->error = std::string("No area found matching ") + code;
+            return nullptr;
+        }
+
+        return &it->second;
+    }
+
+    /*
+        Find a series of an Area by its codename (case-insensitive), setting
+        the error if there isn't one.
+
+        @param handle
+            The handle to search
+
+        @param code
+            The local authority code of the Area
+
+        @param measure
+            The codename of the Measure
+
+        @return
+            The series, or nullptr if it was not found
+    */
+    const BethYwSeries *findSeries(const bethyw_handle *handle, const char *code, const char *measure)
+    {
+        const BethYwArea *area = findArea(handle, code);
+
+        if (area == nullptr || measure == nullptr)
+        {
+            return nullptr;
+        }
+
+        std::string codename = measure;
+        BethYw::stringToLower(codename);
+
+        auto it = std::lower_bound(area->series.begin(), area->series.end(), codename,
+                                   [](const BethYwSeries &series, const std::string &codename) {
+                                       return series.codename < codename;
+                                   });
+
+        if (it == area->series.end() || it->codename != codename)
+        {
+            handle->error = "No measure found matching " + codename;
+            return nullptr;
+        }
+
+        return &*it;
+    }
+
+    /*
+        Import the datasets of the last bethyw_load() into a handle, and copy
+        each Measure into contiguous arrays for the caller to borrow.
+
+        @param handle
+            The handle, which has been cleared
+
+        @return
+            0 on success, -1 on error
+    */
+    int importInto(bethyw_handle *handle)
+    {
+        try
+        {
+            BethYwLoad &load = *handle->load;
+            Areas data = Areas();
+            BethYw::importDatasets(data, handle->dir, load.datasetsToImport, load.areasFilter,
+                                   load.measuresFilter, load.yearsFilter, &load.tail);
+
+            data.forEachArea([handle](const Area &area) {
+                BethYwArea &entry = handle->areas[BethYw::foldCase(area.getLocalAuthorityCode())];
+                entry.code = area.getLocalAuthorityCode();
+                entry.names = area.getNames();
+
+                for (auto &measure : area.getMeasures())
+                {
+                    BethYwSeries series;
+                    series.codename = measure.first;
+                    series.label = measure.second.getLabel();
+
+                    for (auto &value : measure.second.getValues())
+                    {
+                        series.years.push_back(value.first);
+                        series.values.push_back(value.second);
+                    }
+
+                    entry.series.push_back(std::move(series));
+                }
+
+                handle->codes.push_back(area.getLocalAuthorityCode());
+            });
+        }
+        catch(const std::exception& e)
+        {
+            handle->codes.clear();
+            handle->areas.clear();
+            handle->error = e.what();
+            return -1;
+        }
+
+        return 0;
+    }
+}
+
+/*
+    Retrieve the version of the C interface, which only changes when existing
+    functions change.
+
+    @return
+        BETHYW_ABI_VERSION
+*/
+int bethyw_abi_version(void)
+{
+    return BETHYW_ABI_VERSION;
+}
+
+/*
+    Open a handle on a data directory. Nothing is read until bethyw_load().
+
+    @param dir
+        The directory containing the data files, or NULL for "datasets"
+
+    @return
+        A handle to pass to the other functions and finally bethyw_close(),
+        or NULL if it could not be allocated
+*/
+bethyw_handle *bethyw_open(const char *dir)
+{
+    try
+    {
+        bethyw_handle *handle = new bethyw_handle();
+        handle->dir = std::string(dir != nullptr ? dir : "datasets") + DIR_SEP;
+        return handle;
+    }
+    catch(const std::exception& e)
+    {
+        return nullptr;
+    }
+}
+
+/*
+    Close a handle, freeing all its data. Any pointers returned for the handle
+    are no longer valid.
+
+    @param handle
+        The handle to close, which may be NULL
+*/
+void bethyw_close(bethyw_handle *handle)
+{
+    delete handle;
+}
+
+/*
+    Retrieve a description of the last error for a handle.
+
+    @param handle
+        The handle
+
+    @return
+        The error message, or an empty string if there has been no error
+*/
+const char *bethyw_last_error(const bethyw_handle *handle)
+{
+    return handle != nullptr ? handle->error.c_str() : "No handle";
+}
+
+/*
+    Load datasets into a handle, replacing anything previously loaded. The
+    arguments take the same values as the command line arguments of the same
+    names, e.g. a comma-separated list of dataset codes.
+
+    @param handle
+        The handle to load into
+
+    @param datasets
+        The datasets to import, or NULL for all datasets
+
+    @param areas
+        The areas to import, or NULL for all areas
+
+    @param measures
+        The measures to import, or NULL for all measures
+
+    @param years
+        The year (YYYY) or range of years (YYYY-ZZZZ) to import, or NULL for
+        all years
+
+    @return
+        0 on success, -1 on error
+*/
+int bethyw_load(bethyw_handle *handle,
+                const char *datasets,
+                const char *areas,
+                const char *measures,
+                const char *years)
+{
+    if (handle == nullptr)
+    {
+        return -1;
+    }
+
+    handle->codes.clear();
+    handle->areas.clear();
+    handle->matrices.clear();
+    handle->error.clear();
+
+    try
+    {
+        // Parse the arguments exactly as the command line program would
+        std::vector<std::string> argStrings = {"bethyw"};
+        const std::pair<const char *, const char *> options[] = {
+            {"--datasets", datasets}, {"--areas", areas}, {"--measures", measures}, {"--years", years}};
+
+        for (auto &option : options)
+        {
+            if (option.second != nullptr)
+            {
+                argStrings.push_back(option.first);
+                argStrings.push_back(option.second);
+            }
+        }
+
+        std::vector<char *> argv;
+        for (auto &arg : argStrings)
+        {
+            argv.push_back(&arg[0]);
+        }
+
+        int argc = (int)argv.size();
+        char **argvPointer = argv.data();
+        auto cxxopts = BethYw::cxxoptsSetup();
+        auto args = cxxopts.parse(argc, argvPointer);
+
+        handle->load.reset(new BethYwLoad{
+            BethYw::parseDatasetsArg(args),
+            BethYw::parseAreasArg(args),
+            BethYw::parseMeasuresArg(args),
+            BethYw::parseYearsArg(args),
+            BethYw::TailCache("", "")});
+    }
+    catch(const std::exception& e)
+    {
+        handle->load.reset();
+        handle->error = e.what();
+        return -1;
+    }
+
+    return importInto(handle);
+}
+
+/*
+    Load the datasets of the last bethyw_load() into a handle again, after
+    rows have been appended to their files, e.g. when a long-running program
+    is told a feed has grown. Only the rows appended to each JSON Lines or CSV
+    file since it was last loaded are parsed, unless the rest of the file
+    changed (see tail.h). To allow this, the handle keeps the data imported
+    from each file as well as the arrays lent to the caller.
+
+    @param handle
+        The handle to refresh
+
+    @return
+        0 on success, -1 on error
+*/
+int bethyw_refresh(bethyw_handle *handle)
+{
+    if (handle == nullptr)
+    {
+        return -1;
+    }
+
+    handle->error.clear();
+
+    if (!handle->load)
+    {
+        handle->error = "Nothing has been loaded to refresh";
+        return -1;
+    }
+
+    handle->codes.clear();
+    handle->areas.clear();
+    handle->matrices.clear();
+
+    return importInto(handle);
+}
+
+/*
+    Retrieve the number of Areas loaded.
+
+    @param handle
+        The handle
+
+    @return
+        The number of Areas
+*/
+size_t bethyw_area_count(const bethyw_handle *handle)
+{
+    return handle != nullptr ? handle->codes.size() : 0;
+}
+
+/*
+    Retrieve the local authority code of an Area, in order of code.
+
+    @param handle
+        The handle
+
+    @param index
+        The index of the Area, less than bethyw_area_count()
+
+    @return
+        The local authority code, or NULL if the index is out of range
+*/
+const char *bethyw_area_code(const bethyw_handle *handle, size_t index)
+{
+    if (handle == nullptr || index >= handle->codes.size())
+    {
+        return nullptr;
+    }
+
+    return handle->codes[index].c_str();
+}
+
+/*
+    Retrieve the name of an Area in a language.
+
+    @param handle
+        The handle
+
+    @param code
+        The local authority code of the Area
+
+    @param lang
+        A three-letter language code, e.g. eng or cym
+
+    @return
+        The name, or NULL if the Area or name was not found
+*/
+const char *bethyw_area_name(const bethyw_handle *handle, const char *code, const char *lang)
+{
+    const BethYwArea *area = findArea(handle, code);
+
+    if (area == nullptr || lang == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::string language = lang;
+    BethYw::stringToLower(language);
+    auto it = area->names.find(language);
+
+    return it != area->names.end() ? it->second.c_str() : nullptr;
+}
+
+/*
+    Retrieve the number of Measures of an Area.
+
+    @param handle
+        The handle
+
+    @param code
+        The local authority code of the Area
+
+    @return
+        The number of Measures, or 0 if the Area was not found
+*/
+size_t bethyw_measure_count(const bethyw_handle *handle, const char *code)
+{
+    const BethYwArea *area = findArea(handle, code);
+    return area != nullptr ? area->series.size() : 0;
+}
+
+/*
+    Retrieve the codename of a Measure of an Area, in order of codename.
+
+    @param handle
+        The handle
+
+    @param code
+        The local authority code of the Area
+
+    @param index
+        The index of the Measure, less than bethyw_measure_count()
+
+    @return
+        The codename, or NULL if the Area was not found or the index is out of
+        range
+*/
+const char *bethyw_measure_code(const bethyw_handle *handle, const char *code, size_t index)
+{
+    const BethYwArea *area = findArea(handle, code);
+
+    if (area == nullptr || index >= area->series.size())
+    {
+        return nullptr;
+    }
+
+    return area->series[index].codename.c_str();
+}
+
+/*
+    Retrieve the human-readable label of a Measure of an Area.
+
+    @param handle
+        The handle
+
+    @param code
+        The local authority code of the Area
+
+    @param measure
+        The codename of the Measure (case-insensitive)
+
+    @return
+        The label, or NULL if the Area or Measure was not found
+*/
+const char *bethyw_measure_label(const bethyw_handle *handle, const char *code, const char *measure)
+{
+    const BethYwSeries *series = findSeries(handle, code, measure);
+    return series != nullptr ? series->label.c_str() : nullptr;
+}
+
+/*
+    Borrow the years and values of a Measure of an Area as two contiguous
+    arrays of the same length, in chronological order. The arrays are owned
+    by the handle and valid until the next bethyw_load() or bethyw_close().
+
+    @param handle
+        The handle
+
+    @param code
+        The local authority code of the Area
+
+    @param measure
+        The codename of the Measure (case-insensitive)
+
+    @param years
+        Set to the array of years
+
+    @param values
+        Set to the array of values
+
+    @param length
+        Set to the length of both arrays
+
+    @return
+        0 on success, -1 if the Area or Measure was not found
+*/
+int bethyw_series(const bethyw_handle *handle,
+                  const char *code,
+                  const char *measure,
+                  const unsigned int **years,
+                  const double **values,
+                  size_t *length)
+{
+    const BethYwSeries *series = findSeries(handle, code, measure);
+
+    if (series == nullptr || years == nullptr || values == nullptr || length == nullptr)
+    {
+        return -1;
+    }
+
+    *years = series->years.data();
+    *values = series->values.data();
+    *length = series->years.size();
+
+    return 0;
+}
+
+/*
+    Find the areas most like an area, comparing the values of every measure
+    loaded in one year (see similar.h). The feature matrix for each year is
+    built on the first query and reused until the next bethyw_load(), so
+    later queries only compute the distances.
+
+    @param handle
+        The handle
+
+    @param code
+        The local authority code of the Area
+
+    @param year
+        The year to compare, or 0 to use the latest year of each measure
+
+    @param k
+        The largest number of areas to find
+
+    @param codes
+        An array of k pointers, set to the local authority codes of the
+        nearest areas, nearest first, which are valid until the next
+        bethyw_load() or bethyw_close()
+
+    @param distances
+        An array of k distances, set to the distance of each area
+
+    @param length
+        Set to the number of areas found
+
+    @return
+        0 on success, -1 if the Area was not found
+*/
+int bethyw_similar(const bethyw_handle *handle,
+                   const char *code,
+                   unsigned int year,
+                   size_t k,
+                   const char **codes,
+                   double *distances,
+                   size_t *length)
+{
+    if (handle == nullptr || code == nullptr || codes == nullptr || distances == nullptr || length == nullptr)
+    {
+        return -1;
+    }
+
+    const BethYwArea *target = findArea(handle, code);
+
+    if (target == nullptr)
+    {
+        return -1;
+    }
+
+    try
+    {
+        auto matrix = handle->matrices.find(year);
+
+        if (matrix == handle->matrices.end())
+        {
+            BethYw::FeatureMatrix built(year);
+
+            for (auto &area : handle->areas)
+            {
+                for (auto &series : area.second.series)
+                {
+                    for (size_t i = 0; i < series.years.size(); i++)
+                    {
+                        built.add(area.second.code, series.codename, series.years[i], series.values[i]);
+                    }
+                }
+            }
+
+            built.build();
+            matrix = handle->matrices.emplace(year, std::move(built)).first;
+        }
+
+        auto neighbours = matrix->second.nearest(target->code, k);
+
+        for (size_t i = 0; i < neighbours.size(); i++)
+        {
+            codes[i] = findArea(handle, neighbours[i].localAuthorityCode.c_str())->code.c_str();
+            distances[i] = neighbours[i].distance;
+        }
+
+        *length = neighbours.size();
+    }
+    catch(const std::exception& e)
+    {
+        handle->error = e.what();
+        return -1;
+    }
+
+    return 0;
+}
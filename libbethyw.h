@@ -0,0 +1,96 @@
+#ifndef LIBBETHYW_H_
+#define LIBBETHYW_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the C interface for libbethyw, a shared library build
+    of Beth Yw? (./build.sh lib) for embedding in other programs instead of
+    running the bethyw executable and parsing its output.
+
+    A handle is opened on a data directory, datasets are loaded into it with
+    the same arguments as the command line program, and then each series of
+    (year, value) pairs can be read as two contiguous arrays. The arrays are
+    owned by the handle and are valid until the next call to bethyw_load(),
+    bethyw_refresh() or bethyw_close(), so they can be wrapped without
+    copying, e.g. from Python with ctypes and numpy:
+
+        lib = ctypes.CDLL("bin/libbethyw.so")
+        handle = lib.bethyw_open(b"datasets")
+        lib.bethyw_load(handle, b"popden", None, None, None)
+        years, values, length = POINTER(c_uint)(), POINTER(c_double)(), c_size_t()
+        lib.bethyw_series(handle, b"W06000011", b"pop", byref(years), byref(values), byref(length))
+        numpy.ctypeslib.as_array(values, (length.value,))
+
+    Functions returning int return 0 on success and -1 on error, in which
+    case bethyw_last_error() describes the error. None of the functions throw.
+
+    Area codes, measure codenames and languages are matched in any case.
+
+    A handle must only be used by one thread at a time, including the
+    functions taking a const handle, which record the last error and cache
+    the feature matrices of bethyw_similar() in it. Different handles can be
+    used from different threads at the same time.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#define BETHYW_API __declspec(dllexport)
+#else
+#define BETHYW_API __attribute__((visibility("default")))
+#endif
+
+#define BETHYW_ABI_VERSION 1
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct bethyw_handle bethyw_handle;
+
+BETHYW_API int bethyw_abi_version(void);
+
+BETHYW_API bethyw_handle *bethyw_open(const char *dir);
+BETHYW_API void bethyw_close(bethyw_handle *handle);
+BETHYW_API const char *bethyw_last_error(const bethyw_handle *handle);
+
+BETHYW_API int bethyw_load(bethyw_handle *handle,
+                           const char *datasets,
+                           const char *areas,
+                           const char *measures,
+                           const char *years);
+BETHYW_API int bethyw_refresh(bethyw_handle *handle);
+
+BETHYW_API size_t bethyw_area_count(const bethyw_handle *handle);
+BETHYW_API const char *bethyw_area_code(const bethyw_handle *handle, size_t index);
+BETHYW_API const char *bethyw_area_name(const bethyw_handle *handle, const char *code, const char *lang);
+
+BETHYW_API size_t bethyw_measure_count(const bethyw_handle *handle, const char *code);
+BETHYW_API const char *bethyw_measure_code(const bethyw_handle *handle, const char *code, size_t index);
+BETHYW_API const char *bethyw_measure_label(const bethyw_handle *handle, const char *code, const char *measure);
+
+BETHYW_API int bethyw_series(const bethyw_handle *handle,
+                             const char *code,
+                             const char *measure,
+                             const unsigned int **years,
+                             const double **values,
+                             size_t *length);
+
+BETHYW_API int bethyw_similar(const bethyw_handle *handle,
+                              const char *code,
+                              unsigned int year,
+                              size_t k,
+                              const char **codes,
+                              double *distances,
+                              size_t *length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBBETHYW_H_
@@ -27,7 +27,7 @@
         Human-readable (i.e. nice/explanatory) label for the measure
 */
 Measure::Measure(const std::string &codename, const std::string &label)
-    : codename(codename), label(label)
+    : codename(codename), label(label), searchKey(BethYw::foldCase(codename, true))
 {
     BethYw::stringToLower(this->codename);
 }
@@ -43,6 +43,18 @@ const std::string Measure::getCodename() const noexcept
     return codename;
 }
 
+/*
+    Retrieve the case folded, accent stripped codename, computed once when the
+    Measure is constructed, for comparing against measure filters.
+
+    @return
+        The search key for the Measure
+*/
+const std::string& Measure::getSearchKey() const noexcept
+{
+    return searchKey;
+}
+
 /*
     Retrieve the human-friendly label for the Measure.
 
@@ -79,14 +91,31 @@ void Measure::setLabel(const std::string &label) noexcept
 */
 const double Measure::getValue(unsigned int year) const
 {
-    auto it = values.find(year);
+    const double *value = findValue(year);
 
-    if (it == values.end())
+    if (value == nullptr)
     {
         throw std::out_of_range("No value found for year " + std::to_string(year));
     }
     
-    return it->second;
+    return *value;
+}
+
+/*
+    Find a Measure's value for a given year, without throwing if there isn't
+    one.
+
+    @param year
+        The year to find the value for
+
+    @return
+        A pointer to the value stored for the given year, or null if there is
+        no value for the year
+*/
+const double *Measure::findValue(const unsigned int year) const noexcept
+{
+    auto it = values.find(year);
+    return it == values.end() ? nullptr : &it->second;
 }
 
 /*
@@ -102,7 +131,8 @@ const std::map<unsigned int, double> Measure::getValues() const noexcept
 
 /*
     Add a particular year's value to the Measure object. If a value already
-    exists for the year, replace it.
+    exists for the year, replace it. Years are usually added in order, so a
+    year after the last is inserted at the end without searching.
 
     @param key
         The year to insert a value at
@@ -115,7 +145,18 @@ const std::map<unsigned int, double> Measure::getValues() const noexcept
 */
 void Measure::setValue(unsigned int year, double value)
 {
-    values[year] = value;
+    if (summarised)
+    {
+        stats.add(year, value);
+    }
+    else if (values.empty() || year > values.rbegin()->first)
+    {
+        values.emplace_hint(values.end(), year, value);
+    }
+    else
+    {
+        values[year] = value;
+    }
 }
 
 /*
@@ -126,7 +167,39 @@ void Measure::setValue(unsigned int year, double value)
 */
 const size_t Measure::size() const noexcept
 {
-    return values.size();
+    return summarised ? stats.size() : values.size();
+}
+
+/*
+    Move the values of this Measure from its map into a compact series (see
+    BethYw::SeriesStats), for when only the average and differences are
+    needed. Any values set or merged in afterwards are added to the series,
+    and getValues() returns an empty map.
+
+    @return
+        void
+*/
+void Measure::summarise()
+{
+    for (auto &it : values)
+    {
+        stats.add(it.first, it.second);
+    }
+
+    values.clear();
+    summarised = true;
+}
+
+/*
+    Check whether this Measure keeps its values as a compact series (see
+    summarise()).
+
+    @return
+        true if the Measure has been summarised; false otherwise
+*/
+const bool Measure::isSummarised() const noexcept
+{
+    return summarised;
 }
 
 /*
@@ -140,6 +213,11 @@ const size_t Measure::size() const noexcept
 */
 const double Measure::getDifference() const noexcept
 {
+    if (summarised)
+    {
+        return stats.getDifference();
+    }
+
     if (size() < 2)
     {
         return 0;
@@ -158,6 +236,11 @@ const double Measure::getDifference() const noexcept
 */
 const double Measure::getDifferenceAsPercentage() const noexcept
 {
+    if (summarised)
+    {
+        return stats.getDifferenceAsPercentage();
+    }
+
     if (size() < 2) 
     {
         return 0;
@@ -167,25 +250,32 @@ const double Measure::getDifferenceAsPercentage() const noexcept
 }
 
 /*
-    Calculate the average/mean value for all the values.
+    Calculate the average/mean value for all the values. The values are
+    summed with compensated summation, so precision isn't lost over long
+    series.
 
     @return
         The average value for all the years, or 0 if it cannot be calculated
 */
 const double Measure::getAverage() const noexcept
 {
+    if (summarised)
+    {
+        return stats.getAverage();
+    }
+
     if (size() < 1) 
     {
         return 0;
     }
 
-    double total = 0;
-    for (auto it : values)
+    BethYw::CompensatedSum total;
+    for (auto &it : values)
     {
-        total += it.second;
+        total.add(it.second);
     }
 
-    return total / size();
+    return total.result() / size();
 }
 
 /*
@@ -194,6 +284,9 @@ const double Measure::getAverage() const noexcept
     value across the years, the difference between the first and last year,
     and the percentage difference between the first and last year.
 
+    A summarised Measure (see Measure::summarise()) has no years to print, so
+    only the three additional columns are printed.
+
     If there is no data in this measure, print the name and code, and 
     on the next line print: <no data>
 
@@ -272,12 +365,14 @@ std::ostream& operator<<(std::ostream &os, const Measure &measure)
 */
 bool operator==(const Measure& lhs, const Measure& rhs)
 {
-    return lhs.codename == rhs.codename && lhs.label == rhs.label && lhs.values == rhs.values;
+    return lhs.codename == rhs.codename && lhs.label == rhs.label && lhs.values == rhs.values
+           && lhs.summarised == rhs.summarised && lhs.stats == rhs.stats;
 }
 
 /*
     Merge the rhs measure into the lhs measure with the rhs
-    taking precedence.
+    taking precedence. If either Measure is summarised, the lhs Measure is
+    summarised and the values of the rhs Measure are added to its series.
 
     @param lhs
         A Measure object
@@ -289,6 +384,12 @@ void operator+=(Measure& lhs, const Measure& rhs)
 {
     lhs.label = rhs.label;
 
+    if (rhs.summarised)
+    {
+        lhs.summarise();
+        lhs.stats.merge(rhs.stats);
+    }
+
     for (auto it : rhs.values)
     {
         lhs.setValue(it.first, it.second);
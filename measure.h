@@ -14,6 +14,8 @@
 #include <string>
 #include <map>
 
+#include "numeric.h"
+
 /*
     The Measure class contains a measure code, label, and a container for readings
     from across a number of years.
@@ -23,18 +25,25 @@ class Measure
 private:
     std::string codename;
     std::string label;
+    std::string searchKey;
     std::map<unsigned int, double> values;
+    bool summarised = false;
+    BethYw::SeriesStats stats;
     void rightAlign(std::string &string1, std::string &string2) const noexcept;
 
 public:
     Measure(const std::string &codename, const std::string &label);
     const std::string getCodename() const noexcept;
     const std::string getLabel() const noexcept;
+    const std::string& getSearchKey() const noexcept;
     void setLabel(const std::string &label) noexcept;
     const double getValue(unsigned int year) const;
+    const double *findValue(const unsigned int year) const noexcept;
     const std::map<unsigned int, double> getValues() const noexcept;
     void setValue(unsigned int year, double value);
     const size_t size() const noexcept;
+    void summarise();
+    const bool isSummarised() const noexcept;
     const double getDifference() const noexcept;
     const double getDifferenceAsPercentage() const noexcept;
     const double getAverage() const noexcept;
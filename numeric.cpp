@@ -0,0 +1,347 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the numeric kernels used for
+    aggregates.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "numeric.h"
+
+namespace
+{
+    /*
+        Sum one block of at most SUM_BLOCK_SIZE values. The values are spread
+        over eight independent accumulators, which the compiler can keep in
+        vector registers, and the accumulators are then added in a fixed order.
+    */
+    double blockSum(const double *values, const size_t length) noexcept
+    {
+        const size_t LANES = 8;
+        double lanes[LANES] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+        size_t i = 0;
+        for (; i + LANES <= length; i += LANES)
+        {
+            for (size_t lane = 0; lane < LANES; lane++)
+            {
+                lanes[lane] += values[i + lane];
+            }
+        }
+
+        for (size_t lane = 0; i < length; i++, lane++)
+        {
+            lanes[lane] += values[i];
+        }
+
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3]))
+               + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+
+    /*
+        Add block totals pairwise, halving the range each time, so the
+        rounding error grows with the logarithm of the number of blocks.
+    */
+    double treeSum(const double *sums, const size_t length) noexcept
+    {
+        if (length == 0)
+        {
+            return 0;
+        }
+
+        if (length == 1)
+        {
+            return sums[0];
+        }
+
+        const size_t half = length / 2;
+        return treeSum(sums, half) + treeSum(sums + half, length - half);
+    }
+
+    /*
+        Sum the blocks in [first, last) of `values`, writing each total into
+        `sums`.
+    */
+    void blockSums(const double *values, const size_t length, double *sums,
+                   const size_t first, const size_t last) noexcept
+    {
+        for (size_t block = first; block < last; block++)
+        {
+            const size_t start = block * BethYw::SUM_BLOCK_SIZE;
+            const size_t size = std::min(BethYw::SUM_BLOCK_SIZE, length - start);
+            sums[block] = blockSum(values + start, size);
+        }
+    }
+}
+
+/*
+    Add a value to the sum.
+
+    @param value
+        The value to add
+
+    @return
+        void
+*/
+void BethYw::CompensatedSum::add(const double value) noexcept
+{
+    const double total = sum + value;
+
+    // Recover the low-order bits of whichever operand was smaller
+    if (std::fabs(sum) >= std::fabs(value))
+    {
+        compensation += (sum - total) + value;
+    }
+    else
+    {
+        compensation += (value - total) + sum;
+    }
+
+    sum = total;
+}
+
+/*
+    Retrieve the sum of all the values added.
+
+    @return
+        The compensated sum
+*/
+const double BethYw::CompensatedSum::result() const noexcept
+{
+    return sum + compensation;
+}
+
+/*
+    Add a value to the series, replacing the value of the year if it has
+    already been added.
+
+    @param year
+        The year of the value
+
+    @param value
+        The value
+
+    @return
+        void
+*/
+void BethYw::SeriesStats::add(const unsigned int year, const double value)
+{
+    // Years are usually added in order, so appending is the common case
+    if (years.empty() || year > years.back())
+    {
+        years.push_back(year);
+        values.push_back(value);
+        return;
+    }
+
+    auto it = std::lower_bound(years.begin(), years.end(), year);
+    const size_t index = it - years.begin();
+
+    if (*it == year)
+    {
+        values[index] = value;
+        return;
+    }
+
+    years.insert(it, year);
+    values.insert(values.begin() + index, value);
+}
+
+/*
+    Merge another series into this one, with the other series taking
+    precedence for any years in both.
+
+    @param other
+        The series to merge
+
+    @return
+        void
+*/
+void BethYw::SeriesStats::merge(const SeriesStats &other)
+{
+    if (years.empty())
+    {
+        *this = other;
+        return;
+    }
+
+    for (size_t i = 0; i < other.years.size(); i++)
+    {
+        add(other.years[i], other.values[i]);
+    }
+}
+
+/*
+    Retrieve the number of years in the series.
+
+    @return
+        The number of years
+*/
+const size_t BethYw::SeriesStats::size() const noexcept
+{
+    return years.size();
+}
+
+/*
+    Retrieve the smallest value in the series.
+
+    @return
+        The minimum, or 0 if no values have been added
+*/
+const double BethYw::SeriesStats::getMin() const noexcept
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+
+    return *std::min_element(values.begin(), values.end());
+}
+
+/*
+    Retrieve the largest value in the series.
+
+    @return
+        The maximum, or 0 if no values have been added
+*/
+const double BethYw::SeriesStats::getMax() const noexcept
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+
+    return *std::max_element(values.begin(), values.end());
+}
+
+/*
+    Calculate the mean of the series, summing in year order as
+    Measure::getAverage() does, so the result is identical.
+
+    @return
+        The mean, or 0 if no values have been added
+*/
+const double BethYw::SeriesStats::getAverage() const noexcept
+{
+    if (values.empty())
+    {
+        return 0;
+    }
+
+    CompensatedSum total;
+    for (auto value : values)
+    {
+        total.add(value);
+    }
+
+    return total.result() / values.size();
+}
+
+/*
+    Calculate the difference between the values of the first and last years,
+    as Measure::getDifference() does.
+
+    @return
+        The difference, or 0 if fewer than two values have been added
+*/
+const double BethYw::SeriesStats::getDifference() const noexcept
+{
+    if (values.size() < 2)
+    {
+        return 0;
+    }
+
+    return values.back() - values.front();
+}
+
+/*
+    Calculate the difference between the values of the first and last years
+    as a percentage of the first, as Measure::getDifferenceAsPercentage() does.
+
+    @return
+        The percentage difference, or 0 if fewer than two values have been
+        added
+*/
+const double BethYw::SeriesStats::getDifferenceAsPercentage() const noexcept
+{
+    if (values.size() < 2)
+    {
+        return 0;
+    }
+
+    return (getDifference() / values.front()) * 100;
+}
+
+/*
+    Two SeriesStats are equal when they have the same values for the same
+    years.
+
+    @param lhs
+        A SeriesStats object
+
+    @param rhs
+        A second SeriesStats object
+
+    @return
+        true if the series are equal; false otherwise
+*/
+bool BethYw::operator==(const SeriesStats &lhs, const SeriesStats &rhs)
+{
+    return lhs.years == rhs.years && lhs.values == rhs.values;
+}
+
+/*
+    Sum contiguous values in blocks of SUM_BLOCK_SIZE, adding the block
+    totals pairwise.
+
+    @param values
+        The values to sum
+
+    @param length
+        The number of values
+
+    @return
+        The sum, or 0 if there are no values
+*/
+double BethYw::pairwiseSum(const double *values, const size_t length) noexcept
+{
+    if (length <= SUM_BLOCK_SIZE)
+    {
+        return blockSum(values, length);
+    }
+
+    const size_t blocks = (length + SUM_BLOCK_SIZE - 1) / SUM_BLOCK_SIZE;
+    std::vector<double> sums(blocks);
+    blockSums(values, length, sums.data(), 0, blocks);
+
+    return treeSum(sums.data(), blocks);
+}
+
+/*
+    Calculate the mean of contiguous values with pairwiseSum().
+
+    @param values
+        The values
+
+    @param length
+        The number of values
+
+    @return
+        The mean, or 0 if there are no values
+*/
+double BethYw::mean(const double *values, const size_t length) noexcept
+{
+    if (length == 0)
+    {
+        return 0;
+    }
+
+    return pairwiseSum(values, length) / length;
+}
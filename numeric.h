@@ -0,0 +1,90 @@
+#ifndef NUMERIC_H_
+#define NUMERIC_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for the numeric kernels used for
+    aggregates. Naively adding doubles in a loop loses precision as the total
+    grows, and gives different answers depending on how the values are split
+    between threads. These kernels avoid both:
+
+    CompensatedSum — Kahan-Neumaier summation, for adding values one at a
+                     time (e.g. while walking a map).
+
+    pairwiseSum    — Sums contiguous values in fixed size blocks, then adds
+                     the block totals pairwise (e.g. the columns of the
+                     features compared by similar).
+
+    SeriesStats    — A series of (year, value) pairs and its statistics, kept
+                     in flat arrays rather than a map.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace BethYw
+{
+    /*
+        The number of values in each block of pairwiseSum.
+    */
+    constexpr size_t SUM_BLOCK_SIZE = 256;
+
+    /*
+        A running Kahan-Neumaier sum, which tracks the low-order bits lost by
+        each addition and adds them back at the end.
+    */
+    class CompensatedSum
+    {
+    private:
+        double sum = 0;
+        double compensation = 0;
+
+    public:
+        void add(const double value) noexcept;
+        const double result() const noexcept;
+    };
+
+    /*
+        A compact series of (year, value) pairs and its statistics: the count,
+        average, minimum and maximum, and the values of the first and last
+        years.
+
+        As with Measure::setValue(), a value for a year that has already been
+        added replaces the earlier value (e.g. when datasets overlap), so the
+        current value of every year has to be kept: fixed-size accumulators
+        cannot take back a replaced value. They are held in year order as two
+        flat arrays, a few bytes a year rather than a map node each, and the
+        statistics are calculated from them exactly as Measure calculates
+        them from its map.
+    */
+    class SeriesStats
+    {
+    private:
+        std::vector<unsigned int> years;
+        std::vector<double> values;
+
+    public:
+        void add(const unsigned int year, const double value);
+        void merge(const SeriesStats &other);
+        const size_t size() const noexcept;
+        const double getMin() const noexcept;
+        const double getMax() const noexcept;
+        const double getAverage() const noexcept;
+        const double getDifference() const noexcept;
+        const double getDifferenceAsPercentage() const noexcept;
+        friend bool operator==(const SeriesStats &lhs, const SeriesStats &rhs);
+    };
+
+    bool operator==(const SeriesStats &lhs, const SeriesStats &rhs);
+
+    double pairwiseSum(const double *values, const size_t length) noexcept;
+    double mean(const double *values, const size_t length) noexcept;
+}
+
+#endif // NUMERIC_H_
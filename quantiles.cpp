@@ -0,0 +1,519 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the t-digest sketch and of the
+    approximate quantiles of each measure.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "lib_json.hpp"
+
+#include "quantiles.h"
+
+using json = nlohmann::json;
+
+namespace
+{
+    const double PI = 3.14159265358979323846;
+
+    /*
+        The number of Areas dealt to a thread at a time by digestMeasures(),
+        and the number of chunks per thread that may wait to be digested.
+    */
+    const size_t DIGEST_CHUNK_SIZE = 16;
+    const size_t DIGEST_CHUNKS_PER_THREAD = 2;
+
+    /*
+        The k1 scale function, which maps a quantile to a number of centroids
+        from the start of the digest. It is steepest at the tails, so the
+        centroids there stay small.
+    */
+    double scale(const double q, const double compression) noexcept
+    {
+        return compression / (2 * PI) * std::asin(2 * q - 1);
+    }
+
+    /*
+        The inverse of scale().
+    */
+    double inverseScale(const double k, const double compression) noexcept
+    {
+        const double angle = std::max(-PI / 2, std::min(PI / 2, k * 2 * PI / compression));
+        return (std::sin(angle) + 1) / 2;
+    }
+
+    /*
+        Right-align two strings by padding the shorter one, as in the Measure
+        tables.
+    */
+    void rightAlign(std::string &string1, std::string &string2) noexcept
+    {
+        if (string1.length() < string2.length())
+        {
+            string1 = std::string(string2.length() - string1.length(), ' ') + string1;
+        }
+        else
+        {
+            string2 = std::string(string1.length() - string2.length(), ' ') + string2;
+        }
+    }
+}
+
+/*
+    Construct an empty digest.
+
+    @param compression
+        Bounds the number of centroids, trading size for accuracy
+*/
+BethYw::TDigest::TDigest(const double compression)
+    : compression(compression)
+{
+}
+
+/*
+    Add a value to the digest. Values are buffered and merged into the
+    centroids once the buffer is full.
+
+    @param value
+        The value to add
+
+    @param weight
+        The number of times to add it
+
+    @return
+        void
+*/
+void BethYw::TDigest::add(const double value, const double weight)
+{
+    if (totalWeight == 0)
+    {
+        min = max = value;
+    }
+
+    min = std::min(min, value);
+    max = std::max(max, value);
+    totalWeight += weight;
+    buffer.push_back({value, weight});
+
+    if (buffer.size() >= 5 * (size_t)compression)
+    {
+        compress();
+    }
+}
+
+/*
+    Merge another digest into this one, as if its values had been added.
+
+    @param other
+        The digest to merge
+
+    @return
+        void
+*/
+void BethYw::TDigest::merge(const TDigest &other)
+{
+    if (other.totalWeight == 0)
+    {
+        return;
+    }
+
+    if (totalWeight == 0)
+    {
+        min = other.min;
+        max = other.max;
+    }
+
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    totalWeight += other.totalWeight;
+    buffer.insert(buffer.end(), other.centroids.begin(), other.centroids.end());
+    buffer.insert(buffer.end(), other.buffer.begin(), other.buffer.end());
+    compress();
+}
+
+/*
+    Merge the buffered values into the centroids. Neighbouring centroids are
+    combined for as long as the combined centroid spans no more than one unit
+    of the scale function.
+
+    @return
+        void
+*/
+void BethYw::TDigest::compress()
+{
+    if (buffer.empty())
+    {
+        return;
+    }
+
+    buffer.insert(buffer.end(), centroids.begin(), centroids.end());
+    std::sort(buffer.begin(), buffer.end(), [](const Centroid &a, const Centroid &b) {
+        return a.mean < b.mean;
+    });
+
+    centroids.clear();
+    Centroid current = buffer.front();
+    double weightSoFar = 0;
+    double limit = totalWeight * inverseScale(scale(0, compression) + 1, compression);
+
+    for (size_t i = 1; i < buffer.size(); i++)
+    {
+        const Centroid &next = buffer[i];
+
+        if (weightSoFar + current.weight + next.weight <= limit)
+        {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        }
+        else
+        {
+            weightSoFar += current.weight;
+            centroids.push_back(current);
+            limit = totalWeight * inverseScale(scale(weightSoFar / totalWeight, compression) + 1, compression);
+            current = next;
+        }
+    }
+
+    centroids.push_back(current);
+    buffer.clear();
+}
+
+/*
+    Retrieve the total weight of the values added.
+
+    @return
+        The number of values added, if each had a weight of 1
+*/
+const double BethYw::TDigest::size() const noexcept
+{
+    return totalWeight;
+}
+
+/*
+    Retrieve the number of centroids, after merging any buffered values.
+
+    @return
+        The number of centroids
+*/
+const size_t BethYw::TDigest::centroidCount()
+{
+    compress();
+    return centroids.size();
+}
+
+/*
+    Estimate a quantile. Each centroid is placed at the middle of the ranks
+    it covers, and the quantile is interpolated linearly between the
+    centroids either side of it (or the minimum or maximum at the ends).
+
+    @param q
+        The quantile, between 0 and 1
+
+    @return
+        The estimated value at the quantile, or 0 if the digest is empty
+*/
+const double BethYw::TDigest::quantile(const double q)
+{
+    compress();
+
+    if (centroids.empty())
+    {
+        return 0;
+    }
+
+    const double target = std::max(0.0, std::min(1.0, q)) * totalWeight;
+    double previousRank = 0;
+    double previousMean = min;
+    double cumulative = 0;
+
+    for (auto &centroid : centroids)
+    {
+        const double rank = cumulative + centroid.weight / 2;
+
+        if (target <= rank)
+        {
+            if (rank == previousRank)
+            {
+                return centroid.mean;
+            }
+
+            const double t = (target - previousRank) / (rank - previousRank);
+            return previousMean + t * (centroid.mean - previousMean);
+        }
+
+        previousRank = rank;
+        previousMean = centroid.mean;
+        cumulative += centroid.weight;
+    }
+
+    if (totalWeight == previousRank)
+    {
+        return max;
+    }
+
+    const double t = (target - previousRank) / (totalWeight - previousRank);
+    return previousMean + t * (max - previousMean);
+}
+
+/*
+    Build a digest of each measure's values across every area and year. The
+    Areas are read once, on the calling thread (so spilled runs are only read
+    once), and dealt out in numbered chunks through a queue to the worker
+    threads. Each chunk is digested on its own, and the chunk digests are
+    merged in chunk order as they finish. Merging digests depends on their
+    order, so this makes the result the same whatever the number of threads
+    and whichever thread digests each chunk. The queue is bounded, so only a
+    few chunks are held at a time.
+
+    @param areas
+        The Areas to digest
+
+    @param threads
+        The number of threads to use, or 0 to use one per hardware thread
+
+    @return
+        A map of measure codenames to their labels and digests
+
+    @throws
+        std::runtime_error if a run file cannot be read
+*/
+std::map<std::string, BethYw::MeasureDigest> BethYw::digestMeasures(const Areas &areas, unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    using Digests = std::map<std::string, MeasureDigest>;
+
+    Digests digests;
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable space;
+    std::deque<std::pair<size_t, std::vector<Area>>> queue;
+    bool done = false;
+
+    // The chunk digests that finished before an earlier chunk, and the
+    // number of the next chunk to merge
+    std::mutex mergeMutex;
+    std::map<size_t, Digests> finished;
+    size_t nextMerge = 0;
+
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            while (true)
+            {
+                std::pair<size_t, std::vector<Area>> chunk;
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [&]() { return !queue.empty() || done; });
+
+                    if (queue.empty())
+                    {
+                        return;
+                    }
+
+                    chunk = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                space.notify_one();
+
+                // Keep taking chunks after an error, so the reader is never
+                // left waiting for space
+                if (errors[t])
+                {
+                    continue;
+                }
+
+                try
+                {
+                    Digests partial;
+
+                    for (auto &area : chunk.second)
+                    {
+                        for (auto &measure : area.getMeasures())
+                        {
+                            MeasureDigest &entry = partial[measure.first];
+                            entry.label = measure.second.getLabel();
+
+                            for (auto &value : measure.second.getValues())
+                            {
+                                entry.digest.add(value.second);
+                            }
+                        }
+                    }
+
+                    std::lock_guard<std::mutex> lock(mergeMutex);
+                    finished.emplace(chunk.first, std::move(partial));
+
+                    for (auto it = finished.begin(); it != finished.end() && it->first == nextMerge;
+                         it = finished.erase(it), nextMerge++)
+                    {
+                        for (auto &measure : it->second)
+                        {
+                            MeasureDigest &entry = digests[measure.first];
+                            entry.label = measure.second.label;
+                            entry.digest.merge(measure.second.digest);
+                        }
+                    }
+                }
+                catch(...)
+                {
+                    errors[t] = std::current_exception();
+                }
+            }
+        });
+    }
+
+    const size_t capacity = DIGEST_CHUNKS_PER_THREAD * threads;
+    size_t chunks = 0;
+    std::vector<Area> chunk;
+
+    auto deal = [&]() {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            space.wait(lock, [&]() { return queue.size() < capacity; });
+            queue.emplace_back(chunks++, std::move(chunk));
+        }
+
+        ready.notify_one();
+        chunk = std::vector<Area>();
+    };
+
+    std::exception_ptr readError;
+
+    try
+    {
+        areas.forEachArea([&](const Area &area) {
+            chunk.push_back(area);
+
+            if (chunk.size() == DIGEST_CHUNK_SIZE)
+            {
+                deal();
+            }
+        });
+
+        if (!chunk.empty())
+        {
+            deal();
+        }
+    }
+    catch(...)
+    {
+        readError = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+
+    ready.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    if (readError)
+    {
+        std::rethrow_exception(readError);
+    }
+
+    for (auto &error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    return digests;
+}
+
+/*
+    Write the quantiles of each measure as tables, in the same format as the
+    Measure tables, ordered by codename.
+
+    @param os
+        The output stream to write to
+
+    @param digests
+        The digests from digestMeasures()
+
+    @return
+        void
+*/
+void BethYw::writeQuantiles(std::ostream &os, std::map<std::string, MeasureDigest> &digests)
+{
+    if (digests.empty())
+    {
+        os << "<no data>" << std::endl;
+        return;
+    }
+
+    for (auto &it : digests)
+    {
+        std::string headings;
+        std::string values;
+
+        for (auto &quantile : QUANTILES)
+        {
+            std::string header = quantile.first;
+            std::string value = std::to_string(it.second.digest.quantile(quantile.second));
+            rightAlign(header, value);
+            headings += (headings.empty() ? "" : " ") + header;
+            values += (values.empty() ? "" : " ") + value;
+        }
+
+        os << it.second.label << " (" << it.first << ")" << std::endl
+           << headings << std::endl
+           << values << std::endl
+           << std::endl;
+    }
+}
+
+/*
+    Write the quantiles of each measure as a JSON object, mapping each
+    codename to an object of quantiles, e.g. {"pop":{"p50":...,"p90":...}}.
+
+    @param os
+        The output stream to write to
+
+    @param digests
+        The digests from digestMeasures()
+
+    @return
+        void
+*/
+void BethYw::writeQuantilesJSON(std::ostream &os, std::map<std::string, MeasureDigest> &digests)
+{
+    json j = json::object();
+
+    for (auto &it : digests)
+    {
+        for (auto &quantile : QUANTILES)
+        {
+            j[it.first][quantile.first] = it.second.digest.quantile(quantile.second);
+        }
+    }
+
+    os << j.dump();
+}
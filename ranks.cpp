@@ -0,0 +1,169 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the per-year ranks and
+    percentiles of each area.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <map>
+#include <thread>
+#include <utility>
+
+#include "ranks.h"
+
+/*
+    Sort a column and fill in the rank and percentile of each of its values.
+    Values that are not a number are ranked last, tied with each other.
+
+    @param column
+        The column, with its areaIds and values set
+
+    @return
+        void
+*/
+void BethYw::rankColumn(RankColumn &column)
+{
+    const size_t length = column.values.size();
+    const std::vector<double> &values = column.values;
+    std::vector<uint32_t> order(length);
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        order[i] = i;
+    }
+
+    // NaN compares false with everything, so it is ordered explicitly to
+    // keep the comparison a strict weak ordering
+    auto tied = [&values](uint32_t a, uint32_t b) {
+        return values[a] == values[b] || (std::isnan(values[a]) && std::isnan(values[b]));
+    };
+
+    std::sort(order.begin(), order.end(), [&values, &tied](uint32_t a, uint32_t b) {
+        if (std::isnan(values[a]) != std::isnan(values[b]))
+        {
+            return std::isnan(values[b]);
+        }
+
+        return values[a] > values[b] || (tied(a, b) && a < b);
+    });
+
+    column.ranks.assign(length, 0);
+    column.percentiles.assign(length, 100);
+
+    size_t i = 0;
+    while (i < length)
+    {
+        // Find the values tied with this one
+        size_t end = i + 1;
+        while (end < length && tied(order[end], order[i]))
+        {
+            end++;
+        }
+
+        for (size_t j = i; j < end; j++)
+        {
+            column.ranks[order[j]] = i + 1;
+
+            if (length > 1)
+            {
+                column.percentiles[order[j]] = 100.0 * (length - end) / (length - 1);
+            }
+        }
+
+        i = end;
+    }
+}
+
+/*
+    Rank every area for each measure in each year, and add the ranks and
+    percentiles to the areas as derived Measures (see ranks.h).
+
+    @param areas
+        The Areas to rank, which must all be in memory
+
+    @param threads
+        The number of threads to use, or 0 to use one per hardware thread
+
+    @return
+        void
+*/
+void BethYw::addRanks(Areas &areas, unsigned int threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Gather the values into a column for each measure and year
+    std::vector<std::string> codes;
+    std::vector<RankColumn> columns;
+    std::map<std::pair<std::string, unsigned int>, size_t> columnIndex;
+
+    areas.forEachArea([&](const Area &area) {
+        const uint32_t areaId = codes.size();
+        codes.push_back(area.getLocalAuthorityCode());
+
+        for (auto &measure : area.getMeasures())
+        {
+            for (auto &value : measure.second.getValues())
+            {
+                auto it = columnIndex.find(std::make_pair(measure.first, value.first));
+
+                if (it == columnIndex.end())
+                {
+                    it = columnIndex.emplace(std::make_pair(measure.first, value.first), columns.size()).first;
+                    columns.emplace_back();
+                    columns.back().codename = measure.first;
+                    columns.back().label = measure.second.getLabel();
+                    columns.back().year = value.first;
+                }
+
+                columns[it->second].areaIds.push_back(areaId);
+                columns[it->second].values.push_back(value.second);
+            }
+        }
+    });
+
+    // Each column is sorted once, with the columns shared out between threads
+    threads = std::max(1u, std::min<unsigned int>(threads, columns.size()));
+    std::vector<std::thread> workers;
+
+    for (unsigned int t = 1; t < threads; t++)
+    {
+        workers.emplace_back([&columns, threads, t]() {
+            for (size_t i = t; i < columns.size(); i += threads)
+            {
+                rankColumn(columns[i]);
+            }
+        });
+    }
+
+    for (size_t i = 0; i < columns.size(); i += threads)
+    {
+        rankColumn(columns[i]);
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (auto &column : columns)
+    {
+        for (size_t i = 0; i < column.areaIds.size(); i++)
+        {
+            Area &area = areas.getArea(codes[column.areaIds[i]]);
+            area.emplaceMeasure(column.codename + RANK_SUFFIX, column.label + " rank")
+                .setValue(column.year, column.ranks[i]);
+            area.emplaceMeasure(column.codename + PERCENTILE_SUFFIX, column.label + " percentile")
+                .setValue(column.year, column.percentiles[i]);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef RANKS_H_
+#define RANKS_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for ranking areas against each other, for
+    each measure in each year.
+
+    The values of one measure in one year across all areas are gathered into
+    a contiguous column, which is sorted once. The columns are independent,
+    so they are shared out between threads. The ranks are then added to each
+    Area as two derived Measures, e.g. for "pop":
+
+        pop-rank        1 for the largest value, with tied values sharing the
+                        best rank (e.g. 1, 2, 2, 4)
+        pop-percentile  The percentage of the other areas with a smaller
+                        value, so the largest is 100 and the smallest is 0
+
+    Only areas with a value for that year are ranked.
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+
+namespace BethYw
+{
+    /*
+        The suffixes of the codenames of the derived Measures.
+    */
+    const std::string RANK_SUFFIX = "-rank";
+    const std::string PERCENTILE_SUFFIX = "-percentile";
+
+    /*
+        The values of one measure in one year across all areas, and their
+        ranks once sorted.
+    */
+    struct RankColumn
+    {
+        std::string codename;
+        std::string label;
+        unsigned int year;
+        std::vector<uint32_t> areaIds;
+        std::vector<double> values;
+        std::vector<unsigned int> ranks;
+        std::vector<double> percentiles;
+    };
+
+    void rankColumn(RankColumn &column);
+    void addRanks(Areas &areas, unsigned int threads = 0);
+}
+
+#endif // RANKS_H_
@@ -0,0 +1,199 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the RowStream stages that do not
+    depend on the type of item, i.e. reading bytes and splitting lines and
+    fields.
+*/
+
+#include <cstring>
+
+#include "rowstream.h"
+
+/*
+    Construct a source of blocks of bytes.
+
+    @param is
+        The input stream to read, which must outlive the source
+
+    @param blockSize
+        The largest number of bytes in each block
+*/
+BethYw::ByteSource::ByteSource(std::istream &is, const size_t blockSize)
+    : is(is), blockSize(blockSize)
+{
+}
+
+/*
+    Read the next block of bytes.
+
+    @param block
+        Set to the bytes read
+
+    @return
+        true if any bytes were read, false at the end of the stream
+*/
+bool BethYw::ByteSource::next(std::string &block)
+{
+    block.resize(blockSize);
+    is.read(&block[0], blockSize);
+    block.resize(is.gcount());
+
+    return !block.empty();
+}
+
+/*
+    Construct a stream of the lines in a stream of blocks.
+
+    @param upstream
+        The blocks, e.g. from a ByteSource
+
+    @param maxLineLength
+        The most bytes a line may have (see ParserLimits)
+*/
+BethYw::LineSplitter::LineSplitter(RowStreamPtr<std::string> upstream, const size_t maxLineLength)
+    : upstream(std::move(upstream)), maxLineLength(maxLineLength)
+{
+}
+
+/*
+    Produce the next line, joining blocks where a line crosses from one to
+    the next.
+
+    @param line
+        Set to the line, without its '\n'
+
+    @return
+        true if there was a line, false at the end of the stream
+
+    @throws
+        BethYw::ParserLimitError if the line is longer than the limit, which
+        is thrown once the limit is reached rather than at the end of the line
+*/
+bool BethYw::LineSplitter::next(std::string &line)
+{
+    line.clear();
+
+    while (!finished)
+    {
+        const char *start = block.data() + position;
+        const size_t remaining = block.size() - position;
+        const void *newline = std::memchr(start, '\n', remaining);
+        const size_t length = newline != nullptr ? static_cast<const char *>(newline) - start : remaining;
+
+        if (length > maxLineLength - line.size())
+        {
+            throw ParserLimitError("Line longer than the limit of " + std::to_string(maxLineLength) + " bytes!");
+        }
+
+        line.append(start, length);
+
+        if (newline != nullptr)
+        {
+            position += length + 1;
+            return true;
+        }
+
+        position = 0;
+
+        if (!upstream->next(block))
+        {
+            block.clear();
+            finished = true;
+        }
+    }
+
+    return !line.empty();
+}
+
+/*
+    Split a line into fields, with the same results as calling
+    std::getline() with a delimiter until it fails, i.e. an empty final
+    field is dropped.
+
+    @param line
+        The line to split
+
+    @param delimiter
+        The character between fields
+
+    @return
+        The fields
+*/
+std::vector<std::string> BethYw::splitFields(const std::string &line, const char delimiter)
+{
+    std::vector<std::string> fields;
+    size_t start = 0;
+
+    while (start < line.size())
+    {
+        size_t end = line.find(delimiter, start);
+
+        if (end == std::string::npos)
+        {
+            end = line.size();
+        }
+
+        fields.emplace_back(line, start, end - start);
+        start = end + 1;
+    }
+
+    return fields;
+}
+
+/*
+    Split a line into fields as splitFields() does, checking the number of
+    fields and the size of each against the limits as it goes.
+
+    @param line
+        The line to split
+
+    @param limits
+        The limits on the fields (see ParserLimits)
+
+    @param delimiter
+        The character between fields
+
+    @return
+        The fields
+
+    @throws
+        BethYw::ParserLimitError if there are too many fields or a field is
+        too large
+*/
+std::vector<std::string> BethYw::splitFields(const std::string &line, const ParserLimits &limits,
+                                             const char delimiter)
+{
+    std::vector<std::string> fields;
+    size_t start = 0;
+
+    while (start < line.size())
+    {
+        size_t end = line.find(delimiter, start);
+
+        if (end == std::string::npos)
+        {
+            end = line.size();
+        }
+
+        if (end - start > limits.maxFieldSize)
+        {
+            throw ParserLimitError("Field larger than the limit of " + std::to_string(limits.maxFieldSize)
+                                   + " bytes!");
+        }
+
+        if (fields.size() == limits.maxColumns)
+        {
+            throw ParserLimitError("More columns than the limit of " + std::to_string(limits.maxColumns) + "!");
+        }
+
+        fields.emplace_back(line, start, end - start);
+        start = end + 1;
+    }
+
+    return fields;
+}
@@ -0,0 +1,398 @@
+#ifndef ROWSTREAM_H_
+#define ROWSTREAM_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the RowStream abstraction used to import data as a
+    pipeline of stages, e.g. for a CSV file:
+
+        ByteSource -> LineSplitter -> column plan -> filter -> converter -> sink
+
+    A RowStream is a generator: each call to next() produces the next item,
+    or returns false at the end. A Stage pulls items from the stream before
+    it and turns each one into zero or more items, so stages compose by
+    wrapping one stream in another. The sink is whatever loop drains the last
+    stream.
+
+    Wrapping a stream in a ThreadedStage runs it (and everything before it)
+    on its own thread, connected to the next stage by a bounded
+    single-producer, single-consumer queue. An exception thrown on that
+    thread is passed along the queue and rethrown by next() in the consumer,
+    after the items before it.
+
+    We are on C++14, so generators are written as classes with a next()
+    function rather than as coroutines.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace BethYw
+{
+    /*
+        The number of items each ThreadedStage can queue before its producer
+        has to wait.
+    */
+    constexpr size_t STAGE_QUEUE_CAPACITY = 1024;
+
+    /*
+        A generator of items.
+    */
+    template <typename T>
+    class RowStream
+    {
+    public:
+        virtual ~RowStream() {}
+
+        /*
+            Produce the next item.
+
+            @param item
+                Set to the next item
+
+            @return
+                true if there was an item, false at the end of the stream
+        */
+        virtual bool next(T &item) = 0;
+    };
+
+    template <typename T>
+    using RowStreamPtr = std::unique_ptr<RowStream<T>>;
+
+    /*
+        A bounded, lock-free queue between exactly one producer thread and one
+        consumer thread. A side that has to wait yields, and then sleeps
+        briefly if the wait goes on.
+    */
+    template <typename T>
+    class SpscQueue
+    {
+    private:
+        std::vector<T> slots;
+        std::atomic<size_t> head;
+        std::atomic<size_t> tail;
+        std::atomic<bool> closed;
+        std::atomic<bool> cancelled;
+
+        static void wait(unsigned int &spins)
+        {
+            if (++spins < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+
+    public:
+        SpscQueue(const size_t capacity)
+            : slots(capacity + 1), head(0), tail(0), closed(false), cancelled(false)
+        {
+        }
+
+        /*
+            Add an item, waiting while the queue is full. Only the producer
+            may call this.
+
+            @return
+                true if the item was added, false if the queue was cancelled
+        */
+        bool push(T &&item)
+        {
+            const size_t position = tail.load(std::memory_order_relaxed);
+            const size_t following = (position + 1) % slots.size();
+            unsigned int spins = 0;
+
+            while (following == head.load(std::memory_order_acquire))
+            {
+                if (cancelled.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+
+                wait(spins);
+            }
+
+            slots[position] = std::move(item);
+            tail.store(following, std::memory_order_release);
+            return true;
+        }
+
+        /*
+            Remove an item, waiting while the queue is empty. Only the
+            consumer may call this.
+
+            @return
+                true if there was an item, false if the queue is empty and
+                closed
+        */
+        bool pop(T &item)
+        {
+            const size_t position = head.load(std::memory_order_relaxed);
+            unsigned int spins = 0;
+
+            while (position == tail.load(std::memory_order_acquire))
+            {
+                if (closed.load(std::memory_order_acquire))
+                {
+                    // Anything pushed before closing is visible now
+                    if (position == tail.load(std::memory_order_acquire))
+                    {
+                        return false;
+                    }
+
+                    break;
+                }
+
+                wait(spins);
+            }
+
+            item = std::move(slots[position]);
+            head.store((position + 1) % slots.size(), std::memory_order_release);
+            return true;
+        }
+
+        /*
+            Mark the end of the items. Only the producer may call this.
+        */
+        void close()
+        {
+            closed.store(true, std::memory_order_release);
+        }
+
+        /*
+            Stop the producer waiting for space, e.g. when the consumer has
+            stopped early.
+        */
+        void cancel()
+        {
+            cancelled.store(true, std::memory_order_release);
+        }
+    };
+
+    /*
+        A stream that turns each item of the stream before it into zero or
+        more items with a function, e.g. a tokenizer, a filter or a converter.
+    */
+    template <typename In, typename Out>
+    class Stage : public RowStream<Out>
+    {
+    public:
+        using Function = std::function<void(In &item, std::vector<Out> &out)>;
+
+    private:
+        RowStreamPtr<In> upstream;
+        Function function;
+        std::vector<Out> pending;
+        size_t index = 0;
+
+    public:
+        Stage(RowStreamPtr<In> upstream, Function function)
+            : upstream(std::move(upstream)), function(std::move(function))
+        {
+        }
+
+        bool next(Out &item) override
+        {
+            while (index >= pending.size())
+            {
+                pending.clear();
+                index = 0;
+
+                In input;
+                if (!upstream->next(input))
+                {
+                    return false;
+                }
+
+                function(input, pending);
+            }
+
+            item = std::move(pending[index++]);
+            return true;
+        }
+    };
+
+    /*
+        A stream that runs the stream before it on its own thread, passing the
+        items (and any exception) through an SpscQueue.
+    */
+    template <typename T>
+    class ThreadedStage : public RowStream<T>
+    {
+    private:
+        RowStreamPtr<T> upstream;
+        SpscQueue<T> queue;
+        std::exception_ptr error;
+        std::thread worker;
+
+    public:
+        ThreadedStage(RowStreamPtr<T> upstream, const size_t capacity = STAGE_QUEUE_CAPACITY)
+            : upstream(std::move(upstream)), queue(capacity)
+        {
+            worker = std::thread([this]() {
+                try
+                {
+                    T item;
+                    while (this->upstream->next(item))
+                    {
+                        if (!queue.push(std::move(item)))
+                        {
+                            break;
+                        }
+                    }
+                }
+                catch(...)
+                {
+                    error = std::current_exception();
+                }
+
+                queue.close();
+            });
+        }
+
+        ~ThreadedStage()
+        {
+            queue.cancel();
+            worker.join();
+        }
+
+        ThreadedStage(const ThreadedStage &) = delete;
+        ThreadedStage &operator=(const ThreadedStage &) = delete;
+
+        bool next(T &item) override
+        {
+            if (queue.pop(item))
+            {
+                return true;
+            }
+
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+
+            return false;
+        }
+    };
+
+    /*
+        Add a stage to a pipeline, running everything before it on its own
+        thread if `threaded` is true.
+
+        @param upstream
+            The stream before the stage
+
+        @param function
+            The function of the stage (see Stage)
+
+        @param threaded
+            Whether to run the upstream stream on its own thread
+
+        @return
+            The stream of the stage's output
+    */
+    template <typename In, typename Out>
+    RowStreamPtr<Out> addStage(RowStreamPtr<In> upstream,
+                               typename Stage<In, Out>::Function function,
+                               const bool threaded = true)
+    {
+        if (threaded)
+        {
+            upstream = RowStreamPtr<In>(new ThreadedStage<In>(std::move(upstream)));
+        }
+
+        return RowStreamPtr<Out>(new Stage<In, Out>(std::move(upstream), std::move(function)));
+    }
+
+    /*
+        Limits on the shape of the input a parser accepts, so a file with e.g.
+        one enormous line, a huge string, deeply nested JSON or millions of
+        columns fails straight away with a ParserLimitError, rather than
+        using far more memory and time than a normal file. The limits are
+        checked as the input is parsed, so the error comes at the first line,
+        field or value that breaks one, and a CSV line is never buffered
+        beyond the line limit.
+
+            maxLineLength   bytes in a line of a CSV or JSON Lines file
+            maxFieldSize    bytes in a CSV field or JSON string
+            maxDepth        levels of nested JSON arrays and objects
+            maxColumns      fields in a CSV line, or members in a JSON object
+                            (arrays are not limited, as the rows of a
+                            WelshStatsJSON file are one array)
+    */
+    struct ParserLimits
+    {
+        size_t maxLineLength = 16 * 1024 * 1024;
+        size_t maxFieldSize = 1024 * 1024;
+        size_t maxDepth = 64;
+        size_t maxColumns = 100000;
+    };
+
+    /*
+        The error thrown when the input breaks one of the ParserLimits.
+    */
+    class ParserLimitError : public std::runtime_error
+    {
+    public:
+        ParserLimitError(const std::string &what)
+            : std::runtime_error(what)
+        {
+        }
+    };
+
+    /*
+        Reads an input stream in blocks of bytes.
+    */
+    class ByteSource : public RowStream<std::string>
+    {
+    private:
+        std::istream &is;
+        size_t blockSize;
+
+    public:
+        ByteSource(std::istream &is, const size_t blockSize = 64 * 1024);
+        bool next(std::string &block) override;
+    };
+
+    /*
+        Splits blocks of bytes into lines, with the same results as calling
+        std::getline() until it fails (the '\n' is removed, anything else
+        such as '\r' is kept, and there is no empty line after a final '\n').
+    */
+    class LineSplitter : public RowStream<std::string>
+    {
+    private:
+        RowStreamPtr<std::string> upstream;
+        std::string block;
+        size_t position = 0;
+        bool finished = false;
+        size_t maxLineLength;
+
+    public:
+        LineSplitter(RowStreamPtr<std::string> upstream, const size_t maxLineLength = SIZE_MAX);
+        bool next(std::string &line) override;
+    };
+
+    std::vector<std::string> splitFields(const std::string &line, const char delimiter = ',');
+    std::vector<std::string> splitFields(const std::string &line, const ParserLimits &limits,
+                                         const char delimiter = ',');
+}
+
+#endif // ROWSTREAM_H_
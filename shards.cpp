@@ -0,0 +1,378 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation for running Beth Yw? across multiple
+    processes, with each worker process importing and outputting a range of
+    local authority codes.
+*/
+
+#include <iostream>
+#include <stdexcept>
+#include <streambuf>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "shards.h"
+
+#ifndef _WIN32
+namespace
+{
+    /*
+        A stream buffer that writes to a file descriptor, so a worker can
+        stream its output into a pipe.
+    */
+    class FileDescriptorBuffer : public std::streambuf
+    {
+    private:
+        int fd;
+        char buffer[64 * 1024];
+
+        bool flush()
+        {
+            const char *data = pbase();
+            size_t remaining = pptr() - pbase();
+
+            while (remaining > 0)
+            {
+                ssize_t written = ::write(fd, data, remaining);
+
+                if (written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                if (written <= 0)
+                {
+                    return false;
+                }
+
+                data += written;
+                remaining -= written;
+            }
+
+            setp(buffer, buffer + sizeof(buffer));
+            return true;
+        }
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (!flush())
+            {
+                return traits_type::eof();
+            }
+
+            if (c != traits_type::eof())
+            {
+                *pptr() = (char)c;
+                pbump(1);
+            }
+
+            return traits_type::not_eof(c);
+        }
+
+        int sync() override
+        {
+            return flush() ? 0 : -1;
+        }
+
+    public:
+        FileDescriptorBuffer(int fd)
+            : fd(fd)
+        {
+            setp(buffer, buffer + sizeof(buffer));
+        }
+    };
+
+    /*
+        Copy everything from a file descriptor to the standard output.
+
+        @param fd
+            The file descriptor to read from
+
+        @return
+            The number of bytes copied
+    */
+    size_t copyToStdout(int fd)
+    {
+        char buffer[64 * 1024];
+        size_t total = 0;
+
+        while (true)
+        {
+            ssize_t bytes = ::read(fd, buffer, sizeof(buffer));
+
+            if (bytes < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (bytes <= 0)
+            {
+                break;
+            }
+
+            std::cout.write(buffer, bytes);
+            total += bytes;
+        }
+
+        return total;
+    }
+
+    /*
+        Import and output one shard in a worker process. The Areas live only
+        in this function, so they (and any run files they spilled) are cleaned
+        up before the worker exits.
+
+        @param lower
+            The first local authority code of the shard, or empty for none
+
+        @param upper
+            The first local authority code after the shard, or empty for none
+
+        @param load
+            A function that imports the data into an Areas instance
+
+        @param json
+            Whether to output JSON instead of tables
+
+        @param fd
+            The file descriptor of the pipe to write to
+
+        @return
+            Exit code
+    */
+    int runShardWorker(const std::string &lower, const std::string &upper,
+                       const std::function<void(Areas &)> &load, const bool json, const int fd)
+    {
+        FileDescriptorBuffer buffer(fd);
+        std::ostream os(&buffer);
+
+        Areas data = Areas();
+        data.setShard(lower, upper);
+        load(data);
+
+        if (json)
+        {
+            data.writeJSONMembers(os);
+        }
+        else
+        {
+            data.forEachArea([&os](const Area &area) {
+                os << area << std::endl;
+            });
+        }
+
+        os.flush();
+        return os.good() ? 0 : 1;
+    }
+}
+#endif
+
+/*
+    Split the local authority codes in `areas` into contiguous ranges of
+    roughly equal size, for running across multiple processes. Codes that
+    are not in `areas` still fall into exactly one range, so this can be
+    called with just areas.csv imported.
+
+    @param areas
+        An Areas instance whose local authority codes to split
+
+    @param shards
+        The number of ranges wanted
+
+    @return
+        The first local authority code of every range except the first, in
+        order. There may be fewer than `shards` - 1 if there are not enough
+        codes to split.
+*/
+std::vector<std::string> BethYw::shardBoundaries(const Areas &areas, const unsigned int shards)
+{
+    std::vector<std::string> codes;
+    areas.forEachArea([&codes](const Area &area) {
+        codes.push_back(area.getLocalAuthorityCode());
+    });
+
+    std::vector<std::string> boundaries;
+
+    for (unsigned int i = 1; i < shards; i++)
+    {
+        const size_t index = codes.size() * i / shards;
+
+        if (index > 0 && index < codes.size()
+            && (boundaries.empty() || boundaries.back() < codes[index]))
+        {
+            boundaries.push_back(codes[index]);
+        }
+    }
+
+    return boundaries;
+}
+
+/*
+    Fork a worker process for each range of local authority codes given by
+    `boundaries`. Each worker calls `load` on an Areas instance restricted to
+    its range, and writes the Areas as tables or JSON (without the enclosing
+    braces) to a pipe. The coordinator copies each worker's output to the
+    standard output in order, so the combined output is the same as running
+    in a single process.
+
+    Only the first worker reports import errors, as every worker reads the
+    same files and so encounters the same errors.
+
+    @param boundaries
+        The first local authority code of every range except the first, as
+        returned by shardBoundaries()
+
+    @param load
+        A function that imports the data into an Areas instance
+
+    @param json
+        Whether to output JSON instead of tables
+
+    @return
+        Exit code
+
+    @throws
+        std::runtime_error if a worker cannot be started
+*/
+int BethYw::runShards(const std::vector<std::string> &boundaries,
+                      const std::function<void(Areas &)> &load,
+                      const bool json)
+{
+#ifdef _WIN32
+    throw std::runtime_error("BethYw::runShards: Sharded execution is not supported on this platform");
+#else
+    const size_t shards = boundaries.size() + 1;
+    std::vector<int> pipes;
+    std::vector<pid_t> workers;
+
+    // Anything buffered would otherwise be written by every worker too
+    std::cout.flush();
+    std::cerr.flush();
+
+    for (size_t i = 0; i < shards; i++)
+    {
+        int fds[2];
+
+        if (pipe(fds) != 0)
+        {
+            throw std::runtime_error("BethYw::runShards: Failed to create pipe");
+        }
+
+        pid_t pid = fork();
+
+        if (pid < 0)
+        {
+            throw std::runtime_error("BethYw::runShards: Failed to start worker");
+        }
+
+        if (pid == 0)
+        {
+            close(fds[0]);
+            for (int fd : pipes)
+            {
+                close(fd);
+            }
+
+            if (i > 0)
+            {
+                std::cerr.rdbuf(nullptr);
+            }
+
+            // An exception must not unwind into the coordinator's code in
+            // this process, so it ends the worker instead
+            int status = 1;
+
+            try
+            {
+                status = runShardWorker(i > 0 ? boundaries[i - 1] : "",
+                                        i < boundaries.size() ? boundaries[i] : "",
+                                        load, json, fds[1]);
+            }
+            catch(const std::exception& e)
+            {
+                std::cerr << e.what() << std::endl;
+            }
+            catch(...)
+            {
+            }
+
+            close(fds[1]);
+            _exit(status);
+        }
+
+        close(fds[1]);
+        pipes.push_back(fds[0]);
+        workers.push_back(pid);
+    }
+
+    size_t total = 0;
+
+    if (json)
+    {
+        std::cout << "{";
+    }
+
+    for (size_t i = 0; i < shards; i++)
+    {
+        // Workers write nothing if they have no areas, so only separate the
+        // JSON members once the next worker has written something
+        if (json && total > 0)
+        {
+            char first;
+            ssize_t bytes;
+
+            do
+            {
+                bytes = ::read(pipes[i], &first, 1);
+            } while (bytes < 0 && errno == EINTR);
+
+            if (bytes == 1)
+            {
+                std::cout << "," << first;
+                total++;
+            }
+        }
+
+        total += copyToStdout(pipes[i]);
+        close(pipes[i]);
+    }
+
+    if (json)
+    {
+        std::cout << "}" << std::endl;
+    }
+    else
+    {
+        if (total == 0)
+        {
+            std::cout << "<no areas>" << std::endl;
+        }
+
+        std::cout << std::endl;
+    }
+
+    int exitCode = 0;
+
+    for (pid_t pid : workers)
+    {
+        int status;
+
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            exitCode = 1;
+        }
+    }
+
+    return exitCode;
+#endif
+}
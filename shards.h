@@ -0,0 +1,32 @@
+#ifndef SHARDS_H_
+#define SHARDS_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for running Beth Yw? across multiple
+    processes. A coordinator forks one worker per shard, where each shard is
+    a contiguous range of local authority codes. Each worker only imports the
+    rows in its range and writes its (ordered) part of the output to a pipe,
+    which the coordinator copies to the standard output in shard order.
+ */
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+
+namespace BethYw
+{
+    std::vector<std::string> shardBoundaries(const Areas &areas, const unsigned int shards);
+    int runShards(const std::vector<std::string> &boundaries,
+                  const std::function<void(Areas &)> &load,
+                  const bool json);
+}
+
+#endif // SHARDS_H_
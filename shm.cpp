@@ -0,0 +1,373 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation for sharing imported data between
+    invocations through POSIX shared memory.
+
+    A segment is laid out as a SharedHeader followed by the Areas written one
+    after another with BethYw::writeArea(). The format only contains lengths
+    and counts, never pointers, so it can be mapped at any address.
+*/
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <sstream>
+#include <streambuf>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "shm.h"
+#include "store.h"
+
+#ifndef _WIN32
+namespace
+{
+    const char SHARED_MAGIC[8] = {'B', 'E', 'T', 'H', 'Y', 'W', 'S', 'H'};
+
+    /*
+        The header at the start of every segment. `ready` is only set once the
+        data has been completely written, so readers never see a partial
+        segment.
+    */
+    struct SharedHeader
+    {
+        char magic[8];
+        uint32_t version;
+        std::atomic<uint32_t> ready;
+        uint64_t fingerprint;
+        uint64_t size;
+        int64_t writer;
+    };
+
+    /*
+        Check whether a segment that is not ready was abandoned by the
+        process writing it: either that process has gone away, or the
+        segment has been left without a writer (i.e. its writer died before
+        it could fill in the header) for longer than orphanSeconds.
+
+        @param info
+            The status of the segment from fstat()
+
+        @param header
+            The header of the segment, or null if it is too small to hold one
+
+        @param orphanSeconds
+            How long a segment without a writer is given to get one
+
+        @return
+            true if the segment will never be ready
+    */
+    bool isAbandoned(const struct stat &info, const SharedHeader *const header, const unsigned int orphanSeconds)
+    {
+        if (header != nullptr && header->writer != 0)
+        {
+            return kill((pid_t)header->writer, 0) != 0 && errno == ESRCH;
+        }
+
+        return std::time(nullptr) - info.st_ctime >= (std::time_t)orphanSeconds;
+    }
+}
+#endif
+
+/*
+    Get the shared memory segment name for a key describing what was imported
+    (e.g. the data directory, datasets and filters).
+
+    @param key
+        A string that is the same for invocations that import the same data
+
+    @return
+        The segment name, of the form /bethyw-<hash>
+*/
+std::string BethYw::sharedSegmentName(const std::string &key)
+{
+    std::ostringstream name;
+    name << "/bethyw-" << std::hex << hashBytes(key.data(), key.size());
+    return name.str();
+}
+
+/*
+    Fingerprint a set of files by their paths, sizes and modification times.
+    A file that does not exist still contributes its path, so creating it
+    changes the fingerprint.
+
+    @param paths
+        The paths of the files
+
+    @return
+        The fingerprint
+*/
+uint64_t BethYw::fingerprintFiles(const std::vector<std::string> &paths)
+{
+    uint64_t fingerprint = hashBytes(reinterpret_cast<const char *>(&SHARED_FORMAT_VERSION),
+                                     sizeof(SHARED_FORMAT_VERSION));
+
+    for (auto &path : paths)
+    {
+        fingerprint = hashBytes(path.c_str(), path.size() + 1, fingerprint);
+
+#ifndef _WIN32
+        struct stat info;
+
+        if (stat(path.c_str(), &info) == 0)
+        {
+            const int64_t stamp[] = {(int64_t)info.st_size, (int64_t)info.st_dev, (int64_t)info.st_ino,
+                                     (int64_t)info.st_mtim.tv_sec, (int64_t)info.st_mtim.tv_nsec};
+            fingerprint = hashBytes(reinterpret_cast<const char *>(stamp), sizeof(stamp), fingerprint);
+        }
+#endif
+    }
+
+    return fingerprint;
+}
+
+/*
+    Attach to a published segment and read its Areas into `areas`. The areas
+    are deserialized from the mapping with readArea() into `areas`, and the
+    mapping is released before returning, so nothing is read in place.
+
+    If the segment has a different fingerprint or format version it is stale,
+    so it is unlinked (processes already attached keep their mapping) and
+    false is returned for the caller to import and publish the data again.
+    A segment that is still being written is left alone, unless the process
+    writing it has gone away.
+
+    @param areas
+        The Areas instance to read into
+
+    @param name
+        The segment name from sharedSegmentName()
+
+    @param fingerprint
+        The fingerprint of the data files from fingerprintFiles()
+
+    @return
+        true if the Areas were read from the segment, false if the data needs
+        to be imported
+*/
+bool BethYw::attachSharedAreas(Areas &areas, const std::string &name, const uint64_t fingerprint)
+{
+#ifdef _WIN32
+    return false;
+#else
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    if ((size_t)info.st_size < sizeof(SharedHeader))
+    {
+        // The writer has not sized the segment yet, or died before it did
+        if (isAbandoned(info, nullptr, SHARED_ORPHAN_SECONDS))
+        {
+            shm_unlink(name.c_str());
+        }
+
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    const SharedHeader *header = static_cast<const SharedHeader *>(mapping);
+    bool attached = false;
+
+    if (header->ready.load(std::memory_order_acquire) == 0)
+    {
+        // Still being written (the header is zeroed until the writer fills it)
+        if (isAbandoned(info, header, SHARED_ORPHAN_SECONDS))
+        {
+            shm_unlink(name.c_str());
+        }
+    }
+    else if (std::memcmp(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC)) != 0
+             || header->version != SHARED_FORMAT_VERSION
+             || header->fingerprint != fingerprint)
+    {
+        shm_unlink(name.c_str());
+    }
+    else if (sizeof(SharedHeader) + header->size <= (size_t)info.st_size)
+    {
+        MemoryBuffer buffer(static_cast<const char *>(mapping) + sizeof(SharedHeader), header->size);
+        std::istream is(&buffer);
+
+        try
+        {
+            while (auto area = readArea(is))
+            {
+                areas.setArea(area->getLocalAuthorityCode(), *area);
+            }
+
+            attached = true;
+        }
+        catch(const std::runtime_error& e)
+        {
+            // A malformed segment is treated as stale
+            areas = Areas();
+            shm_unlink(name.c_str());
+        }
+    }
+
+    munmap(mapping, info.st_size);
+    return attached;
+#endif
+}
+
+/*
+    Unlink a segment that is not ready and never will be, because the process
+    writing it died (see attachSharedAreas()), so the data can be published
+    again. A segment that is ready, or is still being written, is left alone.
+
+    @param name
+        The segment name from sharedSegmentName()
+
+    @param orphanSeconds
+        How long a segment without a writer is given to get one before it is
+        treated as abandoned
+
+    @return
+        true if the segment was abandoned and has been unlinked
+*/
+bool BethYw::removeAbandonedSegment(const std::string &name, const unsigned int orphanSeconds)
+{
+#ifdef _WIN32
+    return false;
+#else
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    bool abandoned = false;
+
+    if (fstat(fd, &info) == 0)
+    {
+        if ((size_t)info.st_size < sizeof(SharedHeader))
+        {
+            abandoned = isAbandoned(info, nullptr, orphanSeconds);
+        }
+        else
+        {
+            void *mapping = mmap(nullptr, sizeof(SharedHeader), PROT_READ, MAP_SHARED, fd, 0);
+
+            if (mapping != MAP_FAILED)
+            {
+                const SharedHeader *header = static_cast<const SharedHeader *>(mapping);
+                abandoned = header->ready.load(std::memory_order_acquire) == 0
+                            && isAbandoned(info, header, orphanSeconds);
+                munmap(mapping, sizeof(SharedHeader));
+            }
+        }
+    }
+
+    close(fd);
+
+    return abandoned && shm_unlink(name.c_str()) == 0;
+#endif
+}
+
+/*
+    Publish `areas` to a new segment for later invocations to attach to. If a
+    segment with the name already exists (e.g. another invocation is
+    publishing the same data), nothing is published, unless it was abandoned
+    by a writer that died (see removeAbandonedSegment()), in which case it is
+    replaced.
+
+    @param areas
+        The Areas instance to publish
+
+    @param name
+        The segment name from sharedSegmentName()
+
+    @param fingerprint
+        The fingerprint of the data files from fingerprintFiles()
+
+    @return
+        true if the segment was published, false if not
+*/
+bool BethYw::publishSharedAreas(const Areas &areas, const std::string &name, const uint64_t fingerprint)
+{
+#ifdef _WIN32
+    return false;
+#else
+    std::ostringstream payload;
+    areas.forEachArea([&payload](const Area &area) {
+        writeArea(payload, area);
+    });
+    const std::string data = payload.str();
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    if (fd < 0 && errno == EEXIST && removeAbandonedSegment(name))
+    {
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    const size_t size = sizeof(SharedHeader) + data.size();
+
+    if (ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    SharedHeader *header = new (mapping) SharedHeader();
+    header->writer = getpid();
+    std::memcpy(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC));
+    header->version = SHARED_FORMAT_VERSION;
+    header->fingerprint = fingerprint;
+    header->size = data.size();
+    std::memcpy(static_cast<char *>(mapping) + sizeof(SharedHeader), data.data(), data.size());
+    header->ready.store(1, std::memory_order_release);
+
+    munmap(mapping, size);
+    return true;
+#endif
+}
@@ -0,0 +1,51 @@
+#ifndef SHM_H_
+#define SHM_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for sharing imported data between
+    invocations of Beth Yw? on the same machine. The first invocation
+    publishes its Areas into a named POSIX shared memory segment, and later
+    invocations with the same arguments attach to it read-only instead of
+    parsing the data files again.
+
+    The segment holds the Areas in the binary format of the spill files (see
+    writeArea() in store.h), not as live objects, so attaching still
+    deserializes every area into a fresh Areas in the attaching process. What
+    is saved is the parsing of CSV and JSON and the filtering, not the copy:
+    each invocation holds its own Areas in memory for as long as it runs.
+
+    Segments are stamped with a fingerprint of the data files they were
+    imported from (their paths, sizes and modification times), and a segment
+    with a different fingerprint or format version is unlinked and replaced,
+    as is a segment left unfinished by a publisher that died.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+
+namespace BethYw
+{
+    const uint32_t SHARED_FORMAT_VERSION = 1;
+
+    // How long a segment is given to get a writer before it is treated as
+    // abandoned by a publisher that died as it was created
+    const unsigned int SHARED_ORPHAN_SECONDS = 10;
+
+    std::string sharedSegmentName(const std::string &key);
+    uint64_t fingerprintFiles(const std::vector<std::string> &paths);
+    bool attachSharedAreas(Areas &areas, const std::string &name, const uint64_t fingerprint);
+    bool removeAbandonedSegment(const std::string &name,
+                                const unsigned int orphanSeconds = SHARED_ORPHAN_SECONDS);
+    bool publishSharedAreas(const Areas &areas, const std::string &name, const uint64_t fingerprint);
+}
+
+#endif // SHM_H_
@@ -0,0 +1,510 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the feature matrix and nearest
+    area search.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "lib_json.hpp"
+
+#include "similar.h"
+#include "bethyw.h"
+#include "numeric.h"
+
+using json = nlohmann::json;
+
+namespace
+{
+    /*
+        Find the English names of some areas, or their Welsh names if they
+        have no English name.
+    */
+    std::map<std::string, std::string> namesOf(const Areas &areas, const std::vector<std::string> &codes)
+    {
+        std::map<std::string, std::string> names;
+
+        for (auto &code : codes)
+        {
+            names[code] = "";
+        }
+
+        areas.forEachArea([&names](const Area &area) {
+            auto it = names.find(area.getLocalAuthorityCode());
+
+            if (it != names.end())
+            {
+                const std::string *name = area.findName("eng");
+
+                if (name == nullptr)
+                {
+                    name = area.findName("cym");
+                }
+
+                it->second = name != nullptr ? *name : "";
+            }
+        });
+
+        return names;
+    }
+}
+
+/*
+    Construct an empty FeatureMatrix.
+
+    @param year
+        The year of the features, or 0 for the latest year of each measure
+*/
+BethYw::FeatureMatrix::FeatureMatrix(const unsigned int year)
+    : year(year)
+{
+}
+
+/*
+    Add the value of a measure of an area in a year. Only a value that can be
+    a feature is kept: one in the year of the matrix, or, for the latest year
+    of each measure, the latest value of each area's measure (since the
+    latest year of a measure is the latest year of any area that has it).
+
+    @param localAuthorityCode
+        The local authority code of the area
+
+    @param codename
+        The codename of the measure
+
+    @param year
+        The year
+
+    @param value
+        The value
+
+    @return
+        void
+*/
+void BethYw::FeatureMatrix::add(const std::string &localAuthorityCode, const std::string &codename,
+                                const unsigned int valueYear, const double value)
+{
+    auto area = codeIndex.find(localAuthorityCode);
+    if (area == codeIndex.end())
+    {
+        area = codeIndex.emplace(localAuthorityCode, codes.size()).first;
+        codes.push_back(localAuthorityCode);
+    }
+
+    auto measure = codenameIndex.find(codename);
+    if (measure == codenameIndex.end())
+    {
+        measure = codenameIndex.emplace(codename, codenames.size()).first;
+        codenames.push_back(codename);
+    }
+
+    const Value entry = {area->second, measure->second, valueYear, value};
+
+    if (year != 0)
+    {
+        if (valueYear == year)
+        {
+            pending.push_back(entry);
+        }
+
+        return;
+    }
+
+    const uint64_t key = (uint64_t)area->second << 32 | measure->second;
+    auto found = latest.find(key);
+
+    if (found == latest.end())
+    {
+        latest.emplace(key, pending.size());
+        pending.push_back(entry);
+    }
+    else if (valueYear >= pending[found->second].year)
+    {
+        pending[found->second] = entry;
+    }
+}
+
+/*
+    Build the matrix from the values added. Each measure uses the year of the
+    matrix, or if that is 0 the latest year of the measure in any area. The
+    values added are released once the matrix is built.
+
+    @return
+        void
+*/
+void BethYw::FeatureMatrix::build()
+{
+    const size_t width = codenames.size();
+    years.assign(width, year);
+
+    if (year == 0)
+    {
+        for (auto &value : pending)
+        {
+            years[value.measure] = std::max(years[value.measure], value.year);
+        }
+    }
+
+    features.assign(codes.size() * width, NAN);
+
+    for (auto &value : pending)
+    {
+        if (value.year == years[value.measure])
+        {
+            features[value.measure * codes.size() + value.area] = value.value;
+        }
+    }
+
+    std::vector<Value>().swap(pending);
+    std::unordered_map<uint64_t, size_t>().swap(latest);
+
+    // Replace each value with its z-score, and each missing value with 0. The
+    // mean and variance are found in two passes over the values of the
+    // column, so the variance of large, close values is not lost to rounding
+    std::vector<double> column;
+
+    for (size_t measure = 0; measure < width; measure++)
+    {
+        double *values = features.data() + measure * codes.size();
+        column.clear();
+
+        for (size_t area = 0; area < codes.size(); area++)
+        {
+            const double value = values[area];
+
+            if (!std::isnan(value))
+            {
+                column.push_back(value);
+            }
+        }
+
+        const double mean = BethYw::mean(column.data(), column.size());
+
+        for (auto &value : column)
+        {
+            value = (value - mean) * (value - mean);
+        }
+
+        const double variance = BethYw::mean(column.data(), column.size());
+        const double deviation = std::sqrt(variance);
+
+        for (size_t area = 0; area < codes.size(); area++)
+        {
+            double &value = values[area];
+            value = std::isnan(value) || deviation == 0 ? 0 : (value - mean) / deviation;
+        }
+    }
+}
+
+/*
+    Retrieve the number of areas in the matrix.
+
+    @return
+        The number of rows
+*/
+const size_t BethYw::FeatureMatrix::rows() const noexcept
+{
+    return codes.size();
+}
+
+/*
+    Retrieve the number of measures in the matrix.
+
+    @return
+        The number of features in each row
+*/
+const size_t BethYw::FeatureMatrix::width() const noexcept
+{
+    return codenames.size();
+}
+
+/*
+    Retrieve the local authority code of each row.
+
+    @return
+        The codes, in row order
+*/
+const std::vector<std::string> &BethYw::FeatureMatrix::getCodes() const noexcept
+{
+    return codes;
+}
+
+/*
+    Retrieve the codename of each feature.
+
+    @return
+        The codenames, in column order
+*/
+const std::vector<std::string> &BethYw::FeatureMatrix::getCodenames() const noexcept
+{
+    return codenames;
+}
+
+/*
+    Retrieve the year chosen for each feature by build().
+
+    @return
+        The years, in column order
+*/
+const std::vector<unsigned int> &BethYw::FeatureMatrix::getYears() const noexcept
+{
+    return years;
+}
+
+/*
+    Retrieve the values of a feature for every area.
+
+    @param index
+        The column of the feature
+
+    @return
+        A pointer to rows() features, in row order
+*/
+const double *BethYw::FeatureMatrix::column(const size_t index) const noexcept
+{
+    return features.data() + index * rows();
+}
+
+/*
+    Find the local authority code of an area in the matrix, in any case, as
+    the areas argument matches codes.
+
+    @param localAuthorityCode
+        The local authority code of the area, in any case
+
+    @return
+        The code as it is in the matrix
+
+    @throws
+        std::out_of_range if the area is not in the matrix
+*/
+const std::string &BethYw::FeatureMatrix::resolve(const std::string &localAuthorityCode) const
+{
+    auto it = codeIndex.find(localAuthorityCode);
+
+    if (it != codeIndex.end())
+    {
+        return codes[it->second];
+    }
+
+    const std::string folded = foldCase(localAuthorityCode);
+
+    for (auto &code : codes)
+    {
+        if (foldCase(code) == folded)
+        {
+            return code;
+        }
+    }
+
+    throw std::out_of_range("No area found matching " + localAuthorityCode);
+}
+
+/*
+    Find the areas nearest to an area, not including the area itself.
+
+    @param localAuthorityCode
+        The local authority code of the area, in any case
+
+    @param k
+        The largest number of areas to return
+
+    @return
+        The nearest areas, nearest first, with ties in row order
+
+    @throws
+        std::out_of_range if the area is not in the matrix
+*/
+std::vector<BethYw::Neighbour> BethYw::FeatureMatrix::nearest(const std::string &localAuthorityCode,
+                                                             const size_t k) const
+{
+    const size_t target = codeIndex.find(resolve(localAuthorityCode))->second;
+    const size_t length = width();
+
+    // The squared distance to every area, adding one feature at a time over
+    // all the areas. The areas of a column are contiguous and each is added
+    // to independently, so the inner loop has no dependency between its
+    // iterations and can be vectorised by an optimising build
+    std::vector<double> distances(codes.size(), 0);
+
+    for (size_t i = 0; i < length; i++)
+    {
+        const double *values = column(i);
+        const double targetValue = values[target];
+
+        for (size_t area = 0; area < codes.size(); area++)
+        {
+            const double difference = values[area] - targetValue;
+            distances[area] += difference * difference;
+        }
+    }
+
+    // Keep the nearest k in a heap with the furthest of them on top
+    std::priority_queue<std::pair<double, size_t>> heap;
+
+    for (size_t area = 0; area < codes.size() && k > 0; area++)
+    {
+        if (area == target)
+        {
+            continue;
+        }
+
+        const std::pair<double, size_t> entry(distances[area], area);
+
+        if (heap.size() < k)
+        {
+            heap.push(entry);
+        }
+        else if (entry < heap.top())
+        {
+            heap.pop();
+            heap.push(entry);
+        }
+    }
+
+    std::vector<Neighbour> neighbours(heap.size());
+
+    for (size_t i = neighbours.size(); i > 0; i--)
+    {
+        neighbours[i - 1] = {codes[heap.top().second], std::sqrt(heap.top().first)};
+        heap.pop();
+    }
+
+    return neighbours;
+}
+
+/*
+    Build the feature matrix of a set of Areas, with a feature for each
+    measure imported.
+
+    @param areas
+        The Areas
+
+    @param year
+        The year of the features, or 0 for the latest year of each measure
+
+    @return
+        The built matrix
+*/
+BethYw::FeatureMatrix BethYw::buildFeatureMatrix(const Areas &areas, const unsigned int year)
+{
+    FeatureMatrix matrix(year);
+
+    areas.forEachArea([&matrix](const Area &area) {
+        const std::string code = area.getLocalAuthorityCode();
+
+        for (auto &measure : area.getMeasures())
+        {
+            for (auto &value : measure.second.getValues())
+            {
+                matrix.add(code, measure.first, value.first, value.second);
+            }
+        }
+    });
+
+    matrix.build();
+    return matrix;
+}
+
+/*
+    Write the areas nearest to an area as a numbered list, e.g.
+
+        Nearest to Cardiff (W06000015)
+        1. Newport (W06000022) 0.734512
+
+    @param os
+        The output stream to write to
+
+    @param areas
+        The Areas, for the names of the areas
+
+    @param localAuthorityCode
+        The local authority code of the target area
+
+    @param neighbours
+        The nearest areas from FeatureMatrix::nearest()
+
+    @return
+        void
+*/
+void BethYw::writeNeighbours(std::ostream &os, const Areas &areas, const std::string &localAuthorityCode,
+                             const std::vector<Neighbour> &neighbours)
+{
+    std::vector<std::string> codes = {localAuthorityCode};
+    for (auto &neighbour : neighbours)
+    {
+        codes.push_back(neighbour.localAuthorityCode);
+    }
+
+    auto names = namesOf(areas, codes);
+    auto describe = [&names](const std::string &code) {
+        return (names[code].empty() ? "Unnamed" : names[code]) + " (" + code + ")";
+    };
+
+    os << "Nearest to " << describe(localAuthorityCode) << std::endl;
+
+    if (neighbours.empty())
+    {
+        os << "<no data>" << std::endl;
+    }
+
+    for (size_t i = 0; i < neighbours.size(); i++)
+    {
+        os << (i + 1) << ". " << describe(neighbours[i].localAuthorityCode) << " "
+           << std::to_string(neighbours[i].distance) << std::endl;
+    }
+}
+
+/*
+    Write the areas nearest to an area as JSON, mapping the target's code to
+    a list of the nearest areas, nearest first, e.g.
+    {"W06000015":[{"code":"W06000022","name":"Newport","distance":0.73}]}.
+
+    @param os
+        The output stream to write to
+
+    @param areas
+        The Areas, for the names of the areas
+
+    @param localAuthorityCode
+        The local authority code of the target area
+
+    @param neighbours
+        The nearest areas from FeatureMatrix::nearest()
+
+    @return
+        void
+*/
+void BethYw::writeNeighboursJSON(std::ostream &os, const Areas &areas, const std::string &localAuthorityCode,
+                                 const std::vector<Neighbour> &neighbours)
+{
+    std::vector<std::string> codes;
+    for (auto &neighbour : neighbours)
+    {
+        codes.push_back(neighbour.localAuthorityCode);
+    }
+
+    auto names = namesOf(areas, codes);
+    json list = json::array();
+
+    for (auto &neighbour : neighbours)
+    {
+        list.push_back({{"code", neighbour.localAuthorityCode},
+                        {"name", names[neighbour.localAuthorityCode]},
+                        {"distance", neighbour.distance}});
+    }
+
+    json j;
+    j[localAuthorityCode] = list;
+    os << j.dump();
+}
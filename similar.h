@@ -0,0 +1,105 @@
+#ifndef SIMILAR_H_
+#define SIMILAR_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for finding the areas most like a given
+    area, e.g. "which authorities look most like Cardiff across density,
+    businesses, air quality and rail use?".
+
+    Each area is described by a row of features, one for each measure, in a
+    dense matrix stored column-major, so the values of one measure for every
+    area are contiguous. A feature is the area's value for the measure in
+    a chosen year, normalised to a z-score across all the areas (so each
+    measure counts equally whatever its units). An area with no value for a
+    measure gets the mean, i.e. 0.
+
+    The distance between two areas is the Euclidean distance between their
+    rows. Distances from the target to every area are summed one column at a
+    time, in a loop over all the areas that an optimising build can
+    vectorise (build.sh passes no -O flag, so by default it is not), and the
+    nearest K are kept in a bounded heap, so a query is linear in the number
+    of areas.
+*/
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "areas.h"
+
+namespace BethYw
+{
+    /*
+        The nearest areas printed by --similar if -k/--neighbours is not given.
+    */
+    constexpr size_t DEFAULT_NEIGHBOURS = 5;
+
+    /*
+        An area and its distance from the target.
+    */
+    struct Neighbour
+    {
+        std::string localAuthorityCode;
+        double distance;
+    };
+
+    /*
+        The normalised features of every area in a year, or in the latest
+        year of each measure. Values are added one at a time with add(),
+        which only keeps the values that can be features, and then build()
+        fills in the matrix.
+    */
+    class FeatureMatrix
+    {
+    private:
+        struct Value
+        {
+            uint32_t area;
+            uint32_t measure;
+            unsigned int year;
+            double value;
+        };
+
+        std::vector<std::string> codes;
+        std::vector<std::string> codenames;
+        std::unordered_map<std::string, uint32_t> codeIndex;
+        std::unordered_map<std::string, uint32_t> codenameIndex;
+        unsigned int year;
+        std::vector<Value> pending;
+        // The value in pending for each area and measure, keyed by
+        // (area << 32 | measure), when only the latest year is kept
+        std::unordered_map<uint64_t, size_t> latest;
+        std::vector<unsigned int> years;
+        std::vector<double> features;
+
+    public:
+        FeatureMatrix(const unsigned int year = 0);
+        void add(const std::string &localAuthorityCode, const std::string &codename,
+                 const unsigned int year, const double value);
+        void build();
+        const size_t rows() const noexcept;
+        const size_t width() const noexcept;
+        const std::vector<std::string> &getCodes() const noexcept;
+        const std::vector<std::string> &getCodenames() const noexcept;
+        const std::vector<unsigned int> &getYears() const noexcept;
+        const double *column(const size_t index) const noexcept;
+        const std::string &resolve(const std::string &localAuthorityCode) const;
+        std::vector<Neighbour> nearest(const std::string &localAuthorityCode, const size_t k) const;
+    };
+
+    FeatureMatrix buildFeatureMatrix(const Areas &areas, const unsigned int year = 0);
+    void writeNeighbours(std::ostream &os, const Areas &areas, const std::string &localAuthorityCode,
+                         const std::vector<Neighbour> &neighbours);
+    void writeNeighboursJSON(std::ostream &os, const Areas &areas, const std::string &localAuthorityCode,
+                             const std::vector<Neighbour> &neighbours);
+}
+
+#endif // SIMILAR_H_
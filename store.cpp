@@ -0,0 +1,403 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation for storing Area objects outside of
+    memory, and the RunSet class for managing the run files written in
+    external-memory mode.
+
+    Each Area is written as:
+
+        string   local authority code
+        u32      number of names, followed by (string lang, string name) pairs
+        u32      number of measures, followed by for each measure:
+                     string codename
+                     string label
+                     u32    number of values, followed by (u32 year, f64 value)
+
+    where a string is a u32 length followed by that many bytes.
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "store.h"
+#include "bethyw.h"
+
+namespace
+{
+    // The most memory readString() allocates before reading the bytes for it
+    constexpr size_t STRING_BLOCK_SIZE = 64 * 1024;
+}
+
+/*
+    Write an unsigned integer to a binary output stream, in the byte order
+    of this machine.
+
+    @param os
+        The output stream to write to
+
+    @param value
+        The value to write
+
+    @return
+        void
+*/
+void BethYw::writeU32(std::ostream &os, const uint32_t value)
+{
+    os.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/*
+    Write an unsigned 64-bit integer to a binary output stream, in the byte
+    order of this machine.
+
+    @param os
+        The output stream to write to
+
+    @param value
+        The value to write
+
+    @return
+        void
+*/
+void BethYw::writeU64(std::ostream &os, const uint64_t value)
+{
+    os.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+/*
+    Write a string to a binary output stream as its length and bytes.
+
+    @param os
+        The output stream to write to
+
+    @param string
+        The string to write
+
+    @return
+        void
+*/
+void BethYw::writeString(std::ostream &os, const std::string &string)
+{
+    writeU32(os, (uint32_t)string.size());
+    os.write(string.data(), string.size());
+}
+
+/*
+    Read an unsigned 32-bit integer written by writeU32().
+
+    @param is
+        The input stream to read from
+
+    @return
+        The value
+
+    @throws
+        std::runtime_error if the stream ends first
+*/
+uint32_t BethYw::readU32(std::istream &is)
+{
+    uint32_t value;
+
+    if (!is.read(reinterpret_cast<char *>(&value), sizeof(value)))
+    {
+        throw std::runtime_error("Malformed store!");
+    }
+
+    return value;
+}
+
+/*
+    Read an unsigned 64-bit integer written by writeU64().
+
+    @param is
+        The input stream to read from
+
+    @return
+        The value
+
+    @throws
+        std::runtime_error if the stream ends first
+*/
+uint64_t BethYw::readU64(std::istream &is)
+{
+    uint64_t value;
+
+    if (!is.read(reinterpret_cast<char *>(&value), sizeof(value)))
+    {
+        throw std::runtime_error("Malformed store!");
+    }
+
+    return value;
+}
+
+/*
+    Read a string written by writeString(). The string is read in blocks, so
+    the length read from a corrupt file can't allocate much more memory than
+    there are bytes left in the stream.
+
+    @param is
+        The input stream to read from
+
+    @return
+        The string
+
+    @throws
+        std::runtime_error if the stream ends first
+*/
+std::string BethYw::readString(std::istream &is)
+{
+    const uint32_t length = readU32(is);
+    std::string string;
+
+    while (string.size() < length)
+    {
+        const size_t at = string.size();
+        const size_t count = std::min<size_t>(length - at, STRING_BLOCK_SIZE);
+        string.resize(at + count);
+
+        if (!is.read(&string[at], count))
+        {
+            throw std::runtime_error("Malformed store!");
+        }
+    }
+
+    return string;
+}
+
+/*
+    Hash a block of bytes with 64-bit FNV-1a. This is not a cryptographic hash,
+    but is fast and good enough for spotting changed files and segments.
+
+    @param data
+        The bytes to hash
+
+    @param size
+        The number of bytes
+
+    @param seed
+        The hash to continue from, so blocks can be hashed in pieces
+
+    @return
+        The hash
+*/
+uint64_t BethYw::hashBytes(const char *data, const size_t size, const uint64_t seed) noexcept
+{
+    uint64_t hash = seed;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/*
+    Write an Area, including all its names, measures and values, to a binary
+    output stream.
+
+    @param os
+        The output stream to write to
+
+    @param area
+        The Area to write
+
+    @return
+        void
+*/
+void BethYw::writeArea(std::ostream &os, const Area &area)
+{
+    writeString(os, area.getLocalAuthorityCode());
+
+    const auto names = area.getNames();
+    writeU32(os, (uint32_t)names.size());
+    for (auto &name : names)
+    {
+        writeString(os, name.first);
+        writeString(os, name.second);
+    }
+
+    const auto measures = area.getMeasures();
+    writeU32(os, (uint32_t)measures.size());
+    for (auto &measure : measures)
+    {
+        writeString(os, measure.first);
+        writeString(os, measure.second.getLabel());
+
+        const auto values = measure.second.getValues();
+        writeU32(os, (uint32_t)values.size());
+        for (auto &value : values)
+        {
+            writeU32(os, value.first);
+            os.write(reinterpret_cast<const char *>(&value.second), sizeof(value.second));
+        }
+    }
+}
+
+/*
+    Read the next Area written by writeArea() from a binary input stream.
+
+    @param is
+        The input stream to read from
+
+    @return
+        The Area read, or nullptr if the stream has no more Areas
+
+    @throws
+        std::runtime_error if the stream ends part way through an Area
+*/
+std::unique_ptr<Area> BethYw::readArea(std::istream &is)
+{
+    if (is.peek() == std::char_traits<char>::eof())
+    {
+        return nullptr;
+    }
+
+    std::unique_ptr<Area> area(new Area(readString(is)));
+
+    for (uint32_t names = readU32(is); names > 0; names--)
+    {
+        std::string lang = readString(is);
+        area->setName(lang, readString(is));
+    }
+
+    for (uint32_t measures = readU32(is); measures > 0; measures--)
+    {
+        std::string codename = readString(is);
+        Measure measure(codename, readString(is));
+
+        for (uint32_t values = readU32(is); values > 0; values--)
+        {
+            unsigned int year = readU32(is);
+            double value;
+
+            if (!is.read(reinterpret_cast<char *>(&value), sizeof(value)))
+            {
+                throw std::runtime_error("Malformed store!");
+            }
+
+            measure.setValue(year, value);
+        }
+
+        area->setMeasure(codename, measure);
+    }
+
+    return area;
+}
+
+/*
+    Construct an empty RunSet which will write its run files to `dir`.
+
+    @param dir
+        The directory for the run files, including a trailing separator
+*/
+BethYw::RunSet::RunSet(const std::string &dir)
+    : dir(dir)
+{
+}
+
+/*
+    Destructor for a RunSet, which deletes all its run files.
+*/
+BethYw::RunSet::~RunSet()
+{
+    for (auto &path : paths)
+    {
+        std::remove(path.c_str());
+    }
+}
+
+/*
+    Get a unique path for the next run file.
+
+    @return
+        The path to write the next run to
+*/
+const std::string BethYw::RunSet::nextPath() const
+{
+    return dir + "bethyw-" + std::to_string(getpid()) + "-"
+           + std::to_string((size_t)this) + "-"
+           + std::to_string(written) + ".run";
+}
+
+/*
+    Add a run file that has been written to the set. Runs are merged in the
+    order they were added, with later runs taking precedence.
+
+    @param path
+        The path of the run file
+
+    @return
+        void
+*/
+void BethYw::RunSet::add(const std::string &path)
+{
+    paths.push_back(path);
+    written++;
+}
+
+/*
+    Replace consecutive run files with one that has been written with their
+    merged contents, deleting them. The new run keeps their place in the
+    order of precedence.
+
+    @param first
+        The index of the first run to replace
+
+    @param count
+        The number of runs to replace
+
+    @param path
+        The path of the merged run file
+
+    @return
+        void
+*/
+void BethYw::RunSet::replace(const size_t first, const size_t count, const std::string &path)
+{
+    for (size_t i = first; i < first + count; i++)
+    {
+        std::remove(paths[i].c_str());
+    }
+
+    paths.erase(paths.begin() + first + 1, paths.begin() + first + count);
+    paths[first] = path;
+    written++;
+}
+
+/*
+    Retrieve the paths of all the run files, in the order they were written.
+
+    @return
+        The run file paths
+*/
+const std::vector<std::string>& BethYw::RunSet::getPaths() const noexcept
+{
+    return paths;
+}
+
+/*
+    Retrieve the number of run files.
+
+    @return
+        The number of runs
+*/
+const size_t BethYw::RunSet::size() const noexcept
+{
+    return paths.size();
+}
@@ -0,0 +1,81 @@
+#ifndef STORE_H_
+#define STORE_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for storing Area objects outside of
+    memory. Areas are written in a compact binary format which only uses
+    lengths and counts (no pointers), so the same bytes can be read back from
+    a file or from any other buffer.
+
+    RunSet is a set of sorted run files written by an Areas object in
+    external-memory mode, which are merged back together when it is output.
+ */
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "area.h"
+
+namespace BethYw
+{
+    uint64_t hashBytes(const char *data, const size_t size, const uint64_t seed = 14695981039346656037ULL) noexcept;
+    void writeU32(std::ostream &os, const uint32_t value);
+    void writeU64(std::ostream &os, const uint64_t value);
+    void writeString(std::ostream &os, const std::string &string);
+    uint32_t readU32(std::istream &is);
+    uint64_t readU64(std::istream &is);
+    std::string readString(std::istream &is);
+    void writeArea(std::ostream &os, const Area &area);
+    std::unique_ptr<Area> readArea(std::istream &is);
+
+    /*
+        A read-only stream buffer over a block of memory, so it can be read
+        as a stream (e.g. Areas straight out of a mapped segment) without
+        copying it.
+    */
+    class MemoryBuffer : public std::streambuf
+    {
+    public:
+        MemoryBuffer(const char *data, size_t size)
+        {
+            char *begin = const_cast<char *>(data);
+            setg(begin, begin, begin + size);
+        }
+    };
+
+    /*
+        A set of run files, each holding Area objects written in order of local
+        authority code. The files are deleted when the RunSet is destroyed.
+    */
+    class RunSet
+    {
+    private:
+        std::string dir;
+        std::vector<std::string> paths;
+        size_t written = 0;
+
+    public:
+        RunSet(const std::string &dir);
+        ~RunSet();
+        RunSet(const RunSet &) = delete;
+        RunSet& operator=(const RunSet &) = delete;
+        const std::string nextPath() const;
+        void add(const std::string &path);
+        void replace(const size_t first, const size_t count, const std::string &path);
+        const std::vector<std::string>& getPaths() const noexcept;
+        const size_t size() const noexcept;
+    };
+}
+
+#endif // STORE_H_
@@ -0,0 +1,488 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the TailCache class for
+    importing only the rows appended to data files (see tail.h).
+
+    A cache file is written as:
+
+        u32      format version
+        string   key of the import (see sharedSegmentKey())
+        u32      number of files, followed by for each file:
+                     string  path
+                     u32     parser (SourceDataType)
+                     u64     offset
+                     u64     checksum of the bytes before offset
+                     string  CSV header
+                     u32     number of Areas, followed by the Areas
+                             (see writeArea())
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "tail.h"
+#include "store.h"
+
+namespace
+{
+    // The size of the blocks the prefix of a file is checksummed in
+    constexpr size_t CHECKSUM_BLOCK_SIZE = 1024 * 1024;
+
+    // How many times longer than the last checkpoint took to save an import
+    // runs before the next one (see enableCheckpoints())
+    constexpr int CHECKPOINT_COST_RATIO = 20;
+}
+
+/*
+    Construct an empty TailCache.
+
+    @param path
+        The cache file to load from and save to, or an empty string to only
+        keep the cache in memory
+
+    @param key
+        The key of the import (see sharedSegmentKey()), so a cache saved by
+        an import with different datasets or filters is not reused
+*/
+BethYw::TailCache::TailCache(const std::string &path, const std::string &key)
+    : path(path), key(key)
+{
+}
+
+/*
+    Check whether a data file is made of independent lines, so rows appended
+    to it can be parsed without the rows before them.
+
+    @param parser
+        The type of the data file
+
+    @return
+        true for JSON Lines and CSV files, false for JSON documents
+*/
+const bool BethYw::TailCache::isLineBased(const SourceDataType &parser) noexcept
+{
+    return parser == WelshStatsJSONL || parser == AuthorityByYearCSV || parser == AuthorityCodeCSV;
+}
+
+/*
+    Load the cache file, if there is one. A missing, malformed or outdated
+    cache file, or one saved for a different key, leaves the cache empty, so
+    every file is parsed in full.
+
+    @return
+        void
+*/
+void BethYw::TailCache::load() noexcept
+{
+    clear();
+
+    if (path.empty())
+    {
+        return;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    try
+    {
+        if (readU32(file) != TAIL_CACHE_FORMAT_VERSION || readString(file) != key)
+        {
+            return;
+        }
+
+        for (uint32_t files = readU32(file); files > 0; files--)
+        {
+            Entry &entry = entries[readString(file)];
+            entry.parser = (SourceDataType)readU32(file);
+            entry.offset = readU64(file);
+            entry.checksum = readU64(file);
+            entry.header = readString(file);
+
+            for (uint32_t areas = readU32(file); areas > 0; areas--)
+            {
+                std::unique_ptr<Area> area = readArea(file);
+
+                if (!area)
+                {
+                    throw std::runtime_error("Malformed store!");
+                }
+
+                entry.data.setArea(area->getLocalAuthorityCode(), *area);
+            }
+        }
+    }
+    catch(const std::exception &e)
+    {
+        clear();
+    }
+}
+
+/*
+    Save the cache to its cache file, replacing the file only once the new one
+    has been written in full. Nothing is saved for a cache kept in memory.
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if the cache file cannot be written
+*/
+void BethYw::TailCache::save() const
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    const std::string temp = path + ".tmp";
+    std::ofstream file(temp, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("TailCache::save: Failed to open file " + temp);
+    }
+
+    writeU32(file, TAIL_CACHE_FORMAT_VERSION);
+    writeString(file, key);
+    writeU32(file, (uint32_t)entries.size());
+
+    for (auto &it : entries)
+    {
+        const Entry &entry = it.second;
+
+        writeString(file, it.first);
+        writeU32(file, (uint32_t)entry.parser);
+        writeU64(file, entry.offset);
+        writeU64(file, entry.checksum);
+        writeString(file, entry.header);
+        writeU32(file, (uint32_t)entry.data.size());
+
+        entry.data.forEachArea([&file](const Area &area) {
+            writeArea(file, area);
+        });
+    }
+
+    file.close();
+
+    if (file.fail() || std::rename(temp.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temp.c_str());
+        throw std::runtime_error("TailCache::save: Failed to write file " + path);
+    }
+}
+
+/*
+    Forget every file, so they are all parsed in full on their next import.
+
+    @return
+        void
+*/
+void BethYw::TailCache::clear() noexcept
+{
+    entries.clear();
+}
+
+/*
+    Import a data file into areas, only parsing the rows appended since it
+    was last imported through this cache if the rest of the file is
+    unchanged.
+
+    @param areas
+        An Areas instance that should be modified (i.e. the file's data merged
+        into it)
+
+    @param file
+        The complete path of the file
+
+    @param dataset
+        The dataset the file belongs to
+
+    @param areasFilter
+        An unordered set of areas to filter, or empty to import all areas
+
+    @param measuresFilter
+        An unordered set of measures to filter, or empty to import all measures
+
+    @param yearsFilter
+        The years to import, which matches every year if it is empty (see
+        years.h)
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if the file cannot be opened or parsed, in which
+        case the cache keeps the chunks of lines before the error
+        std::out_of_range if there are not enough columns in the dataset
+        std::runtime_error if a checkpoint cannot be written
+*/
+void BethYw::TailCache::import(Areas &areas,
+                               const std::string &file,
+                               const InputFileSource &dataset,
+                               const StringFilterSet &areasFilter,
+                               const StringFilterSet &measuresFilter,
+                               const YearFilter &yearsFilter)
+{
+    std::ifstream is(file, std::ios::binary | std::ios::ate);
+
+    if (!is.is_open())
+    {
+        throw std::runtime_error("TailCache::import: Failed to open file " + file);
+    }
+
+    const uint64_t size = (uint64_t)(std::streamoff)is.tellg();
+    const bool lineBased = isLineBased(dataset.PARSER);
+    is.seekg(0);
+
+    auto found = entries.find(file);
+    bool reuse = found != entries.end()
+                 && found->second.parser == dataset.PARSER
+                 && found->second.offset > 0
+                 && found->second.offset <= size
+                 && (lineBased || found->second.offset == size);
+
+    // Checksum the prefix, which is read but not parsed
+    if (reuse)
+    {
+        std::string block(CHECKSUM_BLOCK_SIZE, '\0');
+        uint64_t checksum = hashBytes(nullptr, 0);
+
+        for (uint64_t remaining = found->second.offset; remaining > 0; )
+        {
+            const size_t count = (size_t)std::min<uint64_t>(remaining, block.size());
+
+            if (!is.read(&block[0], count))
+            {
+                throw std::runtime_error("TailCache::import: Failed to read file " + file);
+            }
+
+            checksum = hashBytes(block.data(), count, checksum);
+            remaining -= count;
+        }
+
+        reuse = checksum == found->second.checksum;
+
+        if (!reuse)
+        {
+            is.seekg(0);
+        }
+    }
+
+    Entry &entry = entries[file];
+
+    if (!reuse)
+    {
+        entry = Entry();
+        entry.parser = dataset.PARSER;
+        entry.checksum = hashBytes(nullptr, 0);
+    }
+
+    auto parse = [&](const char *data, const size_t length) {
+        MemoryBuffer buffer(data, length);
+        std::istream stream(&buffer);
+        Areas part = areas.emptyCopy();
+        part.populate(stream, dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, yearsFilter);
+        entry.data.merge(part);
+    };
+
+    if (!lineBased)
+    {
+        // A JSON document can only be parsed whole
+        if (!reuse)
+        {
+            std::string text((size_t)size, '\0');
+
+            if (!text.empty() && !is.read(&text[0], text.size()))
+            {
+                throw std::runtime_error("TailCache::import: Failed to read file " + file);
+            }
+
+            parse(text.data(), text.size());
+            bytesParsed += size;
+            entry.offset = size;
+            entry.checksum = hashBytes(text.data(), text.size(), entry.checksum);
+        }
+    }
+    else
+    {
+        // Parse the tail a chunk of complete lines at a time, so the offset
+        // is always at the start of a line when the cache is checkpointed
+        std::string pending;
+        std::string text;
+        uint64_t read = entry.offset;
+
+        while (read < size || !pending.empty())
+        {
+            const size_t count = (size_t)std::min<uint64_t>(size - read, chunkSize);
+            const size_t kept = pending.size();
+            pending.resize(kept + count);
+
+            if (count > 0 && !is.read(&pending[kept], count))
+            {
+                throw std::runtime_error("TailCache::import: Failed to read file " + file);
+            }
+
+            read += count;
+
+            const bool last = read == size;
+            const size_t newline = pending.rfind('\n');
+            const size_t complete = newline == std::string::npos ? 0 : newline + 1;
+
+            // A line longer than a chunk is read on into the next one
+            if (complete == 0 && !last)
+            {
+                continue;
+            }
+
+            // A line that is not complete at the end of the file is parsed,
+            // but the offset stays before it, so it is parsed again with the
+            // rest of the tail next time
+            const size_t parsed = last ? pending.size() : complete;
+
+            if (entry.offset == 0 && dataset.PARSER != WelshStatsJSONL)
+            {
+                const size_t headerEnd = pending.find('\n');
+                entry.header = headerEnd == std::string::npos ? "" : pending.substr(0, headerEnd + 1);
+            }
+
+            if (entry.offset == 0 || dataset.PARSER == WelshStatsJSONL)
+            {
+                parse(pending.data(), parsed);
+            }
+            else
+            {
+                // Rows after the first chunk are parsed under the CSV header
+                text.assign(entry.header).append(pending, 0, parsed);
+                parse(text.data(), text.size());
+            }
+
+            bytesParsed += parsed;
+
+            entry.checksum = hashBytes(pending.data(), complete, entry.checksum);
+            entry.offset += complete;
+            pending.erase(0, last ? pending.size() : complete);
+
+            maybeCheckpoint();
+        }
+    }
+
+    maybeCheckpoint();
+    areas.merge(entry.data);
+}
+
+/*
+    Enable checkpoints, where the cache is saved while files are imported,
+    after each chunk of lines, so an import that is stopped part of the way
+    through a file can be resumed from the last checkpoint by loading the
+    cache (--checkpoint and --resume).
+
+    Saving takes longer the more has been imported, so a checkpoint is only
+    written once the import has run for CHECKPOINT_COST_RATIO times as long
+    as the last checkpoint took to save, keeping the time spent on
+    checkpoints under 5% of the import.
+
+    @param chunkSize
+        The number of bytes of each file read and parsed at a time
+
+    @return
+        void
+*/
+void BethYw::TailCache::enableCheckpoints(const size_t chunkSize) noexcept
+{
+    checkpoints = true;
+    this->chunkSize = chunkSize;
+    lastCheckpoint = std::chrono::steady_clock::now();
+    lastCheckpointCost = std::chrono::steady_clock::duration::zero();
+}
+
+/*
+    Save the cache if checkpoints are enabled and enough time has passed since
+    the last checkpoint (see enableCheckpoints()).
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if the cache file cannot be written
+*/
+void BethYw::TailCache::maybeCheckpoint()
+{
+    if (!checkpoints)
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    if (now - lastCheckpoint < lastCheckpointCost * CHECKPOINT_COST_RATIO)
+    {
+        return;
+    }
+
+    save();
+    checkpointCount++;
+
+    lastCheckpoint = std::chrono::steady_clock::now();
+    lastCheckpointCost = lastCheckpoint - now;
+}
+
+/*
+    Delete the cache file, e.g. once an import with checkpoints has finished
+    and there is nothing left to resume.
+
+    @return
+        void
+*/
+void BethYw::TailCache::discard() const noexcept
+{
+    if (!path.empty())
+    {
+        std::remove(path.c_str());
+    }
+}
+
+/*
+    Retrieve the number of bytes of data files parsed by import() since the
+    cache was constructed, e.g. to check that only tails were parsed.
+
+    @return
+        The number of bytes
+*/
+const uint64_t BethYw::TailCache::getBytesParsed() const noexcept
+{
+    return bytesParsed;
+}
+
+/*
+    Retrieve the number of files in the cache.
+
+    @return
+        The number of files
+*/
+const size_t BethYw::TailCache::size() const noexcept
+{
+    return entries.size();
+}
+
+/*
+    Retrieve the number of checkpoints saved since the cache was constructed.
+
+    @return
+        The number of checkpoints
+*/
+const size_t BethYw::TailCache::getCheckpointCount() const noexcept
+{
+    return checkpointCount;
+}
@@ -0,0 +1,120 @@
+#ifndef TAIL_H_
+#define TAIL_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for importing data files that grow by
+    having rows appended to the end, e.g. a feed that adds each new year to
+    a JSON Lines or CSV file, without parsing the whole file every time.
+
+    A TailCache remembers, for each file it has imported:
+
+        the byte offset just after the last complete line imported
+        a checksum of the bytes before that offset (the prefix)
+        the CSV header, so rows after the offset can be parsed on their own
+        the data imported from the file, as its own Areas object
+
+    When the file is imported again, the prefix is checksummed and, if it is
+    unchanged, only the bytes after the offset (the tail) are parsed and
+    merged into that file's data. If the prefix changed (or the file shrank)
+    the file is parsed again from the start. WelshStatsJSON files are one
+    document, so they are only reused when the whole file is unchanged.
+
+    The data of each file is kept separately and merged into the Areas being
+    imported in the order of the files, so rows appended to an earlier
+    dataset do not take precedence over a later dataset. A line that is not
+    yet complete at the end of a file is imported, and parsed again with the
+    tail on the next import, so a row that was being written is replaced by
+    the complete row.
+
+    A TailCache can be saved to a cache file for the next run of the program
+    (--tail-cache), or kept in a long-running process and imported again
+    when it is told the files have grown (see bethyw_refresh() in
+    libbethyw.h). Checking the prefix still reads it, but parsing, which is
+    most of the cost of importing, only scales with the new rows.
+
+    Files are parsed a chunk of complete lines at a time, so the offset is
+    always at a row boundary, where the only state of the parser is the CSV
+    header. With checkpoints enabled (--checkpoint), the cache is saved
+    between chunks as a large import goes on, and an import that is killed
+    part of the way through is resumed from the last checkpoint by loading
+    the cache (--resume), which is the same as importing files that have
+    grown since. A WelshStatsJSON file is one document that is parsed whole,
+    so it can only be checkpointed once it has been imported; large files
+    should be converted to JSON Lines to be resumable.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "datasets.h"
+#include "areas.h"
+
+namespace BethYw
+{
+    const uint32_t TAIL_CACHE_FORMAT_VERSION = 1;
+
+    class TailCache
+    {
+    private:
+        /*
+            What has been imported from one file.
+        */
+        struct Entry
+        {
+            SourceDataType parser;
+            uint64_t offset = 0;
+            uint64_t checksum = 0;
+            std::string header;
+            Areas data;
+        };
+
+        std::string path;
+        std::string key;
+        std::map<std::string, Entry> entries;
+        uint64_t bytesParsed = 0;
+
+        // Checkpoints, where the cache is saved part of the way through an
+        // import (see enableCheckpoints())
+        bool checkpoints = false;
+        size_t chunkSize = DEFAULT_CHUNK_SIZE;
+        size_t checkpointCount = 0;
+        std::chrono::steady_clock::time_point lastCheckpoint;
+        std::chrono::steady_clock::duration lastCheckpointCost;
+        void maybeCheckpoint();
+
+        static const bool isLineBased(const SourceDataType &parser) noexcept;
+
+    public:
+        TailCache(const std::string &path, const std::string &key);
+
+        // The number of bytes of each file parsed at a time
+        static constexpr size_t DEFAULT_CHUNK_SIZE = 16 * 1024 * 1024;
+
+        void load() noexcept;
+        void save() const;
+        void clear() noexcept;
+        void discard() const noexcept;
+        void enableCheckpoints(const size_t chunkSize = DEFAULT_CHUNK_SIZE) noexcept;
+
+        void import(Areas &areas,
+                    const std::string &file,
+                    const InputFileSource &dataset,
+                    const StringFilterSet &areasFilter,
+                    const StringFilterSet &measuresFilter,
+                    const YearFilter &yearsFilter);
+
+        const uint64_t getBytesParsed() const noexcept;
+        const size_t size() const noexcept;
+        const size_t getCheckpointCount() const noexcept;
+    };
+}
+
+#endif // TAIL_H_
@@ -0,0 +1,78 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "../bethyw.h"
+#include "../areas.h"
+
+SCENARIO( "strings can be case folded for searching", "[BethYw][foldCase]" ) {
+
+  GIVEN( "ASCII strings" ) {
+
+    THEN( "letters are lowercased and other characters are unchanged" ) {
+
+      REQUIRE( BethYw::foldCase("W06000011") == "w06000011" );
+      REQUIRE( BethYw::foldCase("Vale of Glamorgan, 2") == "vale of glamorgan, 2" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "Welsh names containing accented letters" ) {
+
+    THEN( "accented letters are lowercased" ) {
+
+      REQUIRE( BethYw::foldCase("YNYS MÔN") == "ynys môn" );
+      REQUIRE( BethYw::foldCase("ŴY ẀY ỲD") == "ŵy ẁy ỳd" );
+
+    } // THEN
+
+    THEN( "accents can also be stripped" ) {
+
+      REQUIRE( BethYw::foldCase("Ynys Môn", true) == "ynys mon" );
+      REQUIRE( BethYw::foldCase("ŴY ẀY ỲD", true) == "wy wy yd" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "the areas filter ignores case and accents", "[Areas][filter]" ) {
+
+  GIVEN( "a newly constructed Areas instance and an areas.csv style stream" ) {
+
+    Areas areas;
+    std::istringstream stream("Local authority code,Name (eng),Name (cym)\n"
+                              "W06000001,Isle of Anglesey,Ynys Môn\n"
+                              "W06000015,Cardiff,Caerdydd\n");
+
+    WHEN( "the stream is imported with an unaccented, uppercase filter" ) {
+
+      StringFilterSet areasFilter = {"YNYS MON"};
+      areas.populateFromAuthorityCodeCSV(stream, BethYw::InputFiles::AREAS.COLS, &areasFilter);
+
+      THEN( "only the matching area is imported" ) {
+
+        REQUIRE( areas.size() == 1 );
+        REQUIRE_NOTHROW( areas.getArea("W06000001") );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,207 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../store.h"
+#include "../authorities.h"
+#include "../bethyw.h"
+#include "../lib_cxxopts_argv.hpp"
+
+SCENARIO( "an Area can be written to and read from a store", "[store][Area]" ) {
+
+  GIVEN( "an Area with names and a measure" ) {
+
+    Area area("W06000011");
+    area.setName("eng", "Swansea");
+    area.setName("cym", "Abertawe");
+
+    Measure measure("Pop", "Population");
+    measure.setValue(1991, 230000.5);
+    measure.setValue(2019, 246993);
+    area.setMeasure("Pop", measure);
+
+    WHEN( "it is written to a stream and read back" ) {
+
+      std::stringstream stream;
+      BethYw::writeArea(stream, area);
+      auto read = BethYw::readArea(stream);
+
+      THEN( "the Area read is equal to the Area written" ) {
+
+        REQUIRE( read );
+        REQUIRE( *read == area );
+
+        AND_THEN( "there are no more Areas in the stream" ) {
+
+          REQUIRE_FALSE( BethYw::readArea(stream) );
+
+        } // AND_THEN
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "an Areas instance gives the same output in external-memory mode", "[Areas][memory-limit]" ) {
+
+  GIVEN( "two Areas instances, one limited to 4KB of memory" ) {
+
+    Areas inMemory;
+    Areas external;
+    external.setMemoryLimit(4 * 1024, "");
+
+    WHEN( "popu1009.json is imported into both" ) {
+
+      std::ifstream stream1("datasets/popu1009.json");
+      std::ifstream stream2("datasets/popu1009.json");
+      REQUIRE( stream1.is_open() );
+      REQUIRE( stream2.is_open() );
+
+      inMemory.populateFromWelshStatsJSON(stream1, BethYw::InputFiles::POPDEN.COLS);
+      external.populateFromWelshStatsJSON(stream2, BethYw::InputFiles::POPDEN.COLS);
+
+      THEN( "the table and JSON output are identical" ) {
+
+        std::stringstream table1;
+        std::stringstream table2;
+        table1 << inMemory;
+        table2 << external;
+
+        REQUIRE( table1.str() == table2.str() );
+        REQUIRE( inMemory.toJSON() == external.toJSON() );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+#ifndef _WIN32
+SCENARIO( "run files are merged with a bounded fan-in", "[Areas][memory-limit]" ) {
+
+  GIVEN( "an Areas instance that spills after every area" ) {
+
+    char dir[] = "/tmp/bethyw-test14-XXXXXX";
+    REQUIRE( mkdtemp(dir) != nullptr );
+
+    // Count the run files left in the temporary directory
+    auto countRuns = [&dir]() {
+      size_t count = 0;
+      DIR *listing = opendir(dir);
+      while (struct dirent *entry = readdir(listing)) {
+        count += std::string(entry->d_name).find(".run") != std::string::npos ? 1 : 0;
+      }
+      closedir(listing);
+      return count;
+    };
+
+    size_t count = 0;
+    const BethYw::Authority *authorities = BethYw::embeddedAuthorities(count);
+
+    Areas inMemory;
+    inMemory.populateFromAuthorities(authorities, count, nullptr);
+    std::ifstream stream1("datasets/popu1009.json");
+    REQUIRE( stream1.is_open() );
+    inMemory.populateFromWelshStatsJSON(stream1, BethYw::InputFiles::POPDEN.COLS);
+
+    {
+      Areas external;
+      external.setMemoryLimit(1, std::string(dir) + "/");
+      external.populateFromAuthorities(authorities, count, nullptr);
+      std::ifstream stream2("datasets/popu1009.json");
+      REQUIRE( stream2.is_open() );
+      external.populateFromWelshStatsJSON(stream2, BethYw::InputFiles::POPDEN.COLS);
+
+      const size_t spilled = countRuns();
+
+      std::stringstream table1;
+      std::stringstream table2;
+      table1 << inMemory;
+      table2 << external;
+
+      THEN( "the runs are compacted and the output is the same" ) {
+
+        REQUIRE( spilled > 20 );
+        REQUIRE( countRuns() <= 4 );
+        REQUIRE( table1.str() == table2.str() );
+        REQUIRE( inMemory.toJSON() == external.toJSON() );
+
+      } // THEN
+    }
+
+    REQUIRE( countRuns() == 0 );
+    rmdir(dir);
+
+  } // GIVEN
+
+} // SCENARIO
+#endif
+
+SCENARIO( "a string with a corrupt length is not read from a store", "[store]" ) {
+
+  GIVEN( "a stream holding a string length of 4 GiB but only a few bytes" ) {
+
+    std::stringstream stream;
+    BethYw::writeU32(stream, 0xFFFFFFFF);
+    stream << "abc";
+
+    THEN( "it is rejected as malformed" ) {
+
+      REQUIRE_THROWS_AS( BethYw::readString(stream), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a memory limit too large for this machine is rejected", "[memory-limit]" ) {
+
+  for (const std::string limit : {"99999999999999999999", "18014398509481984G"}) {
+
+    GIVEN( "the memory limit argument " + limit ) {
+
+      Argv argv({"test", "--memory-limit", limit.c_str()});
+      auto** actual_argv = argv.argv();
+      auto argc          = argv.argc();
+
+      auto cxxopts = BethYw::cxxoptsSetup();
+      auto args    = cxxopts.parse(argc, actual_argv);
+
+      THEN( "it is an invalid argument" ) {
+
+        REQUIRE_THROWS_AS( BethYw::parseMemoryLimitArg(args), std::invalid_argument );
+
+      } // THEN
+
+    } // GIVEN
+
+  }
+
+} // SCENARIO
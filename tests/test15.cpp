@@ -0,0 +1,68 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <vector>
+
+#include "../numeric.h"
+
+SCENARIO( "values can be summed without losing precision", "[numeric][sum]" ) {
+
+  GIVEN( "values whose naive sum cancels out a small value" ) {
+
+    const std::vector<double> values = {1e16, 1.0, -1e16};
+
+    THEN( "the compensated sum keeps the small value" ) {
+
+      BethYw::CompensatedSum sum;
+      for (auto value : values) {
+        sum.add(value);
+      }
+
+      REQUIRE( sum.result() == 1.0 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a long series of values" ) {
+
+    std::vector<double> values;
+    for (int i = 0; i < 100000; i++) {
+      values.push_back(0.1 * (i % 97) + 1e-3 * i);
+    }
+
+    THEN( "the pairwise sum agrees with the compensated sum" ) {
+
+      BethYw::CompensatedSum sum;
+      for (auto value : values) {
+        sum.add(value);
+      }
+
+      REQUIRE( BethYw::pairwiseSum(values.data(), values.size()) == Approx(sum.result()).epsilon(1e-14) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "no values" ) {
+
+    THEN( "the sum and mean are 0" ) {
+
+      REQUIRE( BethYw::pairwiseSum(nullptr, 0) == 0 );
+      REQUIRE( BethYw::mean(nullptr, 0) == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,75 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../lib_json.hpp"
+#include "../datasets.h"
+#include "../areas.h"
+
+SCENARIO( "a JSON Lines dataset can be imported", "[Areas][JSONL]" ) {
+
+  GIVEN( "popu1009.json and the same rows as JSON Lines" ) {
+
+    std::ifstream stream("datasets/popu1009.json");
+    REQUIRE( stream.is_open() );
+
+    nlohmann::json j;
+    stream >> j;
+
+    std::stringstream lines;
+    lines << "\n";
+    for (auto &row : j["value"]) {
+      lines << row.dump() << "\r\n";
+    }
+
+    stream.clear();
+    stream.seekg(0);
+
+    WHEN( "both are imported" ) {
+
+      Areas json;
+      Areas jsonl;
+      json.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS);
+      jsonl.populateFromWelshStatsJSONL(lines, BethYw::InputFiles::POPDEN.COLS);
+
+      THEN( "the Areas are identical" ) {
+
+        REQUIRE( jsonl.size() == json.size() );
+        REQUIRE( jsonl.toJSON() == json.toJSON() );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "a JSON Lines stream with a malformed line" ) {
+
+    std::stringstream lines;
+    lines << "\n{\n";
+
+    THEN( "a std::runtime_error is thrown" ) {
+
+      Areas areas;
+      REQUIRE_THROWS_AS(
+        areas.populateFromWelshStatsJSONL(lines, BethYw::InputFiles::POPDEN.COLS),
+        std::runtime_error);
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
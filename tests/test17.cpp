@@ -0,0 +1,191 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+
+SCENARIO( "a summarised Measure gives the same statistics", "[Measure][stats-only]" ) {
+
+  GIVEN( "a Measure with values added out of order, including a repeated last year" ) {
+
+    Measure measure("pop", "Population");
+    measure.setValue(2015, 10);
+    measure.setValue(2011, 4);
+    measure.setValue(2019, 7);
+    measure.setValue(2013, -2);
+    measure.setValue(2019, 9);
+
+    Measure summarised("pop", "Population");
+    summarised.summarise();
+    summarised.setValue(2015, 10);
+    summarised.setValue(2011, 4);
+    summarised.setValue(2019, 7);
+    summarised.setValue(2013, -2);
+    summarised.setValue(2019, 9);
+
+    THEN( "the average and differences are the same" ) {
+
+      REQUIRE( summarised.isSummarised() );
+      REQUIRE( summarised.size() == measure.size() );
+      REQUIRE( summarised.getValues().empty() );
+      REQUIRE( summarised.getAverage() == Approx(measure.getAverage()) );
+      REQUIRE( summarised.getDifference() == measure.getDifference() );
+      REQUIRE( summarised.getDifferenceAsPercentage() == measure.getDifferenceAsPercentage() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a Measure with a repeated year between the first and last" ) {
+
+    Measure measure("area", "Land area");
+    measure.setValue(2011, 100);
+    measure.setValue(2013, 300);
+    measure.setValue(2015, 500);
+    measure.setValue(2013, 900);
+
+    Measure summarised("area", "Land area");
+    summarised.summarise();
+    summarised.setValue(2011, 100);
+    summarised.setValue(2013, 300);
+    summarised.setValue(2015, 500);
+    summarised.setValue(2013, 900);
+
+    THEN( "only the latest value of the year is in the average" ) {
+
+      REQUIRE( summarised.size() == 3 );
+      REQUIRE( summarised.getAverage() == measure.getAverage() );
+      REQUIRE( summarised.getAverage() == 500 );
+
+    } // THEN
+
+    WHEN( "a summarised Measure with overlapping years is merged in" ) {
+
+      Measure other("area", "Land area");
+      other.summarise();
+      other.setValue(2013, 600);
+      other.setValue(2017, 1000);
+      summarised += other;
+
+      Measure otherValues("area", "Land area");
+      otherValues.setValue(2013, 600);
+      otherValues.setValue(2017, 1000);
+      measure += otherValues;
+
+      THEN( "the merged Measure takes precedence for the years in both" ) {
+
+        REQUIRE( summarised.size() == 4 );
+        REQUIRE( summarised.getAverage() == measure.getAverage() );
+        REQUIRE( summarised.getDifference() == measure.getDifference() );
+        REQUIRE( summarised.getDifferenceAsPercentage() == measure.getDifferenceAsPercentage() );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "an Areas instance in stats-only mode keeps the same statistics", "[Areas][stats-only]" ) {
+
+  GIVEN( "two Areas instances, one in stats-only mode" ) {
+
+    Areas full;
+    Areas statsOnly;
+    statsOnly.setStatsOnly(true);
+
+    WHEN( "popu1009.json is imported into both" ) {
+
+      std::ifstream stream1("datasets/popu1009.json");
+      std::ifstream stream2("datasets/popu1009.json");
+      REQUIRE( stream1.is_open() );
+      REQUIRE( stream2.is_open() );
+
+      full.populateFromWelshStatsJSON(stream1, BethYw::InputFiles::POPDEN.COLS);
+      statsOnly.populateFromWelshStatsJSON(stream2, BethYw::InputFiles::POPDEN.COLS);
+
+      THEN( "every Measure has the same average and differences" ) {
+
+        REQUIRE( statsOnly.size() == full.size() );
+
+        full.forEachArea([&statsOnly](const Area &area) {
+          Area &summary = statsOnly.getArea(area.getLocalAuthorityCode());
+
+          for (auto &measure : area.getMeasures()) {
+            Measure &summarised = summary.getMeasure(measure.first);
+
+            REQUIRE( summarised.isSummarised() );
+            REQUIRE( summarised.size() == measure.second.size() );
+            REQUIRE( std::to_string(summarised.getAverage()) == std::to_string(measure.second.getAverage()) );
+            REQUIRE( summarised.getDifference() == measure.second.getDifference() );
+            REQUIRE( summarised.getDifferenceAsPercentage() == measure.second.getDifferenceAsPercentage() );
+          }
+        });
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "every dataset imported in stats-only mode gives the same statistics", "[Areas][stats-only]" ) {
+
+  GIVEN( "two Areas instances, one in stats-only mode" ) {
+
+    Areas full;
+    Areas statsOnly;
+    statsOnly.setStatsOnly(true);
+
+    WHEN( "all the datasets are imported into both" ) {
+
+      const std::vector<BethYw::InputFileSource> datasets(BethYw::InputFiles::DATASETS,
+                                                          BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+      BethYw::importDatasets(full, "datasets/", datasets, StringFilterSet(), StringFilterSet(), BethYw::YearFilter());
+      BethYw::importDatasets(statsOnly, "datasets/", datasets, StringFilterSet(), StringFilterSet(), BethYw::YearFilter());
+
+      THEN( "the statistics printed for every Measure are the same" ) {
+
+        REQUIRE( statsOnly.size() == full.size() );
+
+        size_t measures = 0;
+        full.forEachArea([&](const Area &area) {
+          Area &summary = statsOnly.getArea(area.getLocalAuthorityCode());
+
+          for (auto &measure : area.getMeasures()) {
+            Measure &summarised = summary.getMeasure(measure.first);
+
+            REQUIRE( summarised.isSummarised() );
+            REQUIRE( summarised.size() == measure.second.size() );
+            REQUIRE( summarised.getAverage() == measure.second.getAverage() );
+            REQUIRE( summarised.getDifference() == measure.second.getDifference() );
+            REQUIRE( summarised.getDifferenceAsPercentage() == measure.second.getDifferenceAsPercentage() );
+            measures++;
+          }
+        });
+
+        REQUIRE( measures > 500 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
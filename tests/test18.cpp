@@ -0,0 +1,198 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../quantiles.h"
+#include "../bethyw.h"
+
+SCENARIO( "a t-digest estimates quantiles", "[TDigest][quantiles]" ) {
+
+  GIVEN( "a digest of a few values" ) {
+
+    BethYw::TDigest digest;
+    for (int i = 11; i >= 1; i--) {
+      digest.add(i);
+    }
+
+    THEN( "every value is kept and the quantiles are exact" ) {
+
+      REQUIRE( digest.size() == 11 );
+      REQUIRE( digest.centroidCount() == 11 );
+      REQUIRE( digest.quantile(0) == 1 );
+      REQUIRE( digest.quantile(0.5) == 6 );
+      REQUIRE( digest.quantile(1) == 11 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "four digests of 100,000 exponentially distributed values each" ) {
+
+    std::mt19937 generator(1);
+    std::exponential_distribution<double> distribution(1);
+    std::vector<double> values;
+    BethYw::TDigest parts[4];
+
+    for (int i = 0; i < 400000; i++) {
+      values.push_back(distribution(generator));
+      parts[i % 4].add(values.back());
+    }
+
+    std::sort(values.begin(), values.end());
+
+    WHEN( "they are merged" ) {
+
+      BethYw::TDigest digest;
+      for (auto &part : parts) {
+        digest.merge(part);
+      }
+
+      THEN( "the number of centroids is bounded by the compression" ) {
+
+        REQUIRE( digest.size() == 400000 );
+        REQUIRE( digest.centroidCount() <= BethYw::DEFAULT_COMPRESSION );
+
+      } // THEN
+
+      THEN( "p50, p90 and p99 are within the documented rank error" ) {
+
+        for (auto &quantile : BethYw::QUANTILES) {
+          const double estimate = digest.quantile(quantile.second);
+          const double rank = (std::lower_bound(values.begin(), values.end(), estimate) - values.begin())
+                              / (double)values.size();
+
+          REQUIRE( std::abs(rank - quantile.second) <= (quantile.second == 0.5 ? 0.005 : 0.002) );
+        }
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "the quantiles of each measure can be calculated across areas", "[Areas][quantiles]" ) {
+
+  GIVEN( "popu1009.json imported into an Areas instance" ) {
+
+    Areas areas;
+    std::ifstream stream("datasets/popu1009.json");
+    REQUIRE( stream.is_open() );
+    areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS);
+
+    THEN( "the digests are close to the exact quantiles for any number of threads" ) {
+
+      std::map<std::string, std::vector<double>> exact;
+      areas.forEachArea([&exact](const Area &area) {
+        for (auto &measure : area.getMeasures()) {
+          for (auto &value : measure.second.getValues()) {
+            exact[measure.first].push_back(value.second);
+          }
+        }
+      });
+
+      for (unsigned int threads : {1, 3}) {
+        auto digests = BethYw::digestMeasures(areas, threads);
+        REQUIRE( digests.size() == 3 );
+
+        for (auto &it : exact) {
+          std::sort(it.second.begin(), it.second.end());
+          const size_t n = it.second.size();
+
+          REQUIRE( digests[it.first].digest.size() == n );
+
+          for (auto &quantile : BethYw::QUANTILES) {
+            // There are only a few hundred values, so allow a 5% rank error
+            const double estimate = digests[it.first].digest.quantile(quantile.second);
+            const size_t low = (size_t)std::max(0.0, (quantile.second - 0.05) * n);
+            const size_t high = std::min(n - 1, (size_t)((quantile.second + 0.05) * n));
+
+            REQUIRE( estimate >= it.second[low] );
+            REQUIRE( estimate <= it.second[high] );
+          }
+        }
+      }
+
+    } // THEN
+
+    THEN( "an Areas instance spilled to run files gives the same digests" ) {
+
+      Areas external;
+      external.setMemoryLimit(4 * 1024, "");
+      std::ifstream again("datasets/popu1009.json");
+      REQUIRE( again.is_open() );
+      external.populateFromWelshStatsJSON(again, BethYw::InputFiles::POPDEN.COLS);
+
+      auto expected = BethYw::digestMeasures(areas, 1);
+
+      for (unsigned int threads : {1, 4}) {
+        auto digests = BethYw::digestMeasures(external, threads);
+        REQUIRE( digests.size() == expected.size() );
+
+        for (auto &it : expected) {
+          REQUIRE( digests[it.first].label == it.second.label );
+          REQUIRE( digests[it.first].digest.size() == it.second.digest.size() );
+        }
+      }
+
+      REQUIRE( BethYw::digestMeasures(external, 1)["pop"].digest.quantile(0.5)
+               == expected["pop"].digest.quantile(0.5) );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "the quantiles are the same for any number of threads", "[Areas][quantiles]" ) {
+
+  GIVEN( "every dataset imported into an Areas instance" ) {
+
+    Areas areas;
+    const std::vector<BethYw::InputFileSource> datasets(BethYw::InputFiles::DATASETS,
+                                                        BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+    BethYw::importDatasets(areas, "datasets/", datasets, StringFilterSet(), StringFilterSet(), BethYw::YearFilter());
+
+    THEN( "every quantile of every measure is identical on every run" ) {
+
+      auto expected = BethYw::digestMeasures(areas, 1);
+      REQUIRE( expected.size() > 0 );
+
+      for (int run = 0; run < 5; run++) {
+        for (unsigned int threads : {2, 3, 4, 8}) {
+          auto digests = BethYw::digestMeasures(areas, threads);
+          REQUIRE( digests.size() == expected.size() );
+
+          for (auto &it : expected) {
+            for (auto &quantile : BethYw::QUANTILES) {
+              REQUIRE( digests[it.first].digest.quantile(quantile.second)
+                       == it.second.digest.quantile(quantile.second) );
+            }
+          }
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,78 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+
+SCENARIO( "rows are imported in batches with the same result as one at a time", "[Areas][RowBatch]" ) {
+
+  GIVEN( "a JSON dataset with rows out of order, a repeated year and a renamed area" ) {
+
+    std::stringstream stream;
+    stream << R"({"value":[)"
+           << R"({"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"Second","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2012","Data":2},)"
+           << R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"First","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2011","Data":1},)"
+           << R"({"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"Second","Measure_Code":"Area","Measure_ItemName_ENG":"Land area","Year_Code":"2011","Data":3},)"
+           << R"({"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"Renamed","Measure_Code":"POP","Measure_ItemName_ENG":"People","Year_Code":"2012","Data":4},)"
+           << R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"First","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2010","Data":5})"
+           << "]}";
+
+    WHEN( "it is imported" ) {
+
+      Areas areas;
+      areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS);
+
+      THEN( "the last row for each key takes precedence" ) {
+
+        REQUIRE( areas.size() == 2 );
+
+        Area &second = areas.getArea("W2");
+        REQUIRE( second.getName("eng") == "Renamed" );
+        REQUIRE( second.size() == 2 );
+        REQUIRE( second.getMeasure("pop").getLabel() == "People" );
+        REQUIRE( second.getMeasure("pop").getValue(2012) == 4 );
+        REQUIRE( second.getMeasure("area").getValue(2011) == 3 );
+
+        Area &first = areas.getArea("W1");
+        REQUIRE( first.getName("eng") == "First" );
+        REQUIRE( first.getMeasure("pop").size() == 2 );
+        REQUIRE( first.getMeasure("pop").getValue(2010) == 5 );
+        REQUIRE( first.getMeasure("pop").getValue(2011) == 1 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "it is imported with a years filter that excludes every row" ) {
+
+      Areas areas;
+      YearFilterTuple years = std::make_tuple(2000, 2009);
+      areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS, nullptr, nullptr, &years);
+
+      THEN( "the Area and Measure are still created without values" ) {
+
+        REQUIRE( areas.size() == 2 );
+        REQUIRE( areas.getArea("W1").getMeasure("pop").size() == 0 );
+        REQUIRE( areas.getArea("W2").getMeasure("area").size() == 0 );
+        REQUIRE( areas.getArea("W2").getMeasure("pop").size() == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,148 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../rowstream.h"
+
+SCENARIO( "stages of a RowStream pipeline run on their own threads", "[RowStream]" ) {
+
+  GIVEN( "a stream of lines larger than a queue and a block" ) {
+
+    std::stringstream stream;
+    for (int i = 0; i < 5000; i++) {
+      stream << i << (i % 2 ? "," : ",x") << "\n";
+    }
+    stream << "last";
+
+    auto lines = BethYw::RowStreamPtr<std::string>(new BethYw::LineSplitter(
+        BethYw::RowStreamPtr<std::string>(new BethYw::ByteSource(stream, 7))));
+
+    WHEN( "the lines are split into fields and filtered on other threads" ) {
+
+      auto fields = BethYw::addStage<std::string, std::string>(std::move(lines), [](std::string &line, std::vector<std::string> &out) {
+        for (auto &field : BethYw::splitFields(line)) {
+          out.push_back(field);
+        }
+      });
+      fields = BethYw::addStage<std::string, std::string>(std::move(fields), [](std::string &field, std::vector<std::string> &out) {
+        if (field != "x") {
+          out.push_back(field);
+        }
+      });
+      BethYw::ThreadedStage<std::string> sink(std::move(fields));
+
+      THEN( "every item arrives in order" ) {
+
+        std::string field;
+        for (int i = 0; i < 5000; i++) {
+          REQUIRE( sink.next(field) );
+          REQUIRE( field == std::to_string(i) );
+        }
+
+        REQUIRE( sink.next(field) );
+        REQUIRE( field == "last" );
+        REQUIRE_FALSE( sink.next(field) );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a stage throws part way through" ) {
+
+      auto checked = BethYw::addStage<std::string, std::string>(std::move(lines), [](std::string &line, std::vector<std::string> &out) {
+        if (line == "100,x") {
+          throw std::runtime_error("Malformed file!");
+        }
+        out.push_back(line);
+      });
+      BethYw::ThreadedStage<std::string> sink(std::move(checked));
+
+      THEN( "the items before it arrive and then the exception is rethrown" ) {
+
+        std::string line;
+        for (int i = 0; i < 100; i++) {
+          REQUIRE( sink.next(line) );
+        }
+
+        REQUIRE( line == "99," );
+        REQUIRE_THROWS_AS( sink.next(line), std::runtime_error );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the consumer stops early" ) {
+
+      THEN( "the pipeline shuts down" ) {
+
+        BethYw::ThreadedStage<std::string> sink(std::move(lines));
+        std::string line;
+        REQUIRE( sink.next(line) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "a line split the same way as std::getline()" ) {
+
+    THEN( "an empty final field is dropped" ) {
+
+      REQUIRE( BethYw::splitFields("a,,b") == std::vector<std::string>({"a", "", "b"}) );
+      REQUIRE( BethYw::splitFields("a,b,") == std::vector<std::string>({"a", "b"}) );
+      REQUIRE( BethYw::splitFields(",") == std::vector<std::string>({""}) );
+      REQUIRE( BethYw::splitFields("").empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "the area filter sees names imported earlier in the same pipeline", "[Areas][RowStream]" ) {
+
+  GIVEN( "a JSON dataset where an area is renamed to a name that no longer matches" ) {
+
+    std::stringstream stream;
+    stream << R"({"value":[)"
+           << R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"Swansea","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2011","Data":1},)"
+           << R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"Abertawe","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2012","Data":2},)"
+           << R"({"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"Cardiff","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2011","Data":3})"
+           << "]}";
+
+    WHEN( "it is imported with an area filter on the first name" ) {
+
+      Areas areas;
+      StringFilterSet filter = {"swan"};
+      areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS, &filter);
+
+      THEN( "both rows of the area are imported, as the area already matched" ) {
+
+        REQUIRE( areas.size() == 1 );
+        REQUIRE( areas.getArea("W1").getName("eng") == "Abertawe" );
+        REQUIRE( areas.getArea("W1").getMeasure("pop").size() == 2 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
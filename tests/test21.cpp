@@ -0,0 +1,107 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "../areas.h"
+#include "../ranks.h"
+
+SCENARIO( "areas are ranked for each measure in each year", "[ranks]" ) {
+
+  GIVEN( "a column of values with a tie" ) {
+
+    BethYw::RankColumn column;
+    column.values = {5, 9, 5, 1, 7};
+    column.areaIds = {0, 1, 2, 3, 4};
+
+    WHEN( "the column is ranked" ) {
+
+      BethYw::rankColumn(column);
+
+      THEN( "the largest value is first and tied values share the best rank" ) {
+
+        REQUIRE( column.ranks == std::vector<unsigned int>({3, 1, 3, 5, 2}) );
+        REQUIRE( column.percentiles == std::vector<double>({25, 100, 25, 0, 75}) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "a column of values including NaNs" ) {
+
+    BethYw::RankColumn column;
+    column.values = {NAN, 5, NAN, 9, 1, NAN};
+    column.areaIds = {0, 1, 2, 3, 4, 5};
+
+    WHEN( "the column is ranked" ) {
+
+      BethYw::rankColumn(column);
+
+      THEN( "the NaNs are ranked last, tied with each other" ) {
+
+        REQUIRE( column.ranks == std::vector<unsigned int>({4, 2, 4, 1, 3, 4}) );
+        REQUIRE( column.percentiles == std::vector<double>({0, 80, 0, 100, 60, 0}) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "areas with values in different years" ) {
+
+    Areas areas;
+    const unsigned int years[] = {2010, 2011};
+    const double values[][2] = {{10, 1}, {30, 3}, {20, 2}};
+
+    for (int i = 0; i < 3; i++) {
+      Area area("W" + std::to_string(i));
+      Measure measure("pop", "Population");
+
+      for (int y = 0; y < 2; y++) {
+        if (i != 2 || y != 1) {
+          measure.setValue(years[y], values[i][y]);
+        }
+      }
+
+      area.setMeasure("pop", measure);
+      areas.setArea(area.getLocalAuthorityCode(), area);
+    }
+
+    WHEN( "ranks are added" ) {
+
+      BethYw::addRanks(areas, 2);
+
+      THEN( "each year is ranked among the areas with a value for it" ) {
+
+        REQUIRE( areas.getArea("W1").getMeasure("pop-rank").getValue(2010) == 1 );
+        REQUIRE( areas.getArea("W2").getMeasure("pop-rank").getValue(2010) == 2 );
+        REQUIRE( areas.getArea("W0").getMeasure("pop-rank").getValue(2010) == 3 );
+        REQUIRE( areas.getArea("W2").getMeasure("pop-percentile").getValue(2010) == 50 );
+
+        REQUIRE( areas.getArea("W1").getMeasure("pop-rank").getValue(2011) == 1 );
+        REQUIRE( areas.getArea("W0").getMeasure("pop-percentile").getValue(2011) == 0 );
+        REQUIRE( areas.getArea("W2").getMeasure("pop-rank").size() == 1 );
+        REQUIRE( areas.getArea("W1").getMeasure("pop-rank").getLabel() == "Population rank" );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,85 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include "../areas.h"
+#include "../forecast.h"
+
+SCENARIO( "series are projected from a linear trend", "[forecast]" ) {
+
+  GIVEN( "a series on a straight line with a gap in its years" ) {
+
+    const unsigned int years[] = {2010, 2011, 2015, 2016};
+    const double values[] = {100, 102, 110, 112};
+    BethYw::Trend trend;
+
+    THEN( "least squares finds the line" ) {
+
+      REQUIRE( BethYw::fitLeastSquares(years, values, 4, trend) );
+      REQUIRE( trend.slope == Approx(2) );
+      REQUIRE( trend.project(2018) == Approx(116) );
+
+    } // THEN
+
+    THEN( "Holt's smoothing follows the line across the gap" ) {
+
+      REQUIRE( BethYw::fitHolt(years, values, 4, trend) );
+      REQUIRE( trend.slope == Approx(2) );
+      REQUIRE( trend.project(2018) == Approx(116) );
+
+    } // THEN
+
+    THEN( "a single value has no trend" ) {
+
+      REQUIRE_FALSE( BethYw::fitLeastSquares(years, values, 1, trend) );
+      REQUIRE_FALSE( BethYw::fitHolt(years, values, 1, trend) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "areas with a series of two values and a series of one" ) {
+
+    Areas areas;
+    Area area("W1");
+    Measure pop("pop", "Population");
+    pop.setValue(2010, 10);
+    pop.setValue(2012, 14);
+    Measure dens("dens", "Density");
+    dens.setValue(2010, 1);
+    area.setMeasure("pop", pop);
+    area.setMeasure("dens", dens);
+    areas.setArea("W1", area);
+
+    WHEN( "two years are forecast" ) {
+
+      BethYw::addForecasts(areas, 2, BethYw::LeastSquares, 2);
+
+      THEN( "the projections are added as a separate Measure" ) {
+
+        Area &result = areas.getArea("W1");
+        REQUIRE( result.size() == 3 );
+        REQUIRE( result.getMeasure("pop").size() == 2 );
+
+        Measure &forecast = result.getMeasure("pop" + BethYw::FORECAST_SUFFIX);
+        REQUIRE( forecast.getLabel() == "Population forecast" );
+        REQUIRE( forecast.size() == 2 );
+        REQUIRE( forecast.getValue(2013) == Approx(16) );
+        REQUIRE( forecast.getValue(2014) == Approx(18) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,112 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "../similar.h"
+
+SCENARIO( "the areas most like an area are found from normalised features", "[similar]" ) {
+
+  GIVEN( "areas with two measures in very different units" ) {
+
+    auto fill = [](BethYw::FeatureMatrix &matrix) {
+      matrix.add("W1", "pop", 2010, 1000000);
+      matrix.add("W1", "dens", 2010, 1);
+      matrix.add("W2", "pop", 2010, 1100000);
+      matrix.add("W2", "dens", 2010, 1);
+      matrix.add("W3", "pop", 2010, 1000000);
+      matrix.add("W3", "dens", 2010, 3);
+      matrix.add("W4", "pop", 2010, 3000000);
+      matrix.add("W4", "pop", 2011, 1000000);
+      matrix.add("W4", "dens", 2010, 1);
+    };
+
+    WHEN( "the matrix is built for a year" ) {
+
+      BethYw::FeatureMatrix matrix(2010);
+      fill(matrix);
+      matrix.build();
+
+      THEN( "each feature is a z-score, so neither measure outweighs the other" ) {
+
+        REQUIRE( matrix.rows() == 4 );
+        REQUIRE( matrix.width() == 2 );
+        REQUIRE( matrix.column(0)[0] + matrix.column(0)[1] + matrix.column(0)[2] + matrix.column(0)[3] == Approx(0).margin(1e-9) );
+
+        auto nearest = matrix.nearest("W1", 2);
+        REQUIRE( nearest.size() == 2 );
+        REQUIRE( nearest[0].localAuthorityCode == "W2" );
+        REQUIRE( nearest[1].localAuthorityCode == "W3" );
+        REQUIRE( nearest[0].distance < nearest[1].distance );
+
+      } // THEN
+
+      THEN( "no more areas are returned than there are" ) {
+
+        REQUIRE( matrix.nearest("W1", 10).size() == 3 );
+
+      } // THEN
+
+      THEN( "an unknown area throws" ) {
+
+        REQUIRE_THROWS_AS( matrix.nearest("W9", 1), std::out_of_range );
+
+      } // THEN
+
+      THEN( "an area is found in any case" ) {
+
+        REQUIRE( matrix.resolve("w1") == "W1" );
+        REQUIRE( matrix.nearest("w1", 2)[0].localAuthorityCode == "W2" );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the matrix is built for the latest year of each measure" ) {
+
+      BethYw::FeatureMatrix matrix;
+      fill(matrix);
+      matrix.build();
+
+      THEN( "areas without a value in that year get the mean" ) {
+
+        REQUIRE( matrix.getYears()[0] == 2011 );
+        REQUIRE( matrix.column(0)[0] == 0 );
+        REQUIRE( matrix.column(0)[3] == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "a measure of large values that differ only slightly" ) {
+
+    BethYw::FeatureMatrix matrix;
+    matrix.add("W1", "pop", 2010, 1e9 + 1);
+    matrix.add("W2", "pop", 2010, 1e9 + 2);
+    matrix.add("W3", "pop", 2010, 1e9 + 3);
+    matrix.build();
+
+    THEN( "the z-scores are not lost to rounding" ) {
+
+      REQUIRE( matrix.column(0)[0] == Approx(-1.2247448714) );
+      REQUIRE( matrix.column(0)[1] == Approx(0).margin(1e-9) );
+      REQUIRE( matrix.column(0)[2] == Approx(1.2247448714) );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
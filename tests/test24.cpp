@@ -0,0 +1,58 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+
+#include "../lib_json.hpp"
+#include "../areas.h"
+
+SCENARIO( "JSON can be written in a columnar layout", "[Areas][JSON]" ) {
+
+  GIVEN( "two areas with values in different years" ) {
+
+    Areas areas;
+
+    Area first("W1");
+    first.setName("eng", "First");
+    Measure pop1("pop", "Population");
+    pop1.setValue(2010, 1);
+    pop1.setValue(2012, 3);
+    first.setMeasure("pop", pop1);
+    areas.setArea("W1", first);
+
+    Area second("W2");
+    Measure pop2("pop", "Population");
+    pop2.setValue(2011, 2.5);
+    second.setMeasure("pop", pop2);
+    areas.setArea("W2", second);
+
+    WHEN( "they are written in the columnar layout" ) {
+
+      std::stringstream stream;
+      areas.writeColumnarJSON(stream);
+      auto j = nlohmann::json::parse(stream.str());
+
+      THEN( "the years are written once and each area's values are aligned with them" ) {
+
+        REQUIRE( j["years"]["pop"] == nlohmann::json({2010, 2011, 2012}) );
+        REQUIRE( j["areas"]["W1"]["measures"]["pop"] == nlohmann::json({1, nullptr, 3}) );
+        REQUIRE( j["areas"]["W2"]["measures"]["pop"] == nlohmann::json({nullptr, 2.5, nullptr}) );
+        REQUIRE( j["areas"]["W1"]["names"]["eng"] == "First" );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,97 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../where.h"
+
+SCENARIO( "where expressions are compiled and evaluated over rows", "[where]" ) {
+
+  GIVEN( "an expression with and, or, not, between and brackets" ) {
+
+    BethYw::RowPredicate predicate("value between 50k and 100k and not (measure = 'Dens' or year < 2000)");
+
+    THEN( "single rows are matched" ) {
+
+      REQUIRE( predicate.matches("pop", 2010, 75000) );
+      REQUIRE( predicate.matches("pop", 2010, 50000) );
+      REQUIRE_FALSE( predicate.matches("pop", 2010, 100001) );
+      REQUIRE_FALSE( predicate.matches("dens", 2010, 75000) );
+      REQUIRE_FALSE( predicate.matches("pop", 1999, 75000) );
+
+    } // THEN
+
+    THEN( "a batch of rows gives the same results as each row on its own" ) {
+
+      RowBatch batch;
+      const uint32_t code = batch.internCode("W1");
+      const uint32_t pop = batch.internMeasure("pop", "Population");
+      const uint32_t dens = batch.internMeasure("dens", "Density");
+
+      for (unsigned int i = 0; i < 100; i++) {
+        batch.add(code, i % 3 ? pop : dens, 1990 + i % 20, i * 1500.0);
+      }
+
+      std::vector<uint8_t> mask;
+      predicate.evaluate(batch, mask);
+
+      REQUIRE( mask.size() == 100 );
+      for (unsigned int i = 0; i < 100; i++) {
+        REQUIRE( (bool)mask[i] == predicate.matches(batch.measureCodes[batch.measureIds[i]], batch.years[i], batch.values[i]) );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "invalid expressions" ) {
+
+    THEN( "compiling them throws" ) {
+
+      REQUIRE_THROWS_AS( BethYw::RowPredicate("value >"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::RowPredicate("area = 1"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::RowPredicate("measure > pop"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::RowPredicate("(year = 2000"), std::invalid_argument );
+      REQUIRE_THROWS_AS( BethYw::RowPredicate("year = 2000 2001"), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a dataset imported with an expression" ) {
+
+    std::stringstream stream;
+    stream << R"({"value":[)"
+           << R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"First","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2011","Data":10},)"
+           << R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"First","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2012","Data":50})"
+           << "]}";
+
+    Areas areas;
+    areas.setPredicate(std::make_shared<const BethYw::RowPredicate>("value > 20"));
+    areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS);
+
+    THEN( "only the matching values are stored" ) {
+
+      REQUIRE( areas.getArea("W1").getMeasure("pop").size() == 1 );
+      REQUIRE( areas.getArea("W1").getMeasure("pop").getValue(2012) == 50 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,172 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#include "../lib_cxxopts.hpp"
+#include "../lib_cxxopts_argv.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../years.h"
+
+SCENARIO( "year filters can be lists of years and ranges", "[years][filter]" ) {
+
+  GIVEN( "a --years argument with a list ('2011-2019,1991,2001')" ) {
+
+    Argv argv({"test", "--years", "2011-2019,1991,2001"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    const BethYw::YearFilter years = BethYw::parseYearsArg(args);
+
+    THEN( "the bounds are the lowest and highest years" ) {
+
+      REQUIRE( std::get<0>(years) == 1991 );
+      REQUIRE( std::get<1>(years) == 2019 );
+      REQUIRE( years.toString() == "1991,2001,2011-2019" );
+
+    } // THEN
+
+    THEN( "only the years in the list are matched" ) {
+
+      REQUIRE( years.contains(1991) );
+      REQUIRE( years.contains(2001) );
+      REQUIRE( years.contains(2011) );
+      REQUIRE( years.contains(2015) );
+      REQUIRE( years.contains(2019) );
+      REQUIRE_FALSE( years.contains(1990) );
+      REQUIRE_FALSE( years.contains(1992) );
+      REQUIRE_FALSE( years.contains(2010) );
+      REQUIRE_FALSE( years.contains(2020) );
+      REQUIRE_FALSE( years.contains(0) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "lists that overlap or include 0" ) {
+
+    THEN( "overlapping and neighbouring ranges are merged" ) {
+
+      REQUIRE( BethYw::YearFilter::parse("2015-2018,2010-2016,2019").toString() == "2010-2019" );
+
+    } // THEN
+
+    THEN( "a 0 anywhere in the list matches every year" ) {
+
+      const BethYw::YearFilter years = BethYw::YearFilter::parse("2010,0");
+
+      REQUIRE( years.all() );
+      REQUIRE( years.contains(1066) );
+      REQUIRE( std::get<0>(years) == 0 );
+      REQUIRE( std::get<1>(years) == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "invalid lists" ) {
+
+    THEN( "a std::invalid_argument exception is thrown" ) {
+
+      for (auto input : {"", "2010,", ",2010", "2010,,2011", "2015-2010", "2010-2011-2012", "201", "2010 ,2011"}) {
+        REQUIRE_THROWS_WITH( BethYw::YearFilter::parse(input), "Invalid input for years argument" );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a single range as a tuple" ) {
+
+    const YearFilterTuple range = std::make_tuple(2010, 2015);
+
+    THEN( "years before the start of the range are not matched" ) {
+
+      Areas areas;
+
+      REQUIRE_FALSE( areas.checkFilter(&range, 2009) );
+      REQUIRE_FALSE( areas.checkFilter(&range, 1000) );
+      REQUIRE( areas.checkFilter(&range, 2010) );
+      REQUIRE( areas.checkFilter(&range, 2015) );
+      REQUIRE_FALSE( areas.checkFilter(&range, 2016) );
+
+      const BethYw::YearFilter years(&range);
+      REQUIRE_FALSE( years.contains(2009) );
+      REQUIRE( years.contains(2012) );
+
+    } // THEN
+
+  } // GIVEN
+
+}
+
+SCENARIO( "a list of years is projected onto the columns of a CSV file", "[years][filter][csv]" ) {
+
+  GIVEN( "a CSV file with a column for each year" ) {
+
+    const std::string csv =
+      "AuthorityCode,1991,2000,2001,2011,2012\n"
+      "W1,1,2,3,4,5\n"
+      "W2,6,7,8,9,x\n";
+
+    WHEN( "it is imported with the filter '1991,2011'" ) {
+
+      std::istringstream stream(csv);
+      Areas areas;
+      areas.populateFromAuthorityByYearCSV(stream, BethYw::InputFiles::COMPLETE_POPDEN.COLS,
+                                           nullptr, nullptr, BethYw::YearFilter::parse("1991,2011"));
+
+      THEN( "only the values of the kept columns are imported" ) {
+
+        Measure &first = areas.getArea("W1").getMeasure("dens");
+        REQUIRE( first.size() == 2 );
+        REQUIRE( first.getValue(1991) == 1 );
+        REQUIRE( first.getValue(2011) == 4 );
+
+        // The malformed value is in a column that is never converted
+        Measure &second = areas.getArea("W2").getMeasure("dens");
+        REQUIRE( second.size() == 2 );
+        REQUIRE( second.getValue(1991) == 6 );
+        REQUIRE( second.getValue(2011) == 9 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "it is imported with a filter that matches none of the columns" ) {
+
+      std::istringstream stream(csv);
+      Areas areas;
+      areas.populateFromAuthorityByYearCSV(stream, BethYw::InputFiles::COMPLETE_POPDEN.COLS,
+                                           nullptr, nullptr, BethYw::YearFilter::parse("1995"));
+
+      THEN( "the areas and measure are still created, without values" ) {
+
+        REQUIRE( areas.size() == 2 );
+        REQUIRE( areas.getArea("W1").getMeasure("dens").size() == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+}
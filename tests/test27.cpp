@@ -0,0 +1,77 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "../areas.h"
+
+SCENARIO( "Areas, Area and Measure can be searched without exceptions", "[find]" ) {
+
+  GIVEN( "an Areas object with a named Area with a Measure" ) {
+
+    Areas areas;
+    Area area("W06000011");
+    area.setName("eng", "Swansea");
+
+    Measure measure("pop", "Population");
+    measure.setValue(2010, 240000);
+    area.setMeasure("pop", measure);
+    areas.setArea("W06000011", area);
+
+    THEN( "an existing Area is found by a string literal or a std::string" ) {
+
+      REQUIRE( areas.findArea("W06000011") == &areas.getArea("W06000011") );
+      REQUIRE( areas.findArea(std::string("W06000011")) == &areas.getArea("W06000011") );
+
+      const Areas &constAreas = areas;
+      REQUIRE( constAreas.findArea("W06000011") != nullptr );
+
+    } // THEN
+
+    THEN( "a missing Area is a null pointer, but getArea() still throws" ) {
+
+      REQUIRE( areas.findArea("W06000099") == nullptr );
+      REQUIRE_THROWS_AS( areas.getArea("W06000099"), std::out_of_range );
+      REQUIRE( areas.getExistingNames("W06000099").empty() );
+      REQUIRE( areas.getExistingNames("W06000011") == std::vector<std::string>{"Swansea"} );
+
+    } // THEN
+
+    THEN( "Measures and names are found in any case" ) {
+
+      Area &stored = areas.getArea("W06000011");
+
+      REQUIRE( stored.findMeasure("pop") == &stored.getMeasure("pop") );
+      REQUIRE( stored.findMeasure("POP") == &stored.getMeasure("pop") );
+      REQUIRE( stored.findMeasure("dens") == nullptr );
+      REQUIRE_THROWS_AS( stored.getMeasure("dens"), std::out_of_range );
+
+      REQUIRE( *stored.findName("ENG") == "Swansea" );
+      REQUIRE( stored.findName("cym") == nullptr );
+
+    } // THEN
+
+    THEN( "values are found by year" ) {
+
+      const Measure &stored = areas.getArea("W06000011").getMeasure("pop");
+
+      REQUIRE( *stored.findValue(2010) == 240000 );
+      REQUIRE( stored.findValue(2011) == nullptr );
+      REQUIRE_THROWS_AS( stored.getValue(2011), std::out_of_range );
+
+    } // THEN
+
+  } // GIVEN
+
+}
@@ -0,0 +1,103 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../areas.h"
+#include "../gsscode.h"
+
+SCENARIO( "local authority codes are packed into integers in string order", "[gsscode]" ) {
+
+  GIVEN( "well-formed and non-conforming codes" ) {
+
+    const std::vector<std::string> codes = {
+      "W06000001", "W06000011", "E06000001", "Z99999999", "A00000000",
+      "W1", "w06000001", "W0600000", "W060000011", "W0600000X", "", "X"
+    };
+
+    THEN( "only the well-formed codes are packed, and each round trips" ) {
+
+      for (auto &code : codes) {
+        BethYw::GssCode key(code);
+        REQUIRE( key.isPacked() == (code.size() == 9 && code[0] >= 'A' && code[0] <= 'Z' &&
+                                    std::all_of(code.begin() + 1, code.end(), ::isdigit)) );
+        REQUIRE( key.toString() == code );
+        REQUIRE( key == BethYw::GssCode(code) );
+      }
+
+    } // THEN
+
+    THEN( "every pair of codes compares the same way as the strings" ) {
+
+      for (auto &lhs : codes) {
+        for (auto &rhs : codes) {
+          REQUIRE( (BethYw::GssCode(lhs) < BethYw::GssCode(rhs)) == (lhs < rhs) );
+          REQUIRE( (BethYw::GssCode(lhs) == BethYw::GssCode(rhs)) == (lhs == rhs) );
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a code that has never been seen" ) {
+
+    THEN( "finding it does not intern it" ) {
+
+      BethYw::GssCode key;
+      REQUIRE_FALSE( BethYw::GssCode::find("never-interned", key) );
+      REQUIRE( BethYw::GssCode::find("W06000099", key) );
+      REQUIRE( key.toString() == "W06000099" );
+
+      Areas areas;
+      REQUIRE( areas.findArea("never-interned") == nullptr );
+
+    } // THEN
+
+  } // GIVEN
+
+}
+
+SCENARIO( "integer keys are radix sorted stably", "[gsscode][sort]" ) {
+
+  GIVEN( "random keys with many duplicates and an unused high byte" ) {
+
+    std::mt19937_64 random(2021);
+    std::vector<uint64_t> keys(5000);
+    for (auto &key : keys) {
+      key = ((random() % 20) << 48) | ((random() % 4) << 32) | (1990 + random() % 30);
+    }
+
+    std::vector<uint32_t> order(keys.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+
+    std::vector<uint32_t> expected = order;
+    std::stable_sort(expected.begin(), expected.end(), [&keys](uint32_t a, uint32_t b) {
+      return keys[a] < keys[b];
+    });
+
+    THEN( "the order is the same as a stable comparison sort" ) {
+
+      BethYw::radixSortOrder(keys, order);
+      REQUIRE( order == expected );
+
+    } // THEN
+
+  } // GIVEN
+
+}
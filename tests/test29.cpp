@@ -0,0 +1,96 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../authorities.h"
+
+SCENARIO( "areas.csv can be replaced by the table embedded at build time", "[authorities]" ) {
+
+  GIVEN( "the areas.csv file the table was generated from" ) {
+
+    std::ifstream file("datasets/areas.csv", std::ios::binary);
+    const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t count = 0;
+    const BethYw::Authority *authorities = BethYw::embeddedAuthorities(count);
+
+    THEN( "the file matches the embedded fingerprint, but a changed file does not" ) {
+
+      REQUIRE( BethYw::matchesEmbeddedAuthorities(contents) );
+      REQUIRE_FALSE( BethYw::matchesEmbeddedAuthorities(contents + "\n") );
+
+      std::string changed = contents;
+      changed[changed.size() - 1] = 'X';
+      REQUIRE_FALSE( BethYw::matchesEmbeddedAuthorities(changed) );
+
+    } // THEN
+
+    THEN( "every authority is found in its own slot, and other codes are not found" ) {
+
+      REQUIRE( count == 22 );
+
+      for (size_t i = 0; i < count; i++) {
+        REQUIRE( BethYw::findAuthority(authorities[i].code) == &authorities[i] );
+      }
+
+      REQUIRE( BethYw::findAuthority("W06000025") == nullptr );
+      REQUIRE( BethYw::findAuthority("E06000001") == nullptr );
+      REQUIRE( BethYw::findAuthority("W1") == nullptr );
+      REQUIRE( std::string(BethYw::findAuthority("W06000001")->cym) == "Ynys Môn" );
+
+    } // THEN
+
+    THEN( "importing the table gives the same Areas as parsing the file, with or without a filter" ) {
+
+      for (auto filter : {StringFilterSet{}, StringFilterSet{"swan", "W06000015", "môn"}}) {
+        Areas parsed;
+        std::istringstream stream(contents);
+        parsed.populateFromAuthorityCodeCSV(stream, BethYw::InputFiles::AREAS.COLS, &filter);
+
+        Areas embedded;
+        embedded.populateFromAuthorities(authorities, count, &filter);
+
+        REQUIRE( embedded.size() == parsed.size() );
+        REQUIRE( embedded.toJSON() == parsed.toJSON() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a dataset without names, imported without areas.csv" ) {
+
+    std::ifstream stream("datasets/complete-popu1009-pop.csv");
+    REQUIRE( stream.is_open() );
+
+    StringFilterSet filter = {"swansea"};
+    Areas areas;
+    areas.populate(stream, BethYw::AuthorityByYearCSV, BethYw::InputFiles::COMPLETE_POP.COLS,
+                   &filter, nullptr, BethYw::YearFilter());
+
+    THEN( "the areas filter matches the names of the authorities in the table" ) {
+
+      REQUIRE( areas.size() == 1 );
+      REQUIRE( areas.getArea("W06000011").getMeasures().size() == 1 );
+
+    } // THEN
+
+  } // GIVEN
+
+}
@@ -0,0 +1,127 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../input.h"
+
+SCENARIO( "a dataset can be split across several files", "[multifile]" ) {
+
+  GIVEN( "file names with version numbers" ) {
+
+    THEN( "they are ordered by the numbers in them, not character by character" ) {
+
+      REQUIRE( InputFile::versionLess("release-2.csv", "release-10.csv") );
+      REQUIRE_FALSE( InputFile::versionLess("release-10.csv", "release-2.csv") );
+      REQUIRE( InputFile::versionLess("pop-2019.csv", "pop-2020.csv") );
+      REQUIRE( InputFile::versionLess("release-2.csv", "release-2a.csv") );
+      REQUIRE( InputFile::versionLess("a.csv", "b.csv") );
+      REQUIRE_FALSE( InputFile::versionLess("release-2.csv", "release-2.csv") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "three releases of a dataset matched by a glob pattern" ) {
+
+    const std::vector<std::string> names = {"test30-release-10.csv", "test30-release-2.csv", "test30-release-9.csv"};
+    const std::vector<std::string> contents = {
+      "AuthorityCode,2019,2020\nW06000011,3,30\n",
+      "AuthorityCode,2018,2019\nW06000011,1,10\nW06000015,5,50\n",
+      "AuthorityCode,2019\nW06000011,2\n"
+    };
+
+    for (size_t i = 0; i < names.size(); i++) {
+      std::ofstream file(names[i], std::ios::binary);
+      file << contents[i];
+    }
+
+    const BethYw::InputFileSource source = {
+      "test30", "Releases", "test30-release-*.csv", BethYw::SourceDataType::AuthorityByYearCSV,
+      {
+        {BethYw::AUTH_CODE,           "AuthorityCode"},
+        {BethYw::SINGLE_MEASURE_CODE, "Rel"},
+        {BethYw::SINGLE_MEASURE_NAME, "Release"}
+      }
+    };
+
+    const std::vector<std::string> files = InputFile::expand(source.FILE);
+
+    THEN( "the pattern expands to every file, in order of precedence" ) {
+
+      REQUIRE( files == std::vector<std::string>{"test30-release-2.csv", "test30-release-9.csv", "test30-release-10.csv"} );
+
+    } // THEN
+
+    THEN( "a path that matches nothing is kept, so opening it reports the usual error" ) {
+
+      REQUIRE( InputFile::expand("test30-missing-*.csv") == std::vector<std::string>{"test30-missing-*.csv"} );
+      REQUIRE( InputFile::expand("datasets/areas.csv") == std::vector<std::string>{"datasets/areas.csv"} );
+
+    } // THEN
+
+    THEN( "importing them in parallel gives the same result as importing them one after another" ) {
+
+      Areas sequential;
+      BethYw::loadAreas(sequential, "datasets/", {});
+
+      for (auto &name : files) {
+        InputFile file(name);
+        sequential.populate(file.open(), source.PARSER, source.COLS, nullptr, nullptr, BethYw::YearFilter());
+      }
+
+      for (unsigned int threads : {1u, 3u}) {
+        Areas parallel;
+        BethYw::loadAreas(parallel, "datasets/", {});
+        BethYw::importDatasetFiles(parallel, files, source, {}, {}, BethYw::YearFilter(), threads);
+
+        REQUIRE( parallel.toJSON() == sequential.toJSON() );
+
+        const Measure &measure = parallel.getArea("W06000011").getMeasure("rel");
+        REQUIRE( measure.getValue(2018) == 1 );
+        REQUIRE( measure.getValue(2019) == 3 );
+        REQUIRE( measure.getValue(2020) == 30 );
+        REQUIRE( parallel.getArea("W06000015").getMeasure("rel").getValue(2019) == 50 );
+        REQUIRE( parallel.getArea("W06000015").getName("eng") == "Cardiff" );
+      }
+
+    } // THEN
+
+    THEN( "an error in one file is reported after the files before it are merged" ) {
+
+      std::vector<std::string> broken = files;
+      broken.insert(broken.begin() + 1, "test30-missing.csv");
+
+      Areas areas;
+      BethYw::loadAreas(areas, "datasets/", {});
+
+      REQUIRE_THROWS_AS( BethYw::importDatasetFiles(areas, broken, source, {}, {}, BethYw::YearFilter()),
+                         std::runtime_error );
+      REQUIRE( areas.getArea("W06000011").getMeasure("rel").getValue(2019) == 10 );
+      REQUIRE( areas.getArea("W06000011").getMeasure("rel").size() == 2 );
+
+    } // THEN
+
+    for (auto &name : names) {
+      std::remove(name.c_str());
+    }
+
+  } // GIVEN
+
+}
@@ -0,0 +1,210 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../tail.h"
+
+namespace {
+
+  void writeFile(const std::string &path, const std::string &contents, const bool append = false) {
+    std::ofstream file(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    file << contents;
+  }
+
+  Areas importFull(const std::string &path, const BethYw::InputFileSource &dataset) {
+    Areas areas;
+    BethYw::loadAreas(areas, "datasets/", {});
+
+    std::ifstream file(path, std::ios::binary);
+    areas.populate(file, dataset.PARSER, dataset.COLS, nullptr, nullptr, BethYw::YearFilter());
+    return areas;
+  }
+
+  Areas importTail(const std::string &path, const BethYw::InputFileSource &dataset, BethYw::TailCache &tail) {
+    Areas areas;
+    BethYw::loadAreas(areas, "datasets/", {});
+    tail.import(areas, path, dataset, {}, {}, BethYw::YearFilter());
+    return areas;
+  }
+
+}
+
+SCENARIO( "rows appended to a data file can be imported without parsing the rest of it", "[tail]" ) {
+
+  const BethYw::InputFileSource csv = {
+    "test31", "Appended", "test31.csv", BethYw::SourceDataType::AuthorityByYearCSV,
+    {
+      {BethYw::AUTH_CODE,           "AuthorityCode"},
+      {BethYw::SINGLE_MEASURE_CODE, "App"},
+      {BethYw::SINGLE_MEASURE_NAME, "Appended"}
+    }
+  };
+
+  const std::string path = "test31.csv";
+  const std::string header = "AuthorityCode,2019,2020\n";
+  const std::string rows = "W06000011,1,2\nW06000015,3,4\n";
+
+  GIVEN( "a CSV file imported through a TailCache" ) {
+
+    writeFile(path, header + rows);
+
+    BethYw::TailCache tail("", "");
+    REQUIRE( importTail(path, csv, tail).toJSON() == importFull(path, csv).toJSON() );
+    REQUIRE( tail.getBytesParsed() == header.size() + rows.size() );
+
+    WHEN( "rows are appended" ) {
+
+      const std::string appended = "W06000011,5,6\nW06000001,7,8";
+      writeFile(path, appended, true);
+
+      THEN( "only the appended rows are parsed, and they take precedence as usual" ) {
+
+        Areas areas = importTail(path, csv, tail);
+        REQUIRE( tail.getBytesParsed() == header.size() + rows.size() + appended.size() );
+        REQUIRE( areas.toJSON() == importFull(path, csv).toJSON() );
+        REQUIRE( areas.getArea("W06000011").getMeasure("app").getValue(2020) == 6 );
+
+        AND_WHEN( "the last line, which was not complete, is completed" ) {
+
+          writeFile(path, "9\n", true);
+
+          THEN( "it is parsed again and replaces the incomplete row" ) {
+
+            Areas completed = importTail(path, csv, tail);
+            REQUIRE( tail.getBytesParsed() == header.size() + rows.size() + appended.size()
+                                              + std::string("W06000001,7,89\n").size() );
+            REQUIRE( completed.getArea("W06000001").getMeasure("app").getValue(2020) == 89 );
+            REQUIRE( completed.toJSON() == importFull(path, csv).toJSON() );
+
+          } // THEN
+
+        } // AND_WHEN
+
+      } // THEN
+
+      THEN( "an import with nothing new only parses the incomplete last line again" ) {
+
+        importTail(path, csv, tail);
+        const uint64_t parsed = tail.getBytesParsed();
+        REQUIRE( importTail(path, csv, tail).toJSON() == importFull(path, csv).toJSON() );
+        REQUIRE( tail.getBytesParsed() == parsed + std::string("W06000001,7,8").size() );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "an earlier row is revised" ) {
+
+      writeFile(path, header + "W06000011,1,20\nW06000015,3,4\nW06000001,7,8\n");
+
+      THEN( "the whole file is parsed again" ) {
+
+        Areas areas = importTail(path, csv, tail);
+        REQUIRE( tail.getBytesParsed() == 2 * (header.size() + rows.size()) + 14 + 1 );
+        REQUIRE( areas.getArea("W06000011").getMeasure("app").getValue(2020) == 20 );
+        REQUIRE( areas.toJSON() == importFull(path, csv).toJSON() );
+
+      } // THEN
+
+    } // WHEN
+
+    std::remove(path.c_str());
+
+  } // GIVEN
+
+  GIVEN( "a TailCache saved to a cache file" ) {
+
+    const std::string cachePath = "test31.cache";
+    writeFile(path, header + rows);
+
+    {
+      BethYw::TailCache tail(cachePath, "key");
+      tail.load();
+      importTail(path, csv, tail);
+      tail.save();
+    }
+
+    writeFile(path, "W06000001,7,8\n", true);
+
+    THEN( "a later run with the same key only parses the appended rows" ) {
+
+      BethYw::TailCache tail(cachePath, "key");
+      tail.load();
+      REQUIRE( tail.size() == 1 );
+
+      Areas areas = importTail(path, csv, tail);
+      REQUIRE( tail.getBytesParsed() == std::string("W06000001,7,8\n").size() );
+      REQUIRE( areas.toJSON() == importFull(path, csv).toJSON() );
+
+    } // THEN
+
+    THEN( "a later run with a different key does not use it" ) {
+
+      BethYw::TailCache tail(cachePath, "other");
+      tail.load();
+      REQUIRE( tail.size() == 0 );
+
+    } // THEN
+
+    std::remove(cachePath.c_str());
+    std::remove(path.c_str());
+
+  } // GIVEN
+
+  GIVEN( "a JSON Lines file that grows by the rows of popu1009.json" ) {
+
+    std::ifstream stream("datasets/popu1009.json");
+    REQUIRE( stream.is_open() );
+
+    nlohmann::json j;
+    stream >> j;
+
+    std::string first;
+    std::string second;
+    for (size_t i = 0; i < j["value"].size(); i++) {
+      (i < j["value"].size() / 2 ? first : second) += j["value"][i].dump() + "\n";
+    }
+
+    const std::string jsonlPath = "test31.jsonl";
+    const BethYw::InputFileSource jsonl = {
+      "test31", "Appended", jsonlPath, BethYw::SourceDataType::WelshStatsJSONL, BethYw::InputFiles::POPDEN.COLS
+    };
+
+    writeFile(jsonlPath, first);
+    BethYw::TailCache tail("", "");
+    importTail(jsonlPath, jsonl, tail);
+
+    writeFile(jsonlPath, second, true);
+
+    THEN( "importing the appended rows gives the same Areas as importing the whole file" ) {
+
+      Areas areas = importTail(jsonlPath, jsonl, tail);
+      REQUIRE( tail.getBytesParsed() == first.size() + second.size() );
+      REQUIRE( areas.toJSON() == importFull(jsonlPath, jsonl).toJSON() );
+
+    } // THEN
+
+    std::remove(jsonlPath.c_str());
+
+  } // GIVEN
+
+}
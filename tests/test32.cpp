@@ -0,0 +1,137 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../tail.h"
+
+SCENARIO( "an import that is stopped part of the way through can be resumed from a checkpoint", "[tail][checkpoint]" ) {
+
+  GIVEN( "a JSON Lines file with a malformed line three quarters of the way through" ) {
+
+    std::ifstream stream("datasets/popu1009.json");
+    REQUIRE( stream.is_open() );
+
+    nlohmann::json j;
+    stream >> j;
+
+    const size_t rows = j["value"].size();
+    std::string before;
+    std::string after;
+    for (size_t i = 0; i < rows; i++) {
+      (i < rows * 3 / 4 ? before : after) += j["value"][i].dump() + "\n";
+    }
+
+    const std::string path = "test32.jsonl";
+    const std::string checkpointPath = "test32.checkpoint";
+    const BethYw::InputFileSource dataset = {
+      "test32", "Resumed", path, BethYw::SourceDataType::WelshStatsJSONL, BethYw::InputFiles::POPDEN.COLS
+    };
+
+    // The malformed line is as long as the first line after it, so fixing it
+    // does not move anything
+    const std::string fixed = after.substr(0, after.find('\n') + 1);
+    const std::string broken = "{" + std::string(fixed.size() - 2, ' ') + "\n";
+
+    {
+      std::ofstream file(path, std::ios::binary);
+      file << before << broken << after;
+    }
+
+    std::remove(checkpointPath.c_str());
+
+    WHEN( "it is imported with checkpoints" ) {
+
+      BethYw::TailCache first(checkpointPath, "key");
+      first.enableCheckpoints(4096);
+
+      Areas stopped;
+      BethYw::loadAreas(stopped, "datasets/", {});
+      REQUIRE_THROWS_AS( first.import(stopped, path, dataset, {}, {}, BethYw::YearFilter()), std::runtime_error );
+
+      THEN( "checkpoints were saved before the error" ) {
+
+        REQUIRE( first.getCheckpointCount() > 0 );
+        REQUIRE( std::ifstream(checkpointPath).is_open() );
+
+      } // THEN
+
+      AND_WHEN( "the line is fixed and the import is resumed" ) {
+
+        {
+          std::ofstream file(path, std::ios::binary);
+          file << before << fixed << after;
+        }
+
+        BethYw::TailCache resumed(checkpointPath, "key");
+        resumed.enableCheckpoints(4096);
+        resumed.load();
+
+        Areas areas;
+        BethYw::loadAreas(areas, "datasets/", {});
+        resumed.import(areas, path, dataset, {}, {}, BethYw::YearFilter());
+
+        THEN( "only the rows after the last checkpoint are parsed again, with the same result as a full import" ) {
+
+          const uint64_t size = before.size() + fixed.size() + after.size();
+          REQUIRE( resumed.getBytesParsed() > 0 );
+          REQUIRE( resumed.getBytesParsed() < size );
+
+          Areas full;
+          BethYw::loadAreas(full, "datasets/", {});
+          std::ifstream file(path, std::ios::binary);
+          full.populate(file, dataset.PARSER, dataset.COLS, nullptr, nullptr, BethYw::YearFilter());
+
+          REQUIRE( areas.toJSON() == full.toJSON() );
+
+        } // THEN
+
+        resumed.discard();
+        REQUIRE_FALSE( std::ifstream(checkpointPath).is_open() );
+
+      } // AND_WHEN
+
+    } // WHEN
+
+    WHEN( "the checkpoint was saved by an import with different arguments" ) {
+
+      BethYw::TailCache first(checkpointPath, "key");
+      first.enableCheckpoints(4096);
+
+      Areas stopped;
+      BethYw::loadAreas(stopped, "datasets/", {});
+      REQUIRE_THROWS( first.import(stopped, path, dataset, {}, {}, BethYw::YearFilter()) );
+
+      THEN( "it is not resumed" ) {
+
+        BethYw::TailCache other(checkpointPath, "other");
+        other.load();
+        REQUIRE( other.size() == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+    std::remove(checkpointPath.c_str());
+    std::remove(path.c_str());
+
+  } // GIVEN
+
+}
@@ -0,0 +1,277 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../rowstream.h"
+#include "../bethyw.h"
+#include "../lib_cxxopts_argv.hpp"
+
+namespace {
+
+// Import text as a dataset
+void importText(Areas &areas, const std::string &text, const BethYw::SourceDataType type,
+                const BethYw::SourceColumnMapping &cols) {
+  std::istringstream stream(text);
+  areas.populate(stream, type, cols, nullptr, nullptr, BethYw::YearFilter());
+}
+
+}
+
+SCENARIO( "pathological input is rejected at the parser limits", "[rowstream][limits]" ) {
+
+  Areas areas;
+  BethYw::ParserLimits limits;
+  limits.maxLineLength = 64 * 1024;
+  limits.maxFieldSize = 1024;
+  limits.maxDepth = 16;
+  limits.maxColumns = 100;
+  areas.setParserLimits(limits);
+
+  const auto &csvCols = BethYw::InputFiles::COMPLETE_POP.COLS;
+  const auto &jsonCols = BethYw::InputFiles::POPDEN.COLS;
+  const std::string header = "AuthorityCode,1991,2001\n";
+
+  const auto start = std::chrono::steady_clock::now();
+
+  THEN( "a CSV line longer than the limit is rejected" ) {
+    const std::string text = header + "W06000001," + std::string(16 * 1024 * 1024, '1') + "\n";
+    REQUIRE_THROWS_AS( importText(areas, text, BethYw::AuthorityByYearCSV, csvCols),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "a CSV field larger than the limit is rejected" ) {
+    const std::string text = header + "W06000001," + std::string(2048, '1') + ",1\n";
+    REQUIRE_THROWS_AS( importText(areas, text, BethYw::AuthorityByYearCSV, csvCols),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "a CSV header with more columns than the limit is rejected" ) {
+    std::string text = "AuthorityCode";
+    for (int i = 0; i < 1000000; i++) {
+      text += ",";
+    }
+
+    REQUIRE_THROWS_AS( importText(areas, text + "\n", BethYw::AuthorityByYearCSV, csvCols),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "an areas.csv line with more columns than the limit is rejected" ) {
+    const std::string text = "Local authority code,Name (eng),Name (cym)\nW06000001" + std::string(1000, ',') + "\n";
+    REQUIRE_THROWS_AS( importText(areas, text, BethYw::AuthorityCodeCSV, BethYw::InputFiles::AREAS.COLS),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "deeply nested JSON is rejected" ) {
+    const std::string text = "{\"value\":" + std::string(1000000, '[') + std::string(1000000, ']') + "}";
+    REQUIRE_THROWS_AS( importText(areas, text, BethYw::WelshStatsJSON, jsonCols),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "a deeply nested JSON line is rejected" ) {
+    const std::string text = std::string(60000, '[') + "\n";
+    REQUIRE_THROWS_AS( importText(areas, text, BethYw::WelshStatsJSONL, jsonCols),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "a JSON Lines line longer than the limit is rejected" ) {
+    const std::string text = "{\"Localauthority_ItemName_ENG\":\"" + std::string(128 * 1024, 'x') + "\"}\n";
+    REQUIRE_THROWS_AS( importText(areas, text, BethYw::WelshStatsJSONL, jsonCols),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "a JSON string larger than the limit is rejected" ) {
+    const std::string text = "{\"value\":[{\"Localauthority_ItemName_ENG\":\"" + std::string(4096, 'x') + "\"}]}";
+    REQUIRE_THROWS_AS( importText(areas, text, BethYw::WelshStatsJSON, jsonCols),
+                       BethYw::ParserLimitError );
+  }
+
+  THEN( "a JSON object with more members than the limit is rejected" ) {
+    std::string text = "{\"value\":[{";
+    for (int i = 0; i < 100000; i++) {
+      text += (i > 0 ? ",\"k" : "\"k") + std::to_string(i) + "\":0";
+    }
+
+    REQUIRE_THROWS_AS( importText(areas, text + "}]}", BethYw::WelshStatsJSON, jsonCols),
+                       BethYw::ParserLimitError );
+  }
+
+  // Every rejection is made as the input is parsed, long before the whole of
+  // it would have been
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE( elapsed.count() < 10.0 );
+
+}
+
+SCENARIO( "a parser limit too large for this machine is rejected", "[limits]" ) {
+
+  for (const std::string limits : {"line=17179869185G", "field=99999999999999999999"}) {
+
+    GIVEN( "the limits argument " + limits ) {
+
+      Argv argv({"test", "--limits", limits.c_str()});
+      auto** actual_argv = argv.argv();
+      auto argc          = argv.argc();
+
+      auto cxxopts = BethYw::cxxoptsSetup();
+      auto args    = cxxopts.parse(argc, actual_argv);
+
+      THEN( "it is an invalid argument" ) {
+
+        REQUIRE_THROWS_AS( BethYw::parseLimitsArg(args), std::invalid_argument );
+
+      } // THEN
+
+    } // GIVEN
+
+  }
+
+  GIVEN( "the largest limit that fits" ) {
+
+    Argv argv({"test", "--limits", "line=17179869183G"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    THEN( "it is accepted" ) {
+
+      REQUIRE( BethYw::parseLimitsArg(args).maxLineLength == (size_t)17179869183ULL * 1024 * 1024 * 1024 );
+
+    } // THEN
+
+  } // GIVEN
+
+}
+
+SCENARIO( "real data files within the default parser limits are still imported", "[rowstream][limits]" ) {
+
+  GIVEN( "the popden dataset" ) {
+
+    std::ifstream stream("datasets/popu1009.json");
+    REQUIRE( stream.is_open() );
+
+    Areas limited;
+    limited.setParserLimits(BethYw::ParserLimits());
+    limited.populate(stream, BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS, nullptr, nullptr, BethYw::YearFilter());
+
+    std::ifstream again("datasets/popu1009.json");
+    Areas unlimited;
+    BethYw::ParserLimits none;
+    none.maxLineLength = SIZE_MAX;
+    none.maxFieldSize = SIZE_MAX;
+    none.maxDepth = SIZE_MAX;
+    none.maxColumns = SIZE_MAX;
+    unlimited.setParserLimits(none);
+    unlimited.populate(again, BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS, nullptr, nullptr, BethYw::YearFilter());
+
+    THEN( "the same data is imported as without limits" ) {
+      REQUIRE( limited.size() > 0 );
+      REQUIRE( limited.toJSON() == unlimited.toJSON() );
+    }
+
+  } // GIVEN
+
+}
+
+SCENARIO( "randomly mutated data files fail cleanly", "[rowstream][limits][fuzz]" ) {
+
+  GIVEN( "the first rows of a CSV and a JSON Lines file" ) {
+
+    std::ifstream csvFile("datasets/complete-popu1009-pop.csv");
+    REQUIRE( csvFile.is_open() );
+    std::string csv;
+    std::string line;
+    for (int i = 0; i < 8 && std::getline(csvFile, line); i++) {
+      csv += line + "\n";
+    }
+
+    std::string jsonl;
+    for (int i = 0; i < 8; i++) {
+      jsonl += "{\"Localauthority_ItemName_ENG\":\"Isle of Anglesey\",\"Localauthority_AltCode1\":\"W06000001\","
+               "\"Measure_Code\":\"DENS\",\"Measure_ItemName_ENG\":\"Population density\","
+               "\"Year_Code\":\"" + std::to_string(2000 + i) + "\",\"Data\":\"" + std::to_string(i * 1.5) + "\"}\n";
+    }
+
+    // The mutations are random, but the same on every run
+    std::mt19937 random(33);
+    const std::string bytes = "[]{}\",:\n\\0123456789eE.-x";
+
+    auto mutate = [&](std::string text) {
+      const int count = std::uniform_int_distribution<int>(1, 8)(random);
+      for (int i = 0; i < count; i++) {
+        const size_t at = std::uniform_int_distribution<size_t>(0, text.size() - 1)(random);
+        const char c = bytes[std::uniform_int_distribution<size_t>(0, bytes.size() - 1)(random)];
+
+        switch (std::uniform_int_distribution<int>(0, 3)(random)) {
+        case 0: text[at] = c; break;
+        case 1: text.insert(at, 1, c); break;
+        case 2: text.erase(at, 1); break;
+        default: text.insert(at, std::string(std::uniform_int_distribution<size_t>(1, 4096)(random), c)); break;
+        }
+      }
+
+      return text;
+    };
+
+    BethYw::ParserLimits limits;
+    limits.maxLineLength = 4096;
+    limits.maxFieldSize = 256;
+    limits.maxDepth = 8;
+    limits.maxColumns = 64;
+
+    WHEN( "each is mutated and imported a thousand times" ) {
+
+      size_t failures = 0;
+      const auto start = std::chrono::steady_clock::now();
+
+      for (int i = 0; i < 1000; i++) {
+        Areas csvAreas;
+        csvAreas.setParserLimits(limits);
+        Areas jsonlAreas;
+        jsonlAreas.setParserLimits(limits);
+
+        try {
+          importText(csvAreas, mutate(csv), BethYw::AuthorityByYearCSV, BethYw::InputFiles::COMPLETE_POP.COLS);
+        } catch (const std::exception &e) {
+          failures++;
+        }
+
+        try {
+          importText(jsonlAreas, mutate(jsonl), BethYw::WelshStatsJSONL, BethYw::InputFiles::POPDEN.COLS);
+        } catch (const std::exception &e) {
+          failures++;
+        }
+      }
+
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+      THEN( "every import either succeeds or throws an exception, in bounded time" ) {
+        REQUIRE( failures > 0 );
+        REQUIRE( failures < 2000 );
+        REQUIRE( elapsed.count() < 30.0 );
+      }
+
+    } // WHEN
+
+  } // GIVEN
+
+}
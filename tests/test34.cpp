@@ -0,0 +1,332 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../versions.h"
+
+namespace {
+
+  Areas importPopden() {
+    Areas areas;
+    BethYw::loadAreas(areas, "datasets/", {});
+
+    std::ifstream file("datasets/popu1009.json");
+    areas.populate(file, BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS,
+                   nullptr, nullptr, BethYw::YearFilter());
+    return areas;
+  }
+
+  Areas reconstruct(const BethYw::VersionStore &store, const std::string &asOf) {
+    Areas areas;
+    store.reconstruct(areas, asOf);
+    return areas;
+  }
+
+  uint64_t fileSize(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return (uint64_t)(std::streamoff)file.tellg();
+  }
+
+}
+
+SCENARIO( "every version of the data imported can be reconstructed from a VersionStore", "[versions]" ) {
+
+  const std::string path = "test34.store";
+  std::remove(path.c_str());
+
+  GIVEN( "a store with the popden dataset recorded as version 1" ) {
+
+    Areas first = importPopden();
+
+    BethYw::VersionStore store(path, "key");
+    store.load();
+    REQUIRE( store.size() == 0 );
+    REQUIRE( store.record(first, "2020-01-15") == 1 );
+
+    const uint64_t firstSize = fileSize(path);
+
+    THEN( "recording the same data again adds no version" ) {
+
+      REQUIRE( store.record(first, "2020-02-15") == 0 );
+      REQUIRE( store.size() == 1 );
+      REQUIRE( fileSize(path) == firstSize );
+
+    } // THEN
+
+    WHEN( "a revision changes a value, removes a measure and renames an area" ) {
+
+      Areas revised = importPopden();
+      revised.getArea("W06000011").getMeasure("dens").setValue(2015, 123.5);
+      revised.getArea("W06000011").setName("eng", "Swansea (revised)");
+
+      Area withoutMeasure("W06000010");
+      for (auto &name : revised.getArea("W06000010").getNames()) {
+        withoutMeasure.setName(name.first, name.second);
+      }
+      for (auto &measure : revised.getArea("W06000010").getMeasures()) {
+        if (measure.first != "area") {
+          withoutMeasure.setMeasure(measure.first, measure.second);
+        }
+      }
+
+      Areas second = revised.emptyCopy();
+      revised.forEachArea([&second, &withoutMeasure](const Area &area) {
+        second.setArea(area.getLocalAuthorityCode(),
+                       area.getLocalAuthorityCode() == "W06000010" ? withoutMeasure : area);
+      });
+
+      REQUIRE( store.record(second, "2021-06-01") == 2 );
+
+      THEN( "only the changes are stored" ) {
+
+        const uint32_t areaValues = (uint32_t)first.getArea("W06000010").getMeasure("area").size();
+        REQUIRE( store.getChangeCount(2) == 2 + areaValues + 1 );
+        REQUIRE( fileSize(path) - firstSize < 1024 );
+
+      } // THEN
+
+      THEN( "each version can be reconstructed by number or date" ) {
+
+        REQUIRE( reconstruct(store, "1").toJSON() == first.toJSON() );
+        REQUIRE( reconstruct(store, "2").toJSON() == second.toJSON() );
+        REQUIRE( reconstruct(store, "2020-01-15").toJSON() == first.toJSON() );
+        REQUIRE( reconstruct(store, "2021-05-31").toJSON() == first.toJSON() );
+        REQUIRE( reconstruct(store, "2022-01-01").toJSON() == second.toJSON() );
+
+        REQUIRE( reconstruct(store, "2").getArea("W06000011").getMeasure("dens").getValue(2015) == 123.5 );
+
+      } // THEN
+
+      THEN( "a version that does not exist is not reconstructed" ) {
+
+        REQUIRE_THROWS_AS( reconstruct(store, "2019-12-31"), std::out_of_range );
+        REQUIRE_THROWS_AS( reconstruct(store, "0"), std::out_of_range );
+        REQUIRE_THROWS_AS( reconstruct(store, "3"), std::out_of_range );
+        REQUIRE_THROWS_AS( reconstruct(store, "latest"), std::invalid_argument );
+
+      } // THEN
+
+      THEN( "the versions are loaded again from the store file" ) {
+
+        BethYw::VersionStore loaded(path, "key");
+        loaded.load();
+        REQUIRE( loaded.size() == 2 );
+        REQUIRE( reconstruct(loaded, "1").toJSON() == first.toJSON() );
+        REQUIRE( reconstruct(loaded, "2").toJSON() == second.toJSON() );
+
+        BethYw::VersionStore other(path, "other");
+        REQUIRE_THROWS_AS( other.load(), std::runtime_error );
+
+      } // THEN
+
+      THEN( "a version that was only partly written is replaced by the next one" ) {
+
+        const uint64_t secondSize = fileSize(path);
+        {
+          std::ofstream file(path, std::ios::binary | std::ios::app);
+          file << std::string(16, '\x03');
+        }
+
+        BethYw::VersionStore loaded(path, "key");
+        loaded.load();
+        REQUIRE( loaded.size() == 2 );
+        REQUIRE( loaded.record(first, "2022-01-01") == 3 );
+        REQUIRE( fileSize(path) > secondSize );
+
+        BethYw::VersionStore reloaded(path, "key");
+        reloaded.load();
+        REQUIRE( reloaded.size() == 3 );
+        REQUIRE( reconstruct(reloaded, "3").toJSON() == first.toJSON() );
+        REQUIRE( reconstruct(reloaded, "2").toJSON() == second.toJSON() );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  std::remove(path.c_str());
+
+}
+
+SCENARIO( "a VersionStore reconstructs a version from the keyframe before it", "[versions]" ) {
+
+  const std::string path = "test34-keyframes.store";
+  std::remove(path.c_str());
+
+  GIVEN( "a store with more versions than the keyframe interval, each changing one value" ) {
+
+    BethYw::VersionStore store(path, "key");
+    store.load();
+
+    const uint32_t count = BethYw::VERSION_KEYFRAME_INTERVAL + 4;
+    std::vector<std::string> expected;
+
+    for (uint32_t i = 1; i <= count; i++) {
+      Areas areas = importPopden();
+      areas.getArea("W06000011").getMeasure("dens").setValue(2015, i);
+      REQUIRE( store.record(areas, "2020-01-15") == i );
+      expected.push_back(areas.toJSON());
+    }
+
+    THEN( "a keyframe is stored every interval, counting only its changes" ) {
+
+      REQUIRE( store.isKeyframe(1) );
+      REQUIRE_FALSE( store.isKeyframe(2) );
+      REQUIRE_FALSE( store.isKeyframe(BethYw::VERSION_KEYFRAME_INTERVAL) );
+      REQUIRE( store.isKeyframe(BethYw::VERSION_KEYFRAME_INTERVAL + 1) );
+      REQUIRE( store.getChangeCount(BethYw::VERSION_KEYFRAME_INTERVAL + 1) == 1 );
+      REQUIRE_THROWS_AS( store.isKeyframe(count + 1), std::out_of_range );
+
+    } // THEN
+
+    THEN( "every version is reconstructed" ) {
+
+      for (uint32_t i = 1; i <= count; i++) {
+        REQUIRE( reconstruct(store, std::to_string(i)).toJSON() == expected[i - 1] );
+      }
+
+    } // THEN
+
+    THEN( "versions after a keyframe are reconstructed without reading the versions before it" ) {
+
+      // Overwrite the records of version 1, which start after the store
+      // header (format version and key) and the header of version 1
+      const std::streamoff records = 4 + 4 + 3 + 4 + 4 + 10 + 1 + 4 + 4 + 8;
+      {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(records);
+        file << std::string(16, '\xff');
+      }
+
+      REQUIRE_THROWS_AS( reconstruct(store, "1"), std::runtime_error );
+
+      for (uint32_t i = BethYw::VERSION_KEYFRAME_INTERVAL + 1; i <= count; i++) {
+        REQUIRE( reconstruct(store, std::to_string(i)).toJSON() == expected[i - 1] );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  std::remove(path.c_str());
+
+}
+
+SCENARIO( "runs recording into the same VersionStore each append a version", "[versions]" ) {
+
+  const std::string path = "test34-shared.store";
+  std::remove(path.c_str());
+
+  GIVEN( "two stores loaded before either has recorded a version" ) {
+
+    BethYw::VersionStore one(path, "key");
+    BethYw::VersionStore two(path, "key");
+    one.load();
+    two.load();
+
+    Areas first = importPopden();
+    Areas second = importPopden();
+    second.getArea("W06000011").getMeasure("dens").setValue(2015, 123.5);
+
+    THEN( "the second to record appends after the version recorded by the first" ) {
+
+      REQUIRE( one.record(first, "2020-01-15") == 1 );
+      REQUIRE( two.record(second, "2020-01-16") == 2 );
+      REQUIRE( two.record(first, "2020-01-17") == 3 );
+      REQUIRE( one.record(first, "2020-01-18") == 0 );
+
+      BethYw::VersionStore loaded(path, "key");
+      loaded.load();
+      REQUIRE( loaded.size() == 3 );
+      REQUIRE( reconstruct(loaded, "1").toJSON() == first.toJSON() );
+      REQUIRE( reconstruct(loaded, "2").toJSON() == second.toJSON() );
+      REQUIRE( reconstruct(loaded, "3").toJSON() == first.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+#ifndef _WIN32
+  GIVEN( "several processes recording different data into the store at once" ) {
+
+    const int processes = 4;
+    std::vector<pid_t> children;
+
+    for (int i = 0; i < processes; i++) {
+      const pid_t child = fork();
+
+      if (child == 0) {
+        int status = 1;
+
+        try {
+          Areas areas = importPopden();
+          areas.getArea("W06000011").getMeasure("dens").setValue(2015, i);
+
+          BethYw::VersionStore store(path, "key");
+          store.load();
+          status = store.record(areas, "2020-01-15") > 0 ? 0 : 1;
+        } catch (...) {
+        }
+
+        _exit(status);
+      }
+
+      REQUIRE( child > 0 );
+      children.push_back(child);
+    }
+
+    for (const pid_t child : children) {
+      int status = 0;
+      REQUIRE( waitpid(child, &status, 0) == child );
+      REQUIRE( WIFEXITED(status) );
+      REQUIRE( WEXITSTATUS(status) == 0 );
+    }
+
+    THEN( "every process appended a complete version of its own" ) {
+
+      BethYw::VersionStore loaded(path, "key");
+      loaded.load();
+      REQUIRE( loaded.size() == processes );
+
+      std::vector<bool> found(processes, false);
+
+      for (int version = 1; version <= processes; version++) {
+        const double value = reconstruct(loaded, std::to_string(version))
+                               .getArea("W06000011").getMeasure("dens").getValue(2015);
+        REQUIRE( value >= 0 );
+        REQUIRE( value < processes );
+        REQUIRE_FALSE( found[(size_t)value] );
+        found[(size_t)value] = true;
+      }
+
+    } // THEN
+
+  } // GIVEN
+#endif
+
+  std::remove(path.c_str());
+
+}
@@ -0,0 +1,122 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../datasets.h"
+#include "../shm.h"
+
+#ifndef _WIN32
+SCENARIO( "a shared segment abandoned by a publisher that died is replaced", "[shm]" ) {
+
+  const std::string name = BethYw::sharedSegmentName("test35-" + std::to_string(getpid()));
+  shm_unlink(name.c_str());
+
+  Areas areas;
+  Area area("W06000011");
+  area.setName("eng", "Swansea");
+  areas.setArea("W06000011", area);
+
+  for (const size_t size : {(size_t)0, (size_t)4096}) {
+
+    GIVEN( "a segment of " + std::to_string(size) + " bytes created without a writer" ) {
+
+      const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+      REQUIRE( fd >= 0 );
+      REQUIRE( ftruncate(fd, size) == 0 );
+      close(fd);
+
+      THEN( "it is left alone while its writer may still be starting" ) {
+
+        REQUIRE_FALSE( BethYw::removeAbandonedSegment(name) );
+        REQUIRE_FALSE( BethYw::publishSharedAreas(areas, name, 1) );
+
+      } // THEN
+
+      THEN( "it is removed once it has been without a writer for too long, and can be published again" ) {
+
+        REQUIRE( BethYw::removeAbandonedSegment(name, 0) );
+        REQUIRE( BethYw::publishSharedAreas(areas, name, 1) );
+
+        Areas attached;
+        REQUIRE( BethYw::attachSharedAreas(attached, name, 1) );
+        REQUIRE( attached.toJSON() == areas.toJSON() );
+
+        REQUIRE_FALSE( BethYw::removeAbandonedSegment(name, 0) );
+
+      } // THEN
+
+      shm_unlink(name.c_str());
+
+    } // GIVEN
+
+  }
+
+} // SCENARIO
+#endif
+
+#ifndef _WIN32
+SCENARIO( "Areas published to a shared segment are attached unchanged", "[shm]" ) {
+
+  const std::string name = BethYw::sharedSegmentName("test35-parity-" + std::to_string(getpid()));
+  shm_unlink(name.c_str());
+
+  GIVEN( "the Areas imported from every dataset, published to a segment" ) {
+
+    Areas areas;
+    const std::vector<BethYw::InputFileSource> datasets(
+      BethYw::InputFiles::DATASETS, BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+    BethYw::importDatasets(areas, "datasets/", datasets, StringFilterSet(), StringFilterSet(), BethYw::YearFilter());
+    REQUIRE( areas.size() > 0 );
+
+    REQUIRE( BethYw::publishSharedAreas(areas, name, 42) );
+
+    THEN( "attaching with the same fingerprint reads back the same table and JSON output" ) {
+
+      Areas attached;
+      REQUIRE( BethYw::attachSharedAreas(attached, name, 42) );
+      REQUIRE( attached.size() == areas.size() );
+      REQUIRE( attached.toJSON() == areas.toJSON() );
+
+      std::ostringstream expected, actual;
+      expected << areas;
+      actual << attached;
+      REQUIRE( actual.str() == expected.str() );
+
+    } // THEN
+
+    THEN( "attaching with a different fingerprint reads nothing and unlinks the stale segment" ) {
+
+      Areas attached;
+      REQUIRE_FALSE( BethYw::attachSharedAreas(attached, name, 43) );
+      REQUIRE( attached.size() == 0 );
+      REQUIRE( shm_open(name.c_str(), O_RDONLY, 0) < 0 );
+
+    } // THEN
+
+    shm_unlink(name.c_str());
+
+  } // GIVEN
+
+} // SCENARIO
+#endif
@@ -0,0 +1,207 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../shards.h"
+
+SCENARIO( "local authority codes are split into contiguous shards", "[shards]" ) {
+
+  GIVEN( "the areas in areas.csv" ) {
+
+    Areas codes;
+    BethYw::loadAreas(codes, "datasets/", StringFilterSet());
+
+    std::vector<std::string> all;
+    codes.forEachArea([&all](const Area &area) {
+      all.push_back(area.getLocalAuthorityCode());
+    });
+
+    THEN( "the boundaries split the codes into ranges of roughly equal size" ) {
+
+      const auto boundaries = BethYw::shardBoundaries(codes, 4);
+      REQUIRE( boundaries.size() == 3 );
+
+      std::vector<size_t> sizes(4, 0);
+      for (auto &code : all) {
+        size_t shard = 0;
+        while (shard < boundaries.size() && code >= boundaries[shard]) {
+          shard++;
+        }
+        sizes[shard]++;
+      }
+
+      for (size_t i = 0; i < sizes.size(); i++) {
+        REQUIRE( sizes[i] >= all.size() / 4 );
+        REQUIRE( sizes[i] <= all.size() / 4 + 1 );
+      }
+
+    } // THEN
+
+    THEN( "each code is in exactly one shard" ) {
+
+      const auto boundaries = BethYw::shardBoundaries(codes, 3);
+
+      std::vector<std::string> sharded;
+
+      for (size_t i = 0; i <= boundaries.size(); i++) {
+        Areas shard;
+        shard.setShard(i > 0 ? boundaries[i - 1] : "", i < boundaries.size() ? boundaries[i] : "");
+        BethYw::loadAreas(shard, "datasets/", StringFilterSet());
+
+        REQUIRE( shard.size() > 0 );
+        shard.forEachArea([&sharded](const Area &area) {
+          sharded.push_back(area.getLocalAuthorityCode());
+        });
+      }
+
+      REQUIRE( sharded == all );
+
+    } // THEN
+
+    THEN( "there are no more boundaries than codes" ) {
+
+      REQUIRE( BethYw::shardBoundaries(codes, 1000).size() == all.size() - 1 );
+      REQUIRE( BethYw::shardBoundaries(Areas(), 4).empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+}
+
+#ifndef _WIN32
+namespace {
+
+// Run the shards, returning what they write to the standard output
+std::string runShards(const std::vector<std::string> &boundaries,
+                      const std::function<void(Areas &)> &load, const bool json, int &exitCode) {
+  std::stringstream captured;
+  std::streambuf *original = std::cout.rdbuf(captured.rdbuf());
+  exitCode = BethYw::runShards(boundaries, load, json);
+  std::cout.rdbuf(original);
+  return captured.str();
+}
+
+}
+
+SCENARIO( "sharded output is the same as the output of a single process", "[shards]" ) {
+
+  GIVEN( "the popden dataset" ) {
+
+    const std::vector<BethYw::InputFileSource> datasets = {BethYw::InputFiles::POPDEN};
+    auto load = [&datasets](Areas &areas) {
+      BethYw::importDatasets(areas, "datasets/", datasets, StringFilterSet(), StringFilterSet(),
+                             BethYw::YearFilter());
+    };
+
+    Areas single;
+    load(single);
+
+    std::stringstream table;
+    table << single << std::endl;
+    std::stringstream json;
+    single.writeJSON(json);
+    json << std::endl;
+
+    Areas codes;
+    BethYw::loadAreas(codes, "datasets/", StringFilterSet());
+
+    for (unsigned int shards : {2, 4, 7}) {
+
+      WHEN( "it is imported across " + std::to_string(shards) + " processes" ) {
+
+        const auto boundaries = BethYw::shardBoundaries(codes, shards);
+        int tableExit = 1;
+        int jsonExit = 1;
+        const std::string shardedTable = runShards(boundaries, load, false, tableExit);
+        const std::string shardedJSON = runShards(boundaries, load, true, jsonExit);
+
+        THEN( "the table and JSON output are identical" ) {
+
+          REQUIRE( tableExit == 0 );
+          REQUIRE( jsonExit == 0 );
+          REQUIRE( shardedTable == table.str() );
+          REQUIRE( shardedJSON == json.str() );
+
+        } // THEN
+
+      } // WHEN
+
+    }
+
+    WHEN( "each shard spills to run files" ) {
+
+      char dir[] = "/tmp/bethyw-test36-XXXXXX";
+      REQUIRE( mkdtemp(dir) != nullptr );
+
+      auto spilling = [&](Areas &areas) {
+        areas.setMemoryLimit(1024, std::string(dir) + "/");
+        load(areas);
+      };
+
+      int exitCode = 1;
+      const std::string sharded = runShards(BethYw::shardBoundaries(codes, 4), spilling, false, exitCode);
+
+      size_t left = 0;
+      DIR *listing = opendir(dir);
+      REQUIRE( listing != nullptr );
+      while (struct dirent *entry = readdir(listing)) {
+        left += std::string(entry->d_name) != "." && std::string(entry->d_name) != ".." ? 1 : 0;
+      }
+      closedir(listing);
+      rmdir(dir);
+
+      THEN( "the output is the same and every run file is removed" ) {
+
+        REQUIRE( exitCode == 0 );
+        REQUIRE( sharded == table.str() );
+        REQUIRE( left == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a shard throws an exception" ) {
+
+      auto failing = [](Areas &areas) {
+        throw std::runtime_error("failed");
+      };
+
+      int exitCode = 0;
+      runShards(BethYw::shardBoundaries(codes, 2), failing, false, exitCode);
+
+      THEN( "the exit code reports the failure" ) {
+
+        REQUIRE( exitCode == 1 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+}
+#endif
@@ -0,0 +1,183 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 991368
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../libbethyw.h"
+
+SCENARIO( "the C interface lends the data imported as arrays", "[libbethyw]" ) {
+
+  GIVEN( "a handle with the popden dataset loaded" ) {
+
+    bethyw_handle *handle = bethyw_open("datasets");
+    REQUIRE( handle != nullptr );
+    REQUIRE( bethyw_abi_version() == BETHYW_ABI_VERSION );
+    REQUIRE( bethyw_load(handle, "popden", nullptr, nullptr, nullptr) == 0 );
+    REQUIRE( std::string(bethyw_last_error(handle)).empty() );
+
+    Areas areas;
+    const std::vector<BethYw::InputFileSource> datasets = {BethYw::InputFiles::POPDEN};
+    BethYw::importDatasets(areas, "datasets/", datasets, StringFilterSet(), StringFilterSet(), BethYw::YearFilter());
+
+    THEN( "the borrowed years and values are the same as the Areas imported" ) {
+
+      REQUIRE( bethyw_area_count(handle) == areas.size() );
+
+      size_t index = 0;
+      areas.forEachArea([&](const Area &area) {
+        const std::string code = area.getLocalAuthorityCode();
+        REQUIRE( bethyw_area_code(handle, index++) == code );
+        REQUIRE( bethyw_area_name(handle, code.c_str(), "eng") == area.getName("eng") );
+        REQUIRE( bethyw_measure_count(handle, code.c_str()) == area.getMeasures().size() );
+
+        for (auto &measure : area.getMeasures()) {
+          const unsigned int *years = nullptr;
+          const double *values = nullptr;
+          size_t length = 0;
+
+          REQUIRE( bethyw_series(handle, code.c_str(), measure.first.c_str(), &years, &values, &length) == 0 );
+          REQUIRE( bethyw_measure_label(handle, code.c_str(), measure.first.c_str()) == measure.second.getLabel() );
+          REQUIRE( length == measure.second.size() );
+
+          size_t i = 0;
+          for (auto &value : measure.second.getValues()) {
+            REQUIRE( years[i] == value.first );
+            REQUIRE( values[i] == value.second );
+            i++;
+          }
+        }
+      });
+
+      REQUIRE( bethyw_area_code(handle, index) == nullptr );
+
+    } // THEN
+
+    THEN( "areas, measures and languages are found in any case" ) {
+
+      const unsigned int *years = nullptr;
+      const double *values = nullptr;
+      size_t length = 0;
+
+      REQUIRE( bethyw_series(handle, "w06000011", "POP", &years, &values, &length) == 0 );
+      REQUIRE( length > 0 );
+      REQUIRE( std::string(bethyw_area_name(handle, "w06000011", "ENG")) == "Swansea" );
+
+      const char *codes[3];
+      double distances[3];
+      REQUIRE( bethyw_similar(handle, "w06000011", 0, 3, codes, distances, &length) == 0 );
+      REQUIRE( length == 3 );
+      REQUIRE( std::string(codes[0]).substr(0, 3) == "W06" );
+      REQUIRE( distances[0] <= distances[1] );
+
+    } // THEN
+
+    THEN( "errors are reported through bethyw_last_error" ) {
+
+      const unsigned int *years = nullptr;
+      const double *values = nullptr;
+      size_t length = 0;
+
+      REQUIRE( bethyw_series(handle, "W9", "pop", &years, &values, &length) == -1 );
+      REQUIRE( std::string(bethyw_last_error(handle)) == "No area found matching W9" );
+
+      REQUIRE( bethyw_series(handle, "W06000011", "nope", &years, &values, &length) == -1 );
+      REQUIRE( std::string(bethyw_last_error(handle)) == "No measure found matching nope" );
+
+      REQUIRE( bethyw_load(handle, "nope", nullptr, nullptr, nullptr) == -1 );
+      REQUIRE( !std::string(bethyw_last_error(handle)).empty() );
+      REQUIRE( bethyw_area_count(handle) == 0 );
+
+      REQUIRE( bethyw_refresh(handle) == -1 );
+      REQUIRE( std::string(bethyw_last_error(handle)) == "Nothing has been loaded to refresh" );
+
+    } // THEN
+
+    bethyw_close(handle);
+
+  } // GIVEN
+
+}
+
+#ifndef _WIN32
+SCENARIO( "the C interface can refresh the data after rows are appended", "[libbethyw]" ) {
+
+  GIVEN( "a handle with a CSV dataset loaded from a directory of its own" ) {
+
+    char dir[] = "/tmp/bethyw-test37-XXXXXX";
+    REQUIRE( mkdtemp(dir) != nullptr );
+    const std::string areasPath = std::string(dir) + "/areas.csv";
+    const std::string csvPath = std::string(dir) + "/" + BethYw::InputFiles::COMPLETE_POP.FILE;
+
+    {
+      std::ifstream areasIn("datasets/areas.csv", std::ios::binary);
+      std::ofstream areasOut(areasPath, std::ios::binary);
+      areasOut << areasIn.rdbuf();
+
+      std::ifstream csvIn("datasets/" + BethYw::InputFiles::COMPLETE_POP.FILE, std::ios::binary);
+      std::ofstream csvOut(csvPath, std::ios::binary);
+      csvOut << csvIn.rdbuf() << "\n";
+    }
+
+    bethyw_handle *handle = bethyw_open(dir);
+    REQUIRE( bethyw_load(handle, "complete-pop", nullptr, nullptr, nullptr) == 0 );
+
+    const unsigned int *years = nullptr;
+    const double *values = nullptr;
+    size_t length = 0;
+
+    REQUIRE( bethyw_series(handle, "W06000001", "pop", &years, &values, &length) == 0 );
+    REQUIRE( values[0] == 69123 );
+
+    WHEN( "a row is appended to the file and the handle is refreshed" ) {
+
+      {
+        std::ofstream csvOut(csvPath, std::ios::binary | std::ios::app);
+        csvOut << "W06000001,1,2,3,4,5,6,7,8,9,10,11\n";
+      }
+
+      REQUIRE( bethyw_refresh(handle) == 0 );
+
+      THEN( "the appended row replaces the values of the area" ) {
+
+        REQUIRE( bethyw_series(handle, "W06000001", "pop", &years, &values, &length) == 0 );
+        REQUIRE( length == 11 );
+        REQUIRE( values[0] == 1 );
+        REQUIRE( values[10] == 11 );
+
+        REQUIRE( bethyw_series(handle, "W06000002", "pop", &years, &values, &length) == 0 );
+        REQUIRE( values[0] == 115007 );
+
+      } // THEN
+
+    } // WHEN
+
+    bethyw_close(handle);
+    std::remove(areasPath.c_str());
+    std::remove(csvPath.c_str());
+    rmdir(dir);
+
+  } // GIVEN
+
+}
+#endif
@@ -0,0 +1,717 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the VersionStore class for
+    keeping every version of the data imported (see versions.h).
+
+    A store file is written as:
+
+        u32      format version
+        string   key of the import (see sharedSegmentKey())
+
+    followed by each version, appended as it is recorded:
+
+        u32      version number, counting from 1
+        string   date recorded (YYYY-MM-DD)
+        u8       1 if the version is a keyframe, holding the whole data,
+                 0 if it holds the changes from the version before it
+        u32      number of keys added, changed or removed since the version
+                 before it
+        u32      number of records
+        u64      bytes of the records, followed by the records:
+                     u8      type of key (area, name, measure or value)
+                     u8      1 if the key was added or changed, 0 if removed
+                     string  local authority code
+                     string  language of a name, or codename of a measure
+                     u32     year of a value
+                     string  name or label, or 8 bytes for a value, if the
+                             key was added or changed
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include "versions.h"
+#include "store.h"
+
+namespace
+{
+    enum KeyType : uint8_t
+    {
+        AreaKey = 0,
+        NameKey = 1,
+        MeasureKey = 2,
+        ValueKey = 3
+    };
+
+    // Ordered so an area comes before its names and measures, and a measure
+    // before its values
+    using Key = std::tuple<std::string, uint8_t, std::string, uint32_t>;
+
+    struct Entry
+    {
+        std::string text;
+        double value = 0;
+
+        bool operator==(const Entry &other) const noexcept
+        {
+            // Compared bit for bit, so NaN is unchanged and -0 is a change
+            return text == other.text && std::memcmp(&value, &other.value, sizeof(value)) == 0;
+        }
+    };
+
+    // Every key of a version of the data, with its name, label or value
+    using Flat = std::map<Key, Entry>;
+
+    /*
+        Flatten Areas to the keys of its areas, names, measures and values.
+    */
+    Flat flatten(const Areas &areas)
+    {
+        Flat flat;
+
+        areas.forEachArea([&flat](const Area &area) {
+            const std::string code = area.getLocalAuthorityCode();
+            flat[Key(code, AreaKey, "", 0)];
+
+            for (auto &name : area.getNames())
+            {
+                flat[Key(code, NameKey, name.first, 0)].text = name.second;
+            }
+
+            for (auto &measure : area.getMeasures())
+            {
+                flat[Key(code, MeasureKey, measure.first, 0)].text = measure.second.getLabel();
+
+                for (auto &value : measure.second.getValues())
+                {
+                    flat[Key(code, ValueKey, measure.first, value.first)].value = value.second;
+                }
+            }
+        });
+
+        return flat;
+    }
+
+    /*
+        Rebuild the Areas of a version from its keys, which are in the order
+        each Area needs them.
+    */
+    void unflatten(const Flat &flat, Areas &areas)
+    {
+        auto it = flat.begin();
+
+        while (it != flat.end())
+        {
+            const std::string &code = std::get<0>(it->first);
+            Area area(code);
+
+            for (; it != flat.end() && std::get<0>(it->first) == code; ++it)
+            {
+                switch (std::get<1>(it->first))
+                {
+                case NameKey:
+                    area.setName(std::get<2>(it->first), it->second.text);
+                    break;
+
+                case MeasureKey:
+                    area.emplaceMeasure(std::get<2>(it->first), it->second.text);
+                    break;
+
+                case ValueKey:
+                    area.getMeasure(std::get<2>(it->first)).setValue(std::get<3>(it->first), it->second.value);
+                    break;
+                }
+            }
+
+            areas.setArea(code, area);
+        }
+    }
+
+    /*
+        An exclusive lock on a store file, held from opening (which creates
+        the file if it is missing) until destruction. The lock is advisory,
+        so it only keeps out other runs recording into the store. On Windows
+        the file is opened but not locked.
+    */
+    class StoreLock
+    {
+    private:
+        const std::string path;
+        int fd;
+
+    public:
+        explicit StoreLock(const std::string &path) : path(path)
+        {
+#ifdef _WIN32
+            fd = _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+            fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+#endif
+
+            if (fd < 0)
+            {
+                throw std::runtime_error("VersionStore::record: Failed to open file " + path);
+            }
+
+#ifndef _WIN32
+            int locked;
+
+            do
+            {
+                locked = flock(fd, LOCK_EX);
+            } while (locked != 0 && errno == EINTR);
+
+            if (locked != 0)
+            {
+                close(fd);
+                throw std::runtime_error("VersionStore::record: Failed to lock file " + path);
+            }
+#endif
+        }
+
+        StoreLock(const StoreLock &other) = delete;
+        StoreLock &operator=(const StoreLock &other) = delete;
+
+        ~StoreLock()
+        {
+#ifdef _WIN32
+            _close(fd);
+#else
+            // Closing the file releases the lock
+            close(fd);
+#endif
+        }
+
+        /*
+            Cut the file to a size, dropping anything written after it.
+        */
+        void truncate(const uint64_t size)
+        {
+#ifdef _WIN32
+            const bool cut = _chsize_s(fd, (__int64)size) == 0;
+#else
+            const bool cut = ftruncate(fd, (off_t)size) == 0;
+#endif
+
+            if (!cut)
+            {
+                throw std::runtime_error("VersionStore::record: Failed to write file " + path);
+            }
+        }
+    };
+
+    void writeRecord(std::ostream &os, const Key &key, const Entry *const entry)
+    {
+        os.put((char)std::get<1>(key));
+        os.put(entry != nullptr ? 1 : 0);
+        BethYw::writeString(os, std::get<0>(key));
+        BethYw::writeString(os, std::get<2>(key));
+        BethYw::writeU32(os, std::get<3>(key));
+
+        if (entry == nullptr || std::get<1>(key) == AreaKey)
+        {
+            return;
+        }
+
+        if (std::get<1>(key) == ValueKey)
+        {
+            os.write(reinterpret_cast<const char *>(&entry->value), sizeof(entry->value));
+        }
+        else
+        {
+            BethYw::writeString(os, entry->text);
+        }
+    }
+
+    void applyRecord(std::istream &is, Flat &flat)
+    {
+        const int type = is.get();
+        const int set = is.get();
+
+        if (!is || type > ValueKey)
+        {
+            throw std::runtime_error("Malformed store!");
+        }
+
+        std::string code = BethYw::readString(is);
+        std::string sub = BethYw::readString(is);
+        const uint32_t year = BethYw::readU32(is);
+        const Key key(std::move(code), (uint8_t)type, std::move(sub), year);
+
+        if (!set)
+        {
+            flat.erase(key);
+            return;
+        }
+
+        Entry &entry = flat[key];
+
+        if (type == ValueKey)
+        {
+            if (!is.read(reinterpret_cast<char *>(&entry.value), sizeof(entry.value)))
+            {
+                throw std::runtime_error("Malformed store!");
+            }
+        }
+        else if (type != AreaKey)
+        {
+            entry.text = BethYw::readString(is);
+        }
+    }
+}
+
+/*
+    Construct a VersionStore for a store file, which is not read until
+    load() is called.
+
+    @param path
+        The store file
+
+    @param key
+        The key of the import (see sharedSegmentKey()), so versions of a
+        different import are not mixed into the store
+*/
+BethYw::VersionStore::VersionStore(const std::string &path, const std::string &key)
+    : path(path), key(key)
+{
+}
+
+/*
+    Read the headers of the versions in the store file, skipping over their
+    records. A missing file is an empty store. A version at the end of the
+    file that was only partly written, e.g. by a run that was stopped, is
+    dropped, and replaced by the next version recorded.
+
+    @return
+        void
+
+    @throws
+        std::runtime_error if the file was recorded for a different import
+        or is not a store file
+*/
+void BethYw::VersionStore::load()
+{
+    versions.clear();
+    validSize = 0;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    const uint64_t size = (uint64_t)(std::streamoff)file.tellg();
+    file.seekg(0);
+
+    if (size == 0)
+    {
+        return;
+    }
+
+    std::string storeKey;
+
+    try
+    {
+        if (readU32(file) != VERSION_STORE_FORMAT_VERSION)
+        {
+            throw std::runtime_error("Malformed store!");
+        }
+
+        storeKey = readString(file);
+    }
+    catch(const std::runtime_error& e)
+    {
+        throw std::runtime_error("VersionStore::load: " + path + " is not a version store");
+    }
+
+    if (storeKey != key)
+    {
+        throw std::runtime_error("VersionStore::load: " + path + " was recorded for a different import");
+    }
+
+    validSize = (uint64_t)(std::streamoff)file.tellg();
+
+    try
+    {
+        while ((uint64_t)(std::streamoff)file.tellg() < size)
+        {
+            Version version;
+            version.number = readU32(file);
+            version.date = readString(file);
+            const int keyframe = file.get();
+            version.keyframe = keyframe == 1;
+            version.changes = readU32(file);
+            version.records = readU32(file);
+            version.length = readU64(file);
+            version.offset = (uint64_t)(std::streamoff)file.tellg();
+
+            if (version.number != versions.size() + 1 || (keyframe != 0 && keyframe != 1)
+                || (version.number == 1 && !version.keyframe) || version.length > size - version.offset)
+            {
+                break;
+            }
+
+            file.seekg((std::streamoff)(version.offset + version.length));
+            versions.push_back(version);
+            validSize = version.offset + version.length;
+        }
+    }
+    catch(const std::runtime_error& e)
+    {
+        // The last version was only partly written
+    }
+}
+
+/*
+    Record the data imported as a new version, if it differs from the latest
+    version, by appending the changes from the latest version to the store
+    file, or the whole data if the version is a keyframe (see versions.h).
+
+    The store file is locked while it is recorded into, and its versions are
+    loaded again under the lock, so a version that another run recorded
+    since load() is compared with rather than written over.
+
+    @param areas
+        The data imported
+
+    @param date
+        The date the data was imported (YYYY-MM-DD), for finding the version
+        as of a date (see reconstruct())
+
+    @return
+        The number of the new version, or 0 if the data is the same as the
+        latest version, so nothing was recorded
+
+    @throws
+        std::runtime_error if the store file cannot be read, written or
+        locked, or was recorded for a different import
+*/
+const uint32_t BethYw::VersionStore::record(const Areas &areas, const std::string &date)
+{
+    StoreLock lock(path);
+    load();
+
+    Flat previous;
+
+    if (!versions.empty())
+    {
+        Areas latest;
+        reconstruct(latest, std::to_string(versions.back().number));
+        previous = flatten(latest);
+    }
+
+    const Flat current = flatten(areas);
+
+    // Walk both versions in order of key, recording each key added, changed
+    // or removed
+    std::ostringstream changes;
+    uint32_t count = 0;
+
+    auto change = [&changes, &count](const Key &key, const Entry *const entry) {
+        writeRecord(changes, key, entry);
+        count++;
+    };
+
+    auto before = previous.begin();
+    auto after = current.begin();
+
+    while (before != previous.end() || after != current.end())
+    {
+        if (after == current.end() || (before != previous.end() && before->first < after->first))
+        {
+            change(before->first, nullptr);
+            ++before;
+        }
+        else if (before == previous.end() || after->first < before->first)
+        {
+            change(after->first, &after->second);
+            ++after;
+        }
+        else
+        {
+            if (!(before->second == after->second))
+            {
+                change(after->first, &after->second);
+            }
+
+            ++before;
+            ++after;
+        }
+    }
+
+    if (count == 0 && !versions.empty())
+    {
+        return 0;
+    }
+
+    Version version;
+    version.number = (uint32_t)versions.size() + 1;
+    version.date = date;
+    version.keyframe = (version.number - 1) % VERSION_KEYFRAME_INTERVAL == 0;
+    version.changes = count;
+    version.records = count;
+
+    std::string body = changes.str();
+
+    if (version.keyframe)
+    {
+        std::ostringstream whole;
+
+        for (auto &entry : current)
+        {
+            writeRecord(whole, entry.first, &entry.second);
+        }
+
+        body = whole.str();
+        version.records = (uint32_t)current.size();
+    }
+
+    version.length = body.size();
+
+    // Drop a version that was only partly written after the last complete
+    // one (or anything in a store without one) and append the version
+    lock.truncate(validSize);
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("VersionStore::record: Failed to open file " + path);
+    }
+
+    if (validSize == 0)
+    {
+        writeU32(file, VERSION_STORE_FORMAT_VERSION);
+        writeString(file, key);
+        validSize = sizeof(uint32_t) * 2 + key.size();
+    }
+
+    writeU32(file, version.number);
+    writeString(file, version.date);
+    file.put(version.keyframe ? 1 : 0);
+    writeU32(file, version.changes);
+    writeU32(file, version.records);
+    writeU64(file, version.length);
+    version.offset = validSize + sizeof(uint32_t) * 4 + version.date.size() + sizeof(uint8_t)
+                     + sizeof(uint64_t);
+    file.write(body.data(), body.size());
+    file.close();
+
+    if (file.fail())
+    {
+        // A version that was only partly written is dropped by load()
+        throw std::runtime_error("VersionStore::record: Failed to write file " + path);
+    }
+
+    versions.push_back(version);
+    validSize = version.offset + version.length;
+
+    return version.number;
+}
+
+/*
+    Find the version for an as-of argument.
+
+    @param asOf
+        A version number, or a date (YYYY-MM-DD) for the latest version
+        recorded on or before it
+
+    @return
+        The version
+
+    @throws
+        std::invalid_argument if asOf is neither a version number nor a date
+        std::out_of_range if there is no such version
+*/
+const BethYw::VersionStore::Version &BethYw::VersionStore::find(const std::string &asOf) const
+{
+    static const std::regex numberMatch("^[0-9]+$");
+    static const std::regex dateMatch("^[0-9]{4}-[0-9]{2}-[0-9]{2}$");
+
+    if (std::regex_match(asOf, dateMatch))
+    {
+        // Versions are recorded in order, so their dates only go forward
+        for (auto it = versions.rbegin(); it != versions.rend(); ++it)
+        {
+            if (it->date <= asOf)
+            {
+                return *it;
+            }
+        }
+
+        throw std::out_of_range("No version was recorded as of " + asOf);
+    }
+
+    if (!std::regex_match(asOf, numberMatch))
+    {
+        throw std::invalid_argument("Invalid input for as-of argument");
+    }
+
+    if (asOf.size() > 9 || std::stoul(asOf) == 0 || std::stoul(asOf) > versions.size())
+    {
+        throw std::out_of_range("No version " + asOf + " was recorded");
+    }
+
+    return versions[std::stoul(asOf) - 1];
+}
+
+/*
+    Reconstruct a version of the data by replaying the latest keyframe at or
+    before it and the changes of the versions after that keyframe up to it,
+    which reads at most VERSION_KEYFRAME_INTERVAL versions.
+
+    @param areas
+        An empty Areas instance to reconstruct the version into
+
+    @param asOf
+        A version number, or a date (YYYY-MM-DD) for the latest version
+        recorded on or before it
+
+    @return
+        The number of the version reconstructed
+
+    @throws
+        std::invalid_argument if asOf is neither a version number nor a date
+        std::out_of_range if there is no such version
+        std::runtime_error if the store file cannot be read
+*/
+const uint32_t BethYw::VersionStore::reconstruct(Areas &areas, const std::string &asOf) const
+{
+    const Version &target = find(asOf);
+
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+    {
+        throw std::runtime_error("VersionStore::reconstruct: Failed to open file " + path);
+    }
+
+    size_t first = target.number - 1;
+
+    while (first > 0 && !versions[first].keyframe)
+    {
+        first--;
+    }
+
+    Flat flat;
+    std::string body;
+
+    for (size_t i = first; i < target.number; i++)
+    {
+        const Version &version = versions[i];
+        body.resize((size_t)version.length);
+        file.seekg((std::streamoff)version.offset);
+
+        if (!body.empty() && !file.read(&body[0], body.size()))
+        {
+            throw std::runtime_error("VersionStore::reconstruct: Failed to read file " + path);
+        }
+
+        MemoryBuffer buffer(body.data(), body.size());
+        std::istream records(&buffer);
+
+        for (uint32_t record = 0; record < version.records; record++)
+        {
+            applyRecord(records, flat);
+        }
+    }
+
+    unflatten(flat, areas);
+    return target.number;
+}
+
+/*
+    Retrieve the number of versions in the store.
+
+    @return
+        The number of versions
+*/
+const size_t BethYw::VersionStore::size() const noexcept
+{
+    return versions.size();
+}
+
+/*
+    Retrieve the number of keys a version added, changed or removed since
+    the version before it, e.g. to check that only what changed was
+    recorded. A keyframe stores every key, but this is still its number of
+    changes.
+
+    @param number
+        The version number
+
+    @return
+        The number of changes
+
+    @throws
+        std::out_of_range if there is no such version
+*/
+const uint32_t BethYw::VersionStore::getChangeCount(const uint32_t number) const
+{
+    if (number == 0 || number > versions.size())
+    {
+        throw std::out_of_range("No version " + std::to_string(number) + " was recorded");
+    }
+
+    return versions[number - 1].changes;
+}
+
+/*
+    Check whether a version was stored whole, as a keyframe, rather than as
+    its changes.
+
+    @param number
+        The version number
+
+    @return
+        true if the version is a keyframe
+
+    @throws
+        std::out_of_range if there is no such version
+*/
+const bool BethYw::VersionStore::isKeyframe(const uint32_t number) const
+{
+    if (number == 0 || number > versions.size())
+    {
+        throw std::out_of_range("No version " + std::to_string(number) + " was recorded");
+    }
+
+    return versions[number - 1].keyframe;
+}
+
+/*
+    Retrieve today's date (UTC), for recording a version.
+
+    @return
+        The date as YYYY-MM-DD
+*/
+const std::string BethYw::VersionStore::today() noexcept
+{
+    const std::time_t now = std::time(nullptr);
+    char date[11] = "";
+    std::strftime(date, sizeof(date), "%Y-%m-%d", std::gmtime(&now));
+    return date;
+}
@@ -0,0 +1,98 @@
+#ifndef VERSIONS_H_
+#define VERSIONS_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for keeping every version of the data
+    imported, so a past version can be output again after the datasets have
+    been revised (e.g. what was reported using the data as of a past date).
+
+    A VersionStore is a file of numbered, dated versions. Each version is
+    stored as the changes from the version before it, one record for each
+    key that was added, changed or removed, where the keys are:
+
+        an area
+        a name of an area, in one language
+        a measure of an area, with its label
+        a value of a measure of an area, in one year
+
+    Recording a version after an import (--versions) compares the data
+    imported with the latest version, and appends a version with the changes
+    only if there are any, so the file grows with the revisions, not the
+    size of the data. Every VERSION_KEYFRAME_INTERVAL versions, starting
+    with the first, a keyframe is stored instead: the whole data, as records
+    that add every key. Any version can be reconstructed (--as-of) by
+    replaying the keyframe at or before it and the changes of the versions
+    after the keyframe, without importing the datasets, so neither
+    reconstructing nor recording reads more than VERSION_KEYFRAME_INTERVAL
+    versions however long the store grows.
+
+    Recording holds an exclusive lock on the store file (flock(), on POSIX
+    systems) while it reads the versions and appends the new one, so runs
+    recording into the same store at once each append a version in turn.
+
+    A store is for one import, i.e. one set of datasets and filters (see
+    sharedSegmentKey()), so it is not mixed with the data of another.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+
+namespace BethYw
+{
+    const uint32_t VERSION_STORE_FORMAT_VERSION = 2;
+
+    // How often a version is stored whole rather than as its changes
+    const uint32_t VERSION_KEYFRAME_INTERVAL = 16;
+
+    class VersionStore
+    {
+    private:
+        /*
+            The header of a version in the store file.
+        */
+        struct Version
+        {
+            uint32_t number;
+            std::string date;
+            bool keyframe;
+            uint32_t changes;
+            uint32_t records;
+            uint64_t offset;
+            uint64_t length;
+        };
+
+        std::string path;
+        std::string key;
+        std::vector<Version> versions;
+
+        // The size of the store file up to the end of the last complete
+        // version, so a version that was only partly written is dropped
+        uint64_t validSize = 0;
+
+        const Version &find(const std::string &asOf) const;
+
+    public:
+        VersionStore(const std::string &path, const std::string &key);
+
+        void load();
+        const uint32_t record(const Areas &areas, const std::string &date);
+        const uint32_t reconstruct(Areas &areas, const std::string &asOf) const;
+
+        const size_t size() const noexcept;
+        const uint32_t getChangeCount(const uint32_t number) const;
+        const bool isKeyframe(const uint32_t number) const;
+
+        static const std::string today() noexcept;
+    };
+}
+
+#endif // VERSIONS_H_
@@ -0,0 +1,579 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the compiler and evaluator of the --where expressions.
+*/
+
+#include <cctype>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "bethyw.h"
+#include "where.h"
+
+namespace BethYw
+{
+    /*
+        A recursive descent parser for where expressions, which appends the
+        postfix program of an expression to a RowPredicate:
+
+            or         := and ("or" and)*
+            and        := not ("and" not)*
+            not        := "not" not | "(" or ")" | comparison
+            comparison := ("value" | "year") operator number
+                        | ("value" | "year") "between" number "and" number
+                        | "measure" ("=" | "!=") code
+    */
+    class WhereParser
+    {
+    private:
+        std::vector<std::string> tokens;
+        size_t position = 0;
+        RowPredicate &predicate;
+
+        [[noreturn]] static void fail()
+        {
+            throw std::invalid_argument("Invalid input for where argument");
+        }
+
+        /*
+            Split an expression into words, numbers, quoted codes, operators
+            and brackets. Words are converted to lowercase.
+        */
+        static std::vector<std::string> tokenise(const std::string &expression)
+        {
+            std::vector<std::string> tokens;
+            size_t i = 0;
+
+            while (i < expression.size())
+            {
+                const char c = expression[i];
+
+                if (std::isspace((unsigned char)c))
+                {
+                    i++;
+                }
+                else if (c == '(' || c == ')')
+                {
+                    tokens.push_back(std::string(1, c));
+                    i++;
+                }
+                else if (c == '<' || c == '>' || c == '=' || c == '!')
+                {
+                    size_t end = i + 1;
+                    if (end < expression.size() && expression[end] == '=')
+                    {
+                        end++;
+                    }
+
+                    tokens.push_back(expression.substr(i, end - i));
+                    i = end;
+                }
+                else if (c == '\'' || c == '"')
+                {
+                    const size_t end = expression.find(c, i + 1);
+                    if (end == std::string::npos)
+                    {
+                        fail();
+                    }
+
+                    // Keep the opening quote to mark a quoted code
+                    tokens.push_back(expression.substr(i, end - i));
+                    i = end + 1;
+                }
+                else
+                {
+                    size_t end = i;
+                    while (end < expression.size() && !std::isspace((unsigned char)expression[end])
+                           && std::string("()<>=!'\"").find(expression[end]) == std::string::npos)
+                    {
+                        end++;
+                    }
+
+                    std::string word = expression.substr(i, end - i);
+                    stringToLower(word);
+                    tokens.push_back(word);
+                    i = end;
+                }
+            }
+
+            return tokens;
+        }
+
+        const bool atEnd() const noexcept
+        {
+            return position >= tokens.size();
+        }
+
+        const std::string &peek() const
+        {
+            if (atEnd())
+            {
+                fail();
+            }
+
+            return tokens[position];
+        }
+
+        const std::string &take()
+        {
+            const std::string &token = peek();
+            position++;
+            return token;
+        }
+
+        bool accept(const std::string &token)
+        {
+            if (!atEnd() && tokens[position] == token)
+            {
+                position++;
+                return true;
+            }
+
+            return false;
+        }
+
+        void emit(const RowPredicate::Operation operation,
+                  const RowPredicate::Comparison comparison = RowPredicate::Equal,
+                  const double number = 0,
+                  const std::string &text = "")
+        {
+            predicate.program.push_back({operation, comparison, number, text});
+        }
+
+        /*
+            Parse a number, which may end in k (thousands) or m (millions).
+        */
+        double number()
+        {
+            std::string token = take();
+            double multiplier = 1;
+
+            if (!token.empty() && (token.back() == 'k' || token.back() == 'm'))
+            {
+                multiplier = token.back() == 'k' ? 1e3 : 1e6;
+                token.pop_back();
+            }
+
+            char *end = nullptr;
+            const double value = std::strtod(token.c_str(), &end);
+
+            if (token.empty() || *end != '\0')
+            {
+                fail();
+            }
+
+            return value * multiplier;
+        }
+
+        RowPredicate::Comparison comparison()
+        {
+            const std::string &token = take();
+
+            if (token == "<")
+            {
+                return RowPredicate::Less;
+            }
+            if (token == "<=")
+            {
+                return RowPredicate::LessEqual;
+            }
+            if (token == ">")
+            {
+                return RowPredicate::Greater;
+            }
+            if (token == ">=")
+            {
+                return RowPredicate::GreaterEqual;
+            }
+            if (token == "=" || token == "==")
+            {
+                return RowPredicate::Equal;
+            }
+            if (token == "!=")
+            {
+                return RowPredicate::NotEqual;
+            }
+
+            fail();
+        }
+
+        void parseComparison()
+        {
+            const std::string field = take();
+
+            if (field == "measure")
+            {
+                const RowPredicate::Comparison op = comparison();
+                std::string code = take();
+
+                if ((op != RowPredicate::Equal && op != RowPredicate::NotEqual) || code.empty()
+                    || code == "(" || code == ")")
+                {
+                    fail();
+                }
+
+                if (code[0] == '\'' || code[0] == '"')
+                {
+                    code.erase(0, 1);
+                    stringToLower(code);
+                }
+
+                emit(RowPredicate::CompareMeasure, op, 0, code);
+                return;
+            }
+
+            if (field != "value" && field != "year")
+            {
+                fail();
+            }
+
+            const RowPredicate::Operation operation = field == "value" ? RowPredicate::CompareValue
+                                                                       : RowPredicate::CompareYear;
+
+            if (accept("between"))
+            {
+                const double low = number();
+                if (!accept("and"))
+                {
+                    fail();
+                }
+                const double high = number();
+
+                emit(operation, RowPredicate::GreaterEqual, low);
+                emit(operation, RowPredicate::LessEqual, high);
+                emit(RowPredicate::And);
+                return;
+            }
+
+            const RowPredicate::Comparison op = comparison();
+            emit(operation, op, number());
+        }
+
+        void parseNot()
+        {
+            if (accept("not"))
+            {
+                parseNot();
+                emit(RowPredicate::Not);
+            }
+            else if (accept("("))
+            {
+                parseOr();
+                if (!accept(")"))
+                {
+                    fail();
+                }
+            }
+            else
+            {
+                parseComparison();
+            }
+        }
+
+        void parseAnd()
+        {
+            parseNot();
+            while (accept("and"))
+            {
+                parseNot();
+                emit(RowPredicate::And);
+            }
+        }
+
+        void parseOr()
+        {
+            parseAnd();
+            while (accept("or"))
+            {
+                parseAnd();
+                emit(RowPredicate::Or);
+            }
+        }
+
+    public:
+        WhereParser(const std::string &expression, RowPredicate &predicate)
+            : tokens(tokenise(expression)), predicate(predicate)
+        {
+        }
+
+        void parse()
+        {
+            parseOr();
+
+            if (!atEnd())
+            {
+                fail();
+            }
+        }
+    };
+}
+
+/*
+    Construct an empty predicate, which matches every row.
+*/
+BethYw::RowPredicate::RowPredicate()
+{
+}
+
+/*
+    Compile a where expression (see where.h).
+
+    @param expression
+        The expression
+
+    @throws
+        std::invalid_argument if the expression is not valid with the
+        message: Invalid input for where argument
+*/
+BethYw::RowPredicate::RowPredicate(const std::string &expression)
+    : source(expression)
+{
+    WhereParser(expression, *this).parse();
+}
+
+/*
+    Check whether the predicate has no program, i.e. it matches every row.
+
+    @return
+        true if the predicate is empty
+*/
+const bool BethYw::RowPredicate::empty() const noexcept
+{
+    return program.empty();
+}
+
+/*
+    Retrieve the expression the predicate was compiled from.
+
+    @return
+        The expression, or an empty string for an empty predicate
+*/
+const std::string &BethYw::RowPredicate::getSource() const noexcept
+{
+    return source;
+}
+
+/*
+    Compare two numbers.
+*/
+bool BethYw::RowPredicate::compare(const Comparison comparison, const double lhs, const double rhs) noexcept
+{
+    switch (comparison)
+    {
+        case Less:
+            return lhs < rhs;
+        case LessEqual:
+            return lhs <= rhs;
+        case Greater:
+            return lhs > rhs;
+        case GreaterEqual:
+            return lhs >= rhs;
+        case Equal:
+            return lhs == rhs;
+        default:
+            return lhs != rhs;
+    }
+}
+
+/*
+    Evaluate the predicate for a single row.
+
+    @param measureCode
+        The lowercase measure code of the row
+
+    @param year
+        The year of the row
+
+    @param value
+        The value of the row
+
+    @return
+        true if the row matches
+*/
+const bool BethYw::RowPredicate::matches(const std::string &measureCode, const unsigned int year,
+                                         const double value) const
+{
+    std::vector<bool> stack;
+
+    for (auto &instruction : program)
+    {
+        if (instruction.operation == And || instruction.operation == Or)
+        {
+            const bool rhs = stack.back();
+            stack.pop_back();
+            stack.back() = instruction.operation == And ? stack.back() && rhs : stack.back() || rhs;
+        }
+        else if (instruction.operation == Not)
+        {
+            stack.back() = !stack.back();
+        }
+        else if (instruction.operation == CompareMeasure)
+        {
+            stack.push_back((measureCode == instruction.text) == (instruction.comparison == Equal));
+        }
+        else
+        {
+            const double lhs = instruction.operation == CompareValue ? value : year;
+            stack.push_back(compare(instruction.comparison, lhs, instruction.number));
+        }
+    }
+
+    return stack.empty() || stack.back();
+}
+
+/*
+    Evaluate the predicate for every row of a batch. Each instruction is run
+    over all the rows before the next, with a mask of results for each
+    value on the program's stack. Rows without a measure or year are
+    evaluated too, but their results are meaningless.
+
+    @param batch
+        The batch
+
+    @param mask
+        Set to 1 for each row that matches and 0 for each row that doesn't
+
+    @return
+        void
+*/
+void BethYw::RowPredicate::evaluate(const RowBatch &batch, std::vector<uint8_t> &mask) const
+{
+    const size_t rows = batch.size();
+    std::vector<std::vector<uint8_t>> stack;
+
+    for (auto &instruction : program)
+    {
+        if (instruction.operation == And || instruction.operation == Or || instruction.operation == Not)
+        {
+            uint8_t *lhs = stack[stack.size() - (instruction.operation == Not ? 1 : 2)].data();
+            const uint8_t *rhs = stack.back().data();
+
+            if (instruction.operation == And)
+            {
+                for (size_t i = 0; i < rows; i++)
+                {
+                    lhs[i] &= rhs[i];
+                }
+            }
+            else if (instruction.operation == Or)
+            {
+                for (size_t i = 0; i < rows; i++)
+                {
+                    lhs[i] |= rhs[i];
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < rows; i++)
+                {
+                    lhs[i] ^= 1;
+                }
+            }
+
+            if (instruction.operation != Not)
+            {
+                stack.pop_back();
+            }
+
+            continue;
+        }
+
+        stack.emplace_back(rows);
+        uint8_t *result = stack.back().data();
+
+        if (instruction.operation == CompareMeasure)
+        {
+            // Compare each measure in the batch's dictionary once
+            std::vector<uint8_t> measures(batch.measureCodes.size());
+            for (size_t id = 0; id < measures.size(); id++)
+            {
+                measures[id] = (batch.measureCodes[id] == instruction.text) == (instruction.comparison == Equal);
+            }
+
+            for (size_t i = 0; i < rows; i++)
+            {
+                const uint32_t id = batch.measureIds[i];
+                result[i] = id != RowBatch::NO_MEASURE && measures[id];
+            }
+
+            continue;
+        }
+
+        const double number = instruction.number;
+        auto compareColumn = [&](auto column) {
+            switch (instruction.comparison)
+            {
+                case Less:
+                    for (size_t i = 0; i < rows; i++) result[i] = column[i] < number;
+                    break;
+                case LessEqual:
+                    for (size_t i = 0; i < rows; i++) result[i] = column[i] <= number;
+                    break;
+                case Greater:
+                    for (size_t i = 0; i < rows; i++) result[i] = column[i] > number;
+                    break;
+                case GreaterEqual:
+                    for (size_t i = 0; i < rows; i++) result[i] = column[i] >= number;
+                    break;
+                case Equal:
+                    for (size_t i = 0; i < rows; i++) result[i] = column[i] == number;
+                    break;
+                default:
+                    for (size_t i = 0; i < rows; i++) result[i] = column[i] != number;
+                    break;
+            }
+        };
+
+        if (instruction.operation == CompareValue)
+        {
+            compareColumn(batch.values.data());
+        }
+        else
+        {
+            compareColumn(batch.years.data());
+        }
+    }
+
+    if (stack.empty())
+    {
+        mask.assign(rows, 1);
+    }
+    else
+    {
+        mask = std::move(stack.back());
+    }
+}
+
+/*
+    Remove the value of every row of a batch that does not match, leaving
+    the row to create its Area and Measure (see RowBatch::NO_YEAR).
+
+    @param batch
+        The batch
+
+    @return
+        void
+*/
+void BethYw::RowPredicate::apply(RowBatch &batch) const
+{
+    if (program.empty())
+    {
+        return;
+    }
+
+    std::vector<uint8_t> mask;
+    evaluate(batch, mask);
+
+    for (size_t i = 0; i < mask.size(); i++)
+    {
+        if (!mask[i] && batch.measureIds[i] != RowBatch::NO_MEASURE)
+        {
+            batch.years[i] = RowBatch::NO_YEAR;
+        }
+    }
+}
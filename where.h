@@ -0,0 +1,86 @@
+#ifndef WHERE_H_
+#define WHERE_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains declarations for the --where expressions, which filter
+    rows on their value, year and measure code as they are imported, e.g.
+
+        value > 40 and measure = no2
+        value between 50k and 100k or year >= 2015
+
+    An expression is made of comparisons of value, year or measure against a
+    number (which may end in k or m for thousands or millions) or a measure
+    code, combined with and, or, not and brackets. "between a and b" is
+    inclusive. Measure codes can only be compared with = and !=, and are
+    compared case-insensitively.
+
+    An expression is compiled once into a RowPredicate, a postfix program
+    which is evaluated over a whole RowBatch at a time: each instruction
+    runs over every row in a simple loop before the next instruction starts,
+    so the loops can be vectorised. A row that does not match keeps its
+    Area and Measure but loses its value, as with the years filter.
+*/
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "areas.h"
+
+namespace BethYw
+{
+    class RowPredicate
+    {
+    private:
+        enum Operation
+        {
+            CompareValue,
+            CompareYear,
+            CompareMeasure,
+            And,
+            Or,
+            Not
+        };
+
+        enum Comparison
+        {
+            Less,
+            LessEqual,
+            Greater,
+            GreaterEqual,
+            Equal,
+            NotEqual
+        };
+
+        struct Instruction
+        {
+            Operation operation;
+            Comparison comparison;
+            double number;
+            std::string text;
+        };
+
+        std::vector<Instruction> program;
+        std::string source;
+
+        friend class WhereParser;
+        static bool compare(const Comparison comparison, const double lhs, const double rhs) noexcept;
+
+    public:
+        RowPredicate();
+        RowPredicate(const std::string &expression);
+        const bool empty() const noexcept;
+        const std::string &getSource() const noexcept;
+        const bool matches(const std::string &measureCode, const unsigned int year, const double value) const;
+        void evaluate(const RowBatch &batch, std::vector<uint8_t> &mask) const;
+        void apply(RowBatch &batch) const;
+    };
+}
+
+#endif // WHERE_H_
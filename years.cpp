@@ -0,0 +1,233 @@
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the implementation of the YearFilter class.
+*/
+
+#include <algorithm>
+#include <regex>
+#include <stdexcept>
+
+#include "years.h"
+
+/*
+    Construct a filter that matches every year.
+*/
+BethYw::YearFilter::YearFilter()
+    : YearFilterTuple(0, 0)
+{
+}
+
+/*
+    Construct a filter from a single inclusive range, where a null pointer or
+    a range of <0,0> matches every year. The bounds may be in either order.
+
+    @param range
+        A pointer to the range, which may be null
+*/
+BethYw::YearFilter::YearFilter(const YearFilterTuple *const range)
+    : YearFilterTuple(0, 0)
+{
+    if (range != nullptr && *range != YearFilterTuple{0, 0})
+    {
+        ranges.emplace_back(std::min(std::get<0>(*range), std::get<1>(*range)),
+                            std::max(std::get<0>(*range), std::get<1>(*range)));
+    }
+
+    compile();
+}
+
+/*
+    Construct a filter from a list of inclusive ranges, where a single year
+    is a range with the same start and end. An empty list matches every year.
+
+    @param ranges
+        The ranges of years to import, in any order and possibly overlapping
+
+    @throws
+        std::invalid_argument if a range ends before it starts
+*/
+BethYw::YearFilter::YearFilter(std::vector<std::pair<unsigned int, unsigned int>> ranges)
+    : YearFilterTuple(0, 0), ranges(std::move(ranges))
+{
+    compile();
+}
+
+/*
+    Parse a list of years and ranges separated by commas, e.g.
+    "1991,2001,2011-2019". Each year has four digits. As with a single
+    range, a year of 0 (e.g. "0" or "0-0") means there is no filter.
+
+    @param input
+        The list to parse
+
+    @return
+        The filter
+
+    @throws
+        std::invalid_argument if the list is not valid, with the message:
+        Invalid input for years argument
+*/
+BethYw::YearFilter BethYw::YearFilter::parse(const std::string &input)
+{
+    static const std::regex itemMatch("^([0-9]{4}|0)(?:-([0-9]{4}|0))?$");
+
+    std::vector<std::pair<unsigned int, unsigned int>> ranges;
+    bool everyYear = false;
+    size_t start = 0;
+
+    while (true)
+    {
+        size_t end = input.find(',', start);
+
+        if (end == std::string::npos)
+        {
+            end = input.size();
+        }
+
+        const std::string item = input.substr(start, end - start);
+        std::smatch match;
+
+        if (!std::regex_match(item, match, itemMatch))
+        {
+            throw std::invalid_argument("Invalid input for years argument");
+        }
+
+        const unsigned int first = std::stoul(match[1]);
+        const unsigned int last = match[2].matched ? std::stoul(match[2]) : first;
+
+        if (first == 0 || last == 0)
+        {
+            everyYear = true;
+        }
+        else if (last < first)
+        {
+            throw std::invalid_argument("Invalid input for years argument");
+        }
+        else
+        {
+            ranges.emplace_back(first, last);
+        }
+
+        if (end == input.size())
+        {
+            break;
+        }
+
+        start = end + 1;
+    }
+
+    if (everyYear)
+    {
+        ranges.clear();
+    }
+
+    return YearFilter(std::move(ranges));
+}
+
+/*
+    Sort and merge the ranges, and set the bits of the years in them.
+
+    @return
+        void
+
+    @throws
+        std::invalid_argument if a range ends before it starts
+*/
+void BethYw::YearFilter::compile()
+{
+    if (ranges.empty())
+    {
+        std::get<0>(*this) = 0;
+        std::get<1>(*this) = 0;
+        span = 0;
+        bits.clear();
+        return;
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+
+    std::vector<std::pair<unsigned int, unsigned int>> merged;
+    for (const auto &range : ranges)
+    {
+        if (range.second < range.first)
+        {
+            throw std::invalid_argument("Invalid input for years argument");
+        }
+
+        if (!merged.empty() && range.first <= merged.back().second + 1)
+        {
+            merged.back().second = std::max(merged.back().second, range.second);
+        }
+        else
+        {
+            merged.push_back(range);
+        }
+    }
+
+    ranges = std::move(merged);
+
+    const unsigned int low = ranges.front().first;
+    const unsigned int high = ranges.back().second;
+    std::get<0>(*this) = low;
+    std::get<1>(*this) = high;
+    span = high - low + 1;
+    bits.assign((span + 63) / 64, 0);
+
+    for (const auto &range : ranges)
+    {
+        for (unsigned int year = range.first; year <= range.second; year++)
+        {
+            const unsigned int offset = year - low;
+            bits[offset >> 6] |= (uint64_t)1 << (offset & 63);
+        }
+    }
+}
+
+/*
+    Check whether the filter matches every year.
+
+    @return
+        true if there is no filter
+*/
+const bool BethYw::YearFilter::all() const noexcept
+{
+    return span == 0;
+}
+
+/*
+    Get the filter in the canonical form accepted by parse(), with the ranges
+    sorted and merged, e.g. to use as part of a cache key.
+
+    @return
+        The list of years and ranges, or "0" if the filter matches every year
+*/
+const std::string BethYw::YearFilter::toString() const
+{
+    if (all())
+    {
+        return "0";
+    }
+
+    std::string out;
+    for (const auto &range : ranges)
+    {
+        if (!out.empty())
+        {
+            out += ',';
+        }
+
+        out += std::to_string(range.first);
+
+        if (range.second != range.first)
+        {
+            out += '-' + std::to_string(range.second);
+        }
+    }
+
+    return out;
+}
@@ -0,0 +1,76 @@
+#ifndef YEARS_H_
+#define YEARS_H_
+
+/*
+    +---------------------------------------+
+    | BETH YW? WELSH GOVERNMENT DATA PARSER |
+    +---------------------------------------+
+
+    AUTHOR: 991368
+
+    This file contains the YearFilter class, which holds the years to import
+    as a list of years and inclusive ranges, e.g. for census comparisons:
+
+        1991,2001,2011-2019
+
+    The list is compiled once into a dense bitset over the years from the
+    lowest to the highest in the filter, so checking a year is a subtraction,
+    one comparison and a bit test.
+*/
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/*
+    An alias for a year filter of a single inclusive range, where <0,0> means
+    all years.
+*/
+using YearFilterTuple = std::tuple<unsigned int, unsigned int>;
+
+namespace BethYw
+{
+    /*
+        A set of years to import. A YearFilter is also the YearFilterTuple of
+        its lowest and highest year (or <0,0> if it matches every year), so
+        code that only needs the bounds can keep treating it as a tuple.
+    */
+    class YearFilter : public YearFilterTuple
+    {
+    private:
+        std::vector<std::pair<unsigned int, unsigned int>> ranges;
+        std::vector<uint64_t> bits;
+        unsigned int span = 0;
+
+        void compile();
+
+    public:
+        YearFilter();
+        explicit YearFilter(const YearFilterTuple *const range);
+        explicit YearFilter(std::vector<std::pair<unsigned int, unsigned int>> ranges);
+        static YearFilter parse(const std::string &input);
+
+        const bool all() const noexcept;
+        const std::string toString() const;
+
+        /*
+            Check whether a year is in the filter.
+
+            @param year
+                The year to check
+
+            @return
+                true if the filter matches every year or includes the year
+        */
+        const bool contains(const unsigned int year) const noexcept
+        {
+            // A year below the lowest wraps around to a large offset
+            const unsigned int offset = year - std::get<0>(*this);
+            return span == 0 || (offset < span && ((bits[offset >> 6] >> (offset & 63)) & 1));
+        }
+    };
+}
+
+#endif // YEARS_H_